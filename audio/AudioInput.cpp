@@ -5,63 +5,11 @@
 #include <QDebug>
 #include <QPermission>
 #include <QPermissions>
-#include <QtEndian>
 #include <cstring>
-#include <cmath>
 
 namespace {
-static QVector<qint16> toMonoInt16(const QByteArray& data, const QAudioFormat& format)
-{
-    const int channels = qMax(1, format.channelCount());
-    const int bytesPerSample = format.bytesPerSample();
-    if (bytesPerSample <= 0)
-        return {};
-
-    const int frameBytes = bytesPerSample * channels;
-    const int sampleCount = data.size() / frameBytes;
-    QVector<qint16> out;
-    out.reserve(sampleCount);
-
-    const char* ptr = data.constData();
-    for (int i = 0; i < sampleCount; ++i)
-    {
-        double sum = 0.0;
-        for (int ch = 0; ch < channels; ++ch)
-        {
-            const char* samplePtr = ptr + (i * channels + ch) * bytesPerSample;
-            switch (format.sampleFormat())
-            {
-            case QAudioFormat::Int16:
-                sum += qFromLittleEndian<qint16>(reinterpret_cast<const uchar*>(samplePtr));
-                break;
-            case QAudioFormat::Int32:
-                sum += static_cast<double>(qFromLittleEndian<qint32>(
-                    reinterpret_cast<const uchar*>(samplePtr))) / 65536.0;
-                break;
-            case QAudioFormat::Float:
-            {
-                float v = 0.0f;
-                std::memcpy(&v, samplePtr, sizeof(float));
-                sum += static_cast<double>(v) * 32767.0;
-                break;
-            }
-            case QAudioFormat::UInt8:
-                sum += (static_cast<int>(static_cast<unsigned char>(*samplePtr)) - 128) * 256;
-                break;
-            default:
-                break;
-            }
-        }
-
-        double v = sum / static_cast<double>(channels);
-        if (v > 32767.0)
-            v = 32767.0;
-        else if (v < -32768.0)
-            v = -32768.0;
-        out.append(static_cast<qint16>(qRound(v)));
-    }
-    return out;
-}
+// Frames a slow receiver may hold before capture falls back to allocating.
+static constexpr int kMaxFramePool = 8;
 
 static void applyGain(QVector<qint16>& samples, float gain)
 {
@@ -226,8 +174,7 @@ void AudioInput::setNoiseSuppressionEnabled(bool enabled)
     if (m_noiseSuppressionEnabled == enabled)
         return;
     m_noiseSuppressionEnabled = enabled;
-    m_noiseFloor = 0.0f;
-    m_noiseGateGain = 1.0f;
+    m_noiseSuppressor.reset();
     emit noiseSuppressionEnabledChanged();
 }
 
@@ -242,11 +189,26 @@ void AudioInput::setNoiseSuppressionLevel(int level)
     if (m_noiseSuppressionLevel == normalized)
         return;
     m_noiseSuppressionLevel = normalized;
+    m_noiseSuppressor.setLevel(m_noiseSuppressionLevel);
     if (m_noiseSuppressionLevel <= 0)
-        m_noiseGateGain = 1.0f;
+        m_noiseSuppressor.reset();
     emit noiseSuppressionLevelChanged();
 }
 
+bool AudioInput::voiceActivityDetectionEnabled() const
+{
+    return m_voiceActivityDetectionEnabled;
+}
+
+void AudioInput::setVoiceActivityDetectionEnabled(bool enabled)
+{
+    if (m_voiceActivityDetectionEnabled == enabled)
+        return;
+    m_voiceActivityDetectionEnabled = enabled;
+    m_vad.reset();
+    emit voiceActivityDetectionEnabledChanged();
+}
+
 void AudioInput::start()
 {
     m_wantRunning = true;
@@ -313,10 +275,12 @@ void AudioInput::start()
 
     m_resampler.setRates(m_deviceFormat.sampleRate(), m_format.sampleRate());
     m_resampler.reset();
-    m_deviceBuffer.clear();
-    m_buffer.clear();
-    m_noiseFloor = 0.0f;
-    m_noiseGateGain = 1.0f;
+    m_converter.setFormat(m_deviceFormat);
+    m_deviceBufferedBytes = 0;
+    m_captureRing.clear();
+    m_captureRing.reserve(qMax(1, m_frameBytes / static_cast<int>(sizeof(qint16))) * 4);
+    m_noiseSuppressor.reset();
+    m_vad.reset();
 
     m_source = new QAudioSource(device, m_deviceFormat, this);
     m_activeInputDeviceId = encodeDeviceId(device.id());
@@ -384,39 +348,100 @@ void AudioInput::onReadyRead()
     if (!m_device || m_frameBytes <= 0)
         return;
 
-    m_deviceBuffer.append(m_device->readAll());
-
-    const int bytesPerSample = m_deviceFormat.bytesPerSample();
-    const int channels = qMax(1, m_deviceFormat.channelCount());
-    const int frameBytes = bytesPerSample * channels;
+    const int frameBytes = m_converter.bytesPerFrame();
     if (frameBytes <= 0)
+    {
+        m_device->readAll();
         return;
+    }
+
+    // m_deviceBuffer is a fixed read window; only a partial device frame
+    // is carried over between reads.
+    if (m_deviceBuffer.size() < frameBytes * 2)
+        m_deviceBuffer.resize(qMax(4096, frameBytes * 256));
 
-    const int usableBytes = (m_deviceBuffer.size() / frameBytes) * frameBytes;
-    if (usableBytes <= 0)
+    for (;;)
+    {
+        const qint64 got = m_device->read(m_deviceBuffer.data() + m_deviceBufferedBytes,
+                                          m_deviceBuffer.size() - m_deviceBufferedBytes);
+        if (got <= 0)
+            break;
+        m_deviceBufferedBytes += static_cast<int>(got);
+
+        const int frames = m_deviceBufferedBytes / frameBytes;
+        if (frames <= 0)
+            continue;
+
+        if (m_monoScratch.size() < frames)
+            m_monoScratch.resize(frames);
+        const int consumedBytes = frames * frameBytes;
+        m_converter.toMono(QSpan<const char>(m_deviceBuffer.constData(), consumedBytes),
+                           QSpan<qint16>(m_monoScratch.data(), frames));
+        m_deviceBufferedBytes -= consumedBytes;
+        if (m_deviceBufferedBytes > 0)
+            std::memmove(m_deviceBuffer.data(),
+                         m_deviceBuffer.constData() + consumedBytes,
+                         static_cast<size_t>(m_deviceBufferedBytes));
+
+        processCapturedSamples(QSpan<const qint16>(m_monoScratch.constData(), frames));
+    }
+}
+
+void AudioInput::processCapturedSamples(QSpan<const qint16> mono)
+{
+    m_resampled.clear();
+    m_resampler.push(mono, m_resampled);
+    if (m_resampled.isEmpty())
         return;
 
-    const QByteArray raw = m_deviceBuffer.left(usableBytes);
-    m_deviceBuffer.remove(0, usableBytes);
+    applyNoiseSuppression(m_resampled);
+    const float gain = static_cast<float>(m_inputGainPercent) / 100.0f;
+    applyGain(m_resampled, gain);
+    m_captureRing.write(m_resampled);
 
-    const QVector<qint16> mono = toMonoInt16(raw, m_deviceFormat);
-    QVector<qint16> resampled;
-    m_resampler.push(mono, resampled);
-    if (!resampled.isEmpty())
+    const int frameSamples = m_frameBytes / static_cast<int>(sizeof(qint16));
+    if (m_voiceActivityDetectionEnabled)
+        m_vad.configure(m_sampleRate, frameSamples);
+    while (frameSamples > 0 && m_captureRing.size() >= frameSamples)
     {
-        applyNoiseSuppression(resampled);
-        const float gain = static_cast<float>(m_inputGainPercent) / 100.0f;
-        applyGain(resampled, gain);
-        m_buffer.append(reinterpret_cast<const char*>(resampled.constData()),
-                        resampled.size() * static_cast<int>(sizeof(qint16)));
+        const int slot = acquireFrameSlot();
+        const QSpan<qint16> samples(reinterpret_cast<qint16*>(m_framePool[slot].data()), frameSamples);
+        m_captureRing.read(samples);
+        const bool speech = !m_voiceActivityDetectionEnabled || m_vad.process(samples);
+        const QByteArray frame = m_framePool.at(slot);
+        emit frameReady(frame, speech);
     }
+}
 
-    while (m_buffer.size() >= m_frameBytes)
+int AudioInput::acquireFrameSlot()
+{
+    // Frames are handed out from a small pool. A slot is reused once every
+    // receiver has dropped its reference, so steady-state capture does not
+    // allocate; a receiver that holds on to frames just grows the pool.
+    const int poolSize = m_framePool.size();
+    for (int i = 0; i < poolSize; ++i)
     {
-        const QByteArray frame = m_buffer.left(m_frameBytes);
-        m_buffer.remove(0, m_frameBytes);
-        emit frameReady(frame);
+        const int slot = (m_framePoolNext + i) % poolSize;
+        QByteArray& frame = m_framePool[slot];
+        if (!frame.isDetached())
+            continue;
+        if (frame.size() != m_frameBytes)
+            frame.resize(m_frameBytes);
+        m_framePoolNext = (slot + 1) % poolSize;
+        return slot;
     }
+
+    if (poolSize < kMaxFramePool)
+    {
+        m_framePool.append(QByteArray(m_frameBytes, Qt::Uninitialized));
+        m_framePoolNext = 0;
+        return poolSize;
+    }
+
+    const int slot = m_framePoolNext;
+    m_framePool[slot] = QByteArray(m_frameBytes, Qt::Uninitialized);
+    m_framePoolNext = (slot + 1) % poolSize;
+    return slot;
 }
 
 void AudioInput::updateFormat()
@@ -426,6 +451,8 @@ void AudioInput::updateFormat()
     format.setChannelCount(1);
     format.setSampleFormat(QAudioFormat::Int16);
     m_format = format;
+    m_noiseSuppressor.configure(m_sampleRate);
+    m_noiseSuppressor.setLevel(m_noiseSuppressionLevel);
 
     const int bytesPerSample = m_format.bytesPerSample();
     if (bytesPerSample > 0)
@@ -454,12 +481,11 @@ void AudioInput::clearSource()
         m_source->deleteLater();
         m_source = nullptr;
     }
-    m_deviceBuffer.clear();
-    m_buffer.clear();
+    m_deviceBufferedBytes = 0;
+    m_captureRing.clear();
     m_activeInputDeviceId.clear();
     m_resampler.reset();
-    m_noiseFloor = 0.0f;
-    m_noiseGateGain = 1.0f;
+    m_noiseSuppressor.reset();
 }
 
 void AudioInput::scheduleRestart(int delayMs)
@@ -583,69 +609,8 @@ QByteArray AudioInput::decodeDeviceId(const QString& encodedId)
 
 void AudioInput::applyNoiseSuppression(QVector<qint16>& samples)
 {
-    if (samples.isEmpty())
-        return;
-
-    if (!m_noiseSuppressionEnabled || m_noiseSuppressionLevel <= 0)
-    {
-        m_noiseGateGain = 1.0f;
-        return;
-    }
-
-    double energy = 0.0;
-    float peakAbs = 0.0f;
-    for (const qint16 s : samples)
-    {
-        const float v = static_cast<float>(s);
-        const float a = std::fabs(v);
-        if (a > peakAbs)
-            peakAbs = a;
-        energy += static_cast<double>(v) * static_cast<double>(v);
-    }
-    const float rms = static_cast<float>(std::sqrt(energy / static_cast<double>(samples.size())));
-    if (m_noiseFloor < 1.0f)
-        m_noiseFloor = qMax(8.0f, rms * 0.8f);
-
-    const bool likelyNoiseOnly = (rms < m_noiseFloor * 1.8f) && (peakAbs < 4000.0f);
-    const float floorRise = likelyNoiseOnly ? 0.20f : 0.01f;
-    const float floorFall = likelyNoiseOnly ? 0.02f : 0.005f;
-    if (rms > m_noiseFloor)
-        m_noiseFloor += (rms - m_noiseFloor) * floorRise;
-    else
-        m_noiseFloor += (rms - m_noiseFloor) * floorFall;
-    m_noiseFloor = qBound(6.0f, m_noiseFloor, 9000.0f);
-
-    const float snr = rms / qMax(1.0f, m_noiseFloor);
-    const float strength = static_cast<float>(m_noiseSuppressionLevel) / 100.0f;
-    const float gateStart = 1.2f + 0.8f * strength;
-    const float gateFull = gateStart + 1.8f;
-    const float minGain = 1.0f - 0.92f * strength;
-
-    float targetGain = 1.0f;
-    if (snr <= gateStart)
-    {
-        targetGain = minGain;
-    }
-    else if (snr < gateFull)
-    {
-        const float t = (snr - gateStart) / (gateFull - gateStart);
-        targetGain = minGain + (1.0f - minGain) * t;
-    }
-
-    const float attack = 0.45f;
-    const float release = 0.08f;
-    if (targetGain < m_noiseGateGain)
-        m_noiseGateGain += (targetGain - m_noiseGateGain) * attack;
-    else
-        m_noiseGateGain += (targetGain - m_noiseGateGain) * release;
-
-    const float finalGain = qBound(0.03f, m_noiseGateGain, 1.0f);
-    if (finalGain >= 0.999f)
+    if (samples.isEmpty() || !m_noiseSuppressionEnabled || m_noiseSuppressionLevel <= 0)
         return;
 
-    for (qint16& s : samples)
-    {
-        const float scaled = static_cast<float>(s) * finalGain;
-        s = static_cast<qint16>(qBound(-32768, qRound(scaled), 32767));
-    }
+    m_noiseSuppressor.process(samples);
 }
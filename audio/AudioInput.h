@@ -8,10 +8,15 @@
 #include <QAudio>
 #include <QMediaDevices>
 #include <QIODevice>
+#include <QSpan>
 #include <QStringList>
 #include <QTimer>
 
 #include "audio/AudioResampler.h"
+#include "audio/NoiseSuppressor.h"
+#include "audio/SampleFormatConverter.h"
+#include "audio/SampleRing.h"
+#include "audio/VoiceActivityDetector.h"
 
 class AudioInput : public QObject
 {
@@ -50,6 +55,10 @@ class AudioInput : public QObject
                READ noiseSuppressionLevel
                WRITE setNoiseSuppressionLevel
                NOTIFY noiseSuppressionLevelChanged)
+    Q_PROPERTY(bool voiceActivityDetectionEnabled
+               READ voiceActivityDetectionEnabled
+               WRITE setVoiceActivityDetectionEnabled
+               NOTIFY voiceActivityDetectionEnabledChanged)
 
 public:
     explicit AudioInput(QObject* parent = nullptr);
@@ -73,6 +82,8 @@ public:
     void setNoiseSuppressionEnabled(bool enabled);
     int noiseSuppressionLevel() const;
     void setNoiseSuppressionLevel(int level);
+    bool voiceActivityDetectionEnabled() const;
+    void setVoiceActivityDetectionEnabled(bool enabled);
 
 public slots:
     void start();
@@ -80,7 +91,9 @@ public slots:
     void restartForRouteChange();
 
 signals:
-    void frameReady(const QByteArray& pcmFrame);
+    // speech is false for frames the VAD classified as silence; it is
+    // always true while voice activity detection is disabled.
+    void frameReady(const QByteArray& pcmFrame, bool speech);
     void frameBytesChanged();
     void intervalMsChanged();
     void sampleRateChanged();
@@ -90,6 +103,7 @@ signals:
     void selectedInputDeviceIdChanged();
     void noiseSuppressionEnabledChanged();
     void noiseSuppressionLevelChanged();
+    void voiceActivityDetectionEnabledChanged();
 
 private slots:
     void onReadyRead();
@@ -105,18 +119,28 @@ private:
     static QString encodeDeviceId(const QByteArray& rawId);
     static QByteArray decodeDeviceId(const QString& encodedId);
     void applyNoiseSuppression(QVector<qint16>& samples);
+    void processCapturedSamples(QSpan<const qint16> mono);
+    int acquireFrameSlot();
 
     QAudioSource* m_source = nullptr;
     QIODevice* m_device = nullptr;
     QAudioFormat m_format;
     QAudioFormat m_deviceFormat;
     QByteArray m_deviceBuffer;
-    QByteArray m_buffer;
+    int m_deviceBufferedBytes = 0;
+    SampleRing m_captureRing;
+    QVector<qint16> m_resampled;
+    QVector<QByteArray> m_framePool;
+    int m_framePoolNext = 0;
     QStringList m_inputDeviceNames;
     QStringList m_inputDeviceIds;
     QString m_selectedInputDeviceId;
     QString m_activeInputDeviceId;
     AudioResampler m_resampler;
+    SampleFormatConverter m_converter;
+    NoiseSuppressor m_noiseSuppressor;
+    VoiceActivityDetector m_vad;
+    QVector<qint16> m_monoScratch;
     QMediaDevices* m_mediaDevices = nullptr;
     int m_frameBytes = 320;
     int m_intervalMs = 20;
@@ -124,8 +148,7 @@ private:
     int m_inputGainPercent = 200;
     bool m_noiseSuppressionEnabled = false;
     int m_noiseSuppressionLevel = 45;
-    float m_noiseFloor = 0.0f;
-    float m_noiseGateGain = 1.0f;
+    bool m_voiceActivityDetectionEnabled = false;
     bool m_running = false;
     bool m_wantRunning = false;
     bool m_restartScheduled = false;
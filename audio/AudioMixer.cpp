@@ -0,0 +1,211 @@
+#include "AudioMixer.h"
+
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INCOMUDON_MIXER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define INCOMUDON_MIXER_NEON 1
+#endif
+
+namespace
+{
+// About -1 dBFS; peaks above this are pulled down by the limiter.
+constexpr float kLimiterThreshold = 29204.0f;
+constexpr int kLookaheadMs = 2;
+constexpr int kReleaseMs = 80;
+
+// acc[i] += in[i] * gain
+void accumulateMono(float* acc, const qint16* in, int count, float gain)
+{
+    int i = 0;
+#if defined(INCOMUDON_MIXER_SSE2)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+        const __m128 a0 = _mm_loadu_ps(acc + i);
+        const __m128 a1 = _mm_loadu_ps(acc + i + 4);
+        _mm_storeu_ps(acc + i, _mm_add_ps(a0, _mm_mul_ps(_mm_cvtepi32_ps(lo), g)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(a1, _mm_mul_ps(_mm_cvtepi32_ps(hi), g)));
+    }
+#elif defined(INCOMUDON_MIXER_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        const int16x8_t s16 = vld1q_s16(in + i);
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+        vst1q_f32(acc + i, vmlaq_n_f32(vld1q_f32(acc + i), lo, gain));
+        vst1q_f32(acc + i + 4, vmlaq_n_f32(vld1q_f32(acc + i + 4), hi, gain));
+    }
+#endif
+    for (; i < count; ++i)
+        acc[i] += static_cast<float>(in[i]) * gain;
+}
+
+void accumulateStereo(float* acc, const qint16* in, int count, float leftGain, float rightGain)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const float s = static_cast<float>(in[i]);
+        acc[2 * i] += s * leftGain;
+        acc[2 * i + 1] += s * rightGain;
+    }
+}
+
+qint16 saturate(float value)
+{
+    return static_cast<qint16>(qBound(-32768, static_cast<int>(std::lrint(value)), 32767));
+}
+}
+
+void AudioMixer::configure(int frameSamples, int sampleRate, int channels)
+{
+    frameSamples = qMax(0, frameSamples);
+    sampleRate = qMax(1, sampleRate);
+    channels = (channels == 2) ? 2 : 1;
+    if (frameSamples == m_frameSamples && sampleRate == m_sampleRate && channels == m_channels)
+        return;
+
+    m_frameSamples = frameSamples;
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_lookahead = qMax(1, sampleRate * kLookaheadMs / 1000);
+    // Attack settles within the look-ahead window; release is a slow
+    // exponential return to unity.
+    m_attackCoef = 1.0f - std::exp(-4.0f / static_cast<float>(m_lookahead));
+    m_releaseCoef = 1.0f - std::exp(-1.0f / (static_cast<float>(sampleRate) * kReleaseMs / 1000.0f));
+    m_accumulator.resize(frameSamples * channels);
+    m_delay.resize(m_lookahead * channels);
+    m_minGain.resize(m_lookahead + 1);
+    m_minFrame.resize(m_lookahead + 1);
+    reset();
+}
+
+int AudioMixer::frameSamples() const
+{
+    return m_frameSamples;
+}
+
+int AudioMixer::channels() const
+{
+    return m_channels;
+}
+
+void AudioMixer::reset()
+{
+    std::fill(m_delay.begin(), m_delay.end(), 0.0f);
+    m_delayPos = 0;
+    m_minHead = 0;
+    m_minCount = 0;
+    m_frameIndex = 0;
+    m_gain = 1.0f;
+    m_tailFrames = 0;
+    begin();
+}
+
+void AudioMixer::begin()
+{
+    std::fill(m_accumulator.begin(), m_accumulator.end(), 0.0f);
+    m_contributors = 0;
+}
+
+void AudioMixer::add(QSpan<const qint16> samples, float gain, float pan)
+{
+    const int count = qMin(m_frameSamples, static_cast<int>(samples.size()));
+    if (count <= 0)
+        return;
+
+    if (m_channels == 2)
+    {
+        // Constant-power pan: -1 is hard left, +1 hard right.
+        const float angle = (qBound(-1.0f, pan, 1.0f) + 1.0f) * static_cast<float>(M_PI) / 4.0f;
+        accumulateStereo(m_accumulator.data(), samples.data(), count,
+                         gain * std::cos(angle), gain * std::sin(angle));
+    }
+    else
+    {
+        accumulateMono(m_accumulator.data(), samples.data(), count, gain);
+    }
+    ++m_contributors;
+}
+
+int AudioMixer::contributors() const
+{
+    return m_contributors;
+}
+
+bool AudioMixer::idle() const
+{
+    return m_contributors == 0 && m_tailFrames == 0;
+}
+
+void AudioMixer::mixTo(QSpan<qint16> out)
+{
+    if (static_cast<int>(out.size()) < m_frameSamples * m_channels)
+        return;
+
+    if (m_contributors > 0)
+        m_tailFrames = m_lookahead;
+    else
+        m_tailFrames = qMax(0, m_tailFrames - m_frameSamples);
+    limitTo(out.data());
+}
+
+void AudioMixer::limitTo(qint16* out)
+{
+    const float* acc = m_accumulator.constData();
+    float* delay = m_delay.data();
+    float* minGain = m_minGain.data();
+    qint64* minFrame = m_minFrame.data();
+    const int ringSize = m_minGain.size();
+
+    for (int frame = 0; frame < m_frameSamples; ++frame)
+    {
+        const float* in = acc + frame * m_channels;
+        float peak = std::fabs(in[0]);
+        if (m_channels == 2)
+            peak = qMax(peak, std::fabs(in[1]));
+        const float required = peak > kLimiterThreshold ? kLimiterThreshold / peak : 1.0f;
+
+        // Monotonic queue: drop entries that have left the look-ahead
+        // window, then entries that can no longer be the minimum. Expiring
+        // first keeps at most m_lookahead + 1 entries live, the ring size.
+        while (m_minCount > 0 && minFrame[m_minHead] <= m_frameIndex - m_lookahead - 1)
+        {
+            m_minHead = (m_minHead + 1) % ringSize;
+            --m_minCount;
+        }
+        while (m_minCount > 0)
+        {
+            const int back = (m_minHead + m_minCount - 1) % ringSize;
+            if (minGain[back] < required)
+                break;
+            --m_minCount;
+        }
+        const int slot = (m_minHead + m_minCount) % ringSize;
+        minGain[slot] = required;
+        minFrame[slot] = m_frameIndex;
+        ++m_minCount;
+
+        const float target = minGain[m_minHead];
+        m_gain += (target - m_gain) * (target < m_gain ? m_attackCoef : m_releaseCoef);
+
+        float* delayed = delay + m_delayPos * m_channels;
+        qint16* dst = out + frame * m_channels;
+        for (int ch = 0; ch < m_channels; ++ch)
+        {
+            dst[ch] = saturate(delayed[ch] * m_gain);
+            delayed[ch] = in[ch];
+        }
+        if (++m_delayPos == m_lookahead)
+            m_delayPos = 0;
+        ++m_frameIndex;
+    }
+}
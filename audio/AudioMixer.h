@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QSpan>
+#include <QVector>
+#include <QtGlobal>
+
+// Sums int16 streams into a reused float accumulator at unity gain and runs
+// the result through a look-ahead peak limiter, so levels do not change as
+// talkers join or leave. Mono by default; with two channels, add() pans each
+// stream and the output is interleaved stereo.
+class AudioMixer
+{
+public:
+    void configure(int frameSamples, int sampleRate, int channels = 1);
+    int frameSamples() const;
+    int channels() const;
+    void reset();
+
+    void begin();
+    void add(QSpan<const qint16> samples, float gain = 1.0f, float pan = 0.0f);
+    int contributors() const;
+    // True when nothing was added and the limiter delay line has drained.
+    bool idle() const;
+    // Writes frameSamples() * channels() samples.
+    void mixTo(QSpan<qint16> out);
+
+private:
+    void limitTo(qint16* out);
+
+    QVector<float> m_accumulator;
+    int m_frameSamples = 0;
+    int m_sampleRate = 16000;
+    int m_channels = 1;
+    int m_contributors = 0;
+
+    // Limiter state. The delay line holds m_lookahead frames; the running
+    // minimum of the required gain over that window is kept in a monotonic
+    // queue stored in fixed rings.
+    QVector<float> m_delay;
+    QVector<float> m_minGain;
+    QVector<qint64> m_minFrame;
+    int m_lookahead = 32;
+    int m_delayPos = 0;
+    int m_minHead = 0;
+    int m_minCount = 0;
+    qint64 m_frameIndex = 0;
+    float m_gain = 1.0f;
+    float m_attackCoef = 0.1f;
+    float m_releaseCoef = 0.001f;
+    int m_tailFrames = 0;
+};
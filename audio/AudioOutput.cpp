@@ -68,7 +68,7 @@ static QVector<qint16> toMonoInt16(const QByteArray& data)
     return out;
 }
 
-static void applyGain(QVector<qint16>& samples, float gain)
+static void applyGain(QSpan<qint16> samples, float gain)
 {
     if (samples.isEmpty())
         return;
@@ -89,68 +89,42 @@ static void applyGain(QVector<qint16>& samples, float gain)
         s = static_cast<qint16>(clamped);
     }
 }
+}
 
-static QByteArray fromMonoInt16(const QVector<qint16>& samples, const QAudioFormat& format)
+class AudioOutput::PullDevice : public QIODevice
 {
-    const int channels = qMax(1, format.channelCount());
-    const int bytesPerSample = format.bytesPerSample();
-    if (bytesPerSample <= 0)
-        return {};
+public:
+    explicit PullDevice(AudioOutput* owner)
+        : QIODevice(owner)
+        , m_owner(owner)
+    {
+    }
 
-    const QAudioFormat::SampleFormat fmt = format.sampleFormat();
-    if (fmt != QAudioFormat::Int16 &&
-        fmt != QAudioFormat::Int32 &&
-        fmt != QAudioFormat::Float &&
-        fmt != QAudioFormat::UInt8)
+    bool isSequential() const override
     {
-        return {};
+        return true;
     }
 
-    QByteArray out;
-    out.resize(samples.size() * channels * bytesPerSample);
-    char* dst = out.data();
+    qint64 bytesAvailable() const override
+    {
+        // Playout never runs dry; silence is rendered when nobody talks.
+        return QIODevice::bytesAvailable() + 65536;
+    }
 
-    for (int i = 0; i < samples.size(); ++i)
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
     {
-        const qint16 sample = samples[i];
-        for (int ch = 0; ch < channels; ++ch)
-        {
-            char* writePtr = dst + (i * channels + ch) * bytesPerSample;
-            switch (fmt)
-            {
-            case QAudioFormat::Int16:
-            {
-                const qint16 v = qToLittleEndian<qint16>(sample);
-                std::memcpy(writePtr, &v, sizeof(v));
-                break;
-            }
-            case QAudioFormat::Int32:
-            {
-                const qint32 v = qToLittleEndian<qint32>(
-                    static_cast<qint32>(sample) << 16);
-                std::memcpy(writePtr, &v, sizeof(v));
-                break;
-            }
-            case QAudioFormat::Float:
-            {
-                const float v = static_cast<float>(sample) / 32768.0f;
-                std::memcpy(writePtr, &v, sizeof(v));
-                break;
-            }
-            case QAudioFormat::UInt8:
-            {
-                const quint8 v = static_cast<quint8>((sample >> 8) + 128);
-                std::memcpy(writePtr, &v, sizeof(v));
-                break;
-            }
-            default:
-                break;
-            }
-        }
+        return m_owner->readPull(data, maxSize);
     }
-    return out;
-}
-}
+
+    qint64 writeData(const char*, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    AudioOutput* m_owner = nullptr;
+};
 
 AudioOutput::AudioOutput(QObject* parent)
     : QObject(parent)
@@ -190,7 +164,8 @@ int AudioOutput::queuedMs() const
     if (!m_sink)
         return 0;
 
-    int queuedBytes = m_pendingOutput.size();
+    int queuedBytes = m_pullActive ? (m_pullPending.size() - m_pullPendingOffset)
+                                   : m_pendingOutput.size();
     const int sinkBuffered = qMax(0, m_sink->bufferSize() - m_sink->bytesFree());
     queuedBytes += sinkBuffered;
 
@@ -264,8 +239,49 @@ void AudioOutput::setSampleRate(int sampleRate)
     }
 }
 
+void AudioOutput::setPlayoutSource(AudioPlayoutSource* source)
+{
+    if (m_source == source)
+        return;
+
+    m_source = source;
+    if (!m_source && m_pullMode)
+    {
+        m_pullMode = false;
+        resetOutputSink();
+    }
+}
+
+bool AudioOutput::startPlayout()
+{
+    if (!m_source)
+        return false;
+
+    if (!m_pullMode)
+    {
+        m_pullMode = true;
+        if (m_sink)
+            resetOutputSink();
+    }
+    ensureStarted();
+    return m_pullActive;
+}
+
+bool AudioOutput::playoutActive() const
+{
+    return m_pullActive;
+}
+
+double AudioOutput::clockDriftPpm() const
+{
+    return m_clockDriftPpm;
+}
+
 void AudioOutput::playFrame(const QByteArray& pcmFrame)
 {
+    if (m_pullMode)
+        return;
+
     ensureStarted();
     if (!m_device)
         return;
@@ -278,7 +294,8 @@ void AudioOutput::playFrame(const QByteArray& pcmFrame)
         applyGain(input, gain);
         QVector<qint16> resampled;
         m_resampler.push(input, resampled);
-        const QByteArray deviceFrame = fromMonoInt16(resampled, m_deviceFormat);
+        QByteArray deviceFrame;
+        m_converter.appendFromMono(resampled, deviceFrame);
         if (!deviceFrame.isEmpty())
         {
             m_pendingOutput.append(deviceFrame);
@@ -297,7 +314,7 @@ void AudioOutput::ensureStarted()
     if (device.isNull())
         return;
 
-    if (m_device && m_sink && !m_activeOutputDeviceId.isEmpty() &&
+    if ((m_device || m_pullActive) && m_sink && !m_activeOutputDeviceId.isEmpty() &&
         m_activeOutputDeviceId == device.id())
     {
         return;
@@ -324,6 +341,7 @@ void AudioOutput::ensureStarted()
     }
 
     m_resampler.setRates(m_format.sampleRate(), m_deviceFormat.sampleRate());
+    m_converter.setFormat(m_deviceFormat);
     m_resampler.reset();
     m_pendingOutput.clear();
 
@@ -350,9 +368,25 @@ void AudioOutput::ensureStarted()
     m_sink->setBufferSize(qMax(4096, targetBufferBytes));
     connect(m_sink, &QAudioSink::stateChanged,
             this, &AudioOutput::onSinkStateChanged);
-    m_device = m_sink->start();
+    if (m_pullMode && m_source)
+    {
+        if (!m_pullDevice)
+            m_pullDevice = new PullDevice(this);
+        if (!m_pullDevice->isOpen())
+            m_pullDevice->open(QIODevice::ReadOnly);
+        m_pullPending.resize(0);
+        m_pullPendingOffset = 0;
+        m_sink->start(m_pullDevice);
+        m_pullActive = m_sink->error() == QtAudio::NoError;
+        m_driftClock.start();
+        m_driftAnchorWallUs = -1;
+    }
+    else
+    {
+        m_device = m_sink->start();
+    }
     m_activeOutputDeviceId = device.id();
-    if (!m_device)
+    if (!m_device && !m_pullActive)
         qWarning("Failed to start audio output.");
 
     if (bytesPerSample > 0)
@@ -393,6 +427,10 @@ void AudioOutput::resetOutputSink()
         m_resettingSink = false;
     }
     m_device = nullptr;
+    m_pullActive = false;
+    m_pullPending.resize(0);
+    m_pullPendingOffset = 0;
+    m_driftClock.invalidate();
     m_activeOutputDeviceId.clear();
     m_pendingOutput.clear();
     m_resampler.reset();
@@ -451,6 +489,12 @@ void AudioOutput::onDevicePollTick()
 
 void AudioOutput::onKeepAliveTick()
 {
+    if (m_pullActive)
+    {
+        updateClockDrift();
+        return;
+    }
+
     if (!m_device || !m_sink || m_keepAliveBytes <= 0)
         return;
 
@@ -553,6 +597,87 @@ void AudioOutput::trimPending()
     m_pendingOutput.remove(0, dropBytes);
 }
 
+qint64 AudioOutput::readPull(char* data, qint64 maxSize)
+{
+    const int frameBytes = qMax(1, m_outputFrameBytes);
+    maxSize -= maxSize % frameBytes;
+
+    qint64 written = 0;
+    while (written < maxSize)
+    {
+        if (m_pullPendingOffset >= m_pullPending.size())
+        {
+            renderPullChunk();
+            if (m_pullPending.isEmpty())
+                break;
+        }
+
+        const qint64 chunk = qMin<qint64>(maxSize - written,
+                                          m_pullPending.size() - m_pullPendingOffset);
+        std::memcpy(data + written, m_pullPending.constData() + m_pullPendingOffset,
+                    static_cast<size_t>(chunk));
+        written += chunk;
+        m_pullPendingOffset += static_cast<int>(chunk);
+    }
+    if (written > 0)
+        m_lastWrite.restart();
+    return written;
+}
+
+void AudioOutput::renderPullChunk()
+{
+    m_pullPending.resize(0);
+    m_pullPendingOffset = 0;
+
+    int frameSamples = m_source ? m_source->playoutFrameSamples() : 0;
+    if (frameSamples <= 0)
+        frameSamples = qMax(1, m_sampleRate / 50);
+    if (m_pullMix.size() != frameSamples)
+        m_pullMix.resize(frameSamples);
+
+    const bool audible = m_source && m_source->renderPlayout(m_pullMix);
+    if (audible)
+        applyGain(m_pullMix, static_cast<float>(m_outputGainPercent) / 100.0f);
+    else
+        std::fill(m_pullMix.begin(), m_pullMix.end(), qint16(0));
+
+    m_pullResampled.clear();
+    m_resampler.push(m_pullMix, m_pullResampled);
+    m_converter.appendFromMono(m_pullResampled, m_pullPending);
+    m_lastFrameBytes = frameSamples * static_cast<int>(sizeof(qint16));
+}
+
+void AudioOutput::updateClockDrift()
+{
+    if (!m_sink || !m_driftClock.isValid())
+        return;
+
+    // Skip the initial fill, which the sink takes faster than real time.
+    const qint64 wallUs = m_driftClock.nsecsElapsed() / 1000;
+    if (wallUs < 2000000)
+        return;
+
+    const qint64 deviceUs = m_sink->processedUSecs();
+    if (m_driftAnchorWallUs < 0)
+    {
+        m_driftAnchorWallUs = wallUs;
+        m_driftAnchorDeviceUs = deviceUs;
+        return;
+    }
+
+    const qint64 spanUs = wallUs - m_driftAnchorWallUs;
+    if (spanUs < 5000000)
+        return;
+
+    const double ppm = (static_cast<double>(deviceUs - m_driftAnchorDeviceUs - spanUs) /
+                        static_cast<double>(spanUs)) * 1.0e6;
+    m_driftAnchorWallUs = wallUs;
+    m_driftAnchorDeviceUs = deviceUs;
+    m_clockDriftPpm = m_clockDriftKnown ? (0.8 * m_clockDriftPpm + 0.2 * ppm) : ppm;
+    m_clockDriftKnown = true;
+    emit clockDriftPpmChanged();
+}
+
 void AudioOutput::refreshOutputDevices()
 {
     const QList<QAudioDevice> devices = QMediaDevices::audioOutputs();
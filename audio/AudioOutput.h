@@ -10,9 +10,12 @@
 #include <QIODevice>
 #include <QTimer>
 #include <QStringList>
+#include <QVector>
 #include <QtGlobal>
 
+#include "audio/AudioPlayoutSource.h"
 #include "audio/AudioResampler.h"
+#include "audio/SampleFormatConverter.h"
 
 class AudioOutput : public QObject
 {
@@ -35,6 +38,9 @@ class AudioOutput : public QObject
                READ sampleRate
                WRITE setSampleRate
                NOTIFY sampleRateChanged)
+    Q_PROPERTY(double clockDriftPpm
+               READ clockDriftPpm
+               NOTIFY clockDriftPpmChanged)
 
 public:
     explicit AudioOutput(QObject* parent = nullptr);
@@ -49,6 +55,13 @@ public:
     void setSelectedOutputDeviceId(const QString& deviceId);
     int sampleRate() const;
     void setSampleRate(int sampleRate);
+    // Pull mode: the sink asks the source for exactly the audio it consumes,
+    // so playout follows the device clock instead of a timer.
+    void setPlayoutSource(AudioPlayoutSource* source);
+    bool startPlayout();
+    bool playoutActive() const;
+    // Device clock rate relative to the system clock, in parts per million.
+    double clockDriftPpm() const;
 
 public slots:
     void playFrame(const QByteArray& pcmFrame);
@@ -59,6 +72,7 @@ signals:
     void outputDevicesChanged();
     void selectedOutputDeviceIdChanged();
     void sampleRateChanged();
+    void clockDriftPpmChanged();
 
 private:
     void resetOutputSink();
@@ -71,6 +85,9 @@ private:
     void onSinkStateChanged(QAudio::State state);
     void flushPending();
     void trimPending();
+    qint64 readPull(char* data, qint64 maxSize);
+    void renderPullChunk();
+    void updateClockDrift();
     void refreshOutputDevices();
     QAudioDevice resolveOutputDevice() const;
     static QString encodeDeviceId(const QByteArray& rawId);
@@ -81,6 +98,7 @@ private:
     QAudioFormat m_format;
     QAudioFormat m_deviceFormat;
     AudioResampler m_resampler;
+    SampleFormatConverter m_converter;
     QTimer m_keepAliveTimer;
     QTimer m_devicePollTimer;
     QTimer m_restartTimer;
@@ -103,4 +121,20 @@ private:
     int m_outputGainPercent = 100;
     bool m_restartScheduled = false;
     bool m_resettingSink = false;
+
+    class PullDevice;
+    friend class PullDevice;
+    AudioPlayoutSource* m_source = nullptr;
+    PullDevice* m_pullDevice = nullptr;
+    bool m_pullMode = false;
+    bool m_pullActive = false;
+    QVector<qint16> m_pullMix;
+    QVector<qint16> m_pullResampled;
+    QByteArray m_pullPending;
+    int m_pullPendingOffset = 0;
+    QElapsedTimer m_driftClock;
+    qint64 m_driftAnchorWallUs = -1;
+    qint64 m_driftAnchorDeviceUs = 0;
+    double m_clockDriftPpm = 0.0;
+    bool m_clockDriftKnown = false;
 };
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QSpan>
+#include <QtGlobal>
+
+// Renders mono int16 playout at the output's sample rate on demand. Called
+// from the audio sink's pull callback, which Qt runs on the sink's thread.
+class AudioPlayoutSource
+{
+public:
+    virtual ~AudioPlayoutSource() = default;
+    virtual int playoutFrameSamples() const = 0;
+    // Fills out completely; returns false when it is all silence.
+    virtual bool renderPlayout(QSpan<qint16> out) = 0;
+};
@@ -1,6 +1,7 @@
 #include "AudioResampler.h"
 
 #include <QtMath>
+#include <algorithm>
 
 namespace
 {
@@ -15,6 +16,13 @@ double blackmanWindow(int tapIndex, int tapCount)
                          static_cast<double>(tapCount - 1);
     return 0.42 - 0.5 * qCos(phase) + 0.08 * qCos(2.0 * phase);
 }
+
+void appendSamples(QVector<qint16>& to, QSpan<const qint16> samples)
+{
+    const int offset = to.size();
+    to.resize(offset + static_cast<int>(samples.size()));
+    std::copy(samples.begin(), samples.end(), to.begin() + offset);
+}
 }
 
 void AudioResampler::setRates(int inRate, int outRate)
@@ -32,33 +40,47 @@ void AudioResampler::setRates(int inRate, int outRate)
     reset();
 }
 
+void AudioResampler::setRatioAdjustPpm(double ppm)
+{
+    m_ratioAdjustPpm = qBound(-2000.0, ppm, 2000.0);
+}
+
+double AudioResampler::ratioAdjustPpm() const
+{
+    return m_ratioAdjustPpm;
+}
+
 void AudioResampler::reset()
 {
     m_cache.clear();
     m_pos = 0.0;
 }
 
-void AudioResampler::push(const QVector<qint16>& input, QVector<qint16>& output)
+void AudioResampler::push(QSpan<const qint16> input, QVector<qint16>& output)
 {
     if (input.isEmpty())
         return;
 
-    if (m_inRate == m_outRate)
+    const bool sameRate = m_inRate == m_outRate;
+    if (sameRate && qFuzzyIsNull(m_ratioAdjustPpm) && m_cache.isEmpty())
     {
-        output += input;
+        appendSamples(output, input);
         return;
     }
 
-    m_cache += input;
+    appendSamples(m_cache, input);
 
-    const double step = static_cast<double>(m_inRate) /
-                        static_cast<double>(m_outRate);
+    const double step = (static_cast<double>(m_inRate) /
+                         static_cast<double>(m_outRate)) *
+                        (1.0 + m_ratioAdjustPpm * 1.0e-6);
 
     // Keep enough look-ahead for the FIR kernel so downsampling can apply a
     // proper low-pass filter instead of interpolating with no anti-aliasing.
+    // Drift correction at equal rates only needs linear interpolation.
     while (m_pos + static_cast<double>(m_halfTaps) < static_cast<double>(m_cache.size()))
     {
-        const int sample = qBound(-32768, qRound(sampleAt(m_pos)), 32767);
+        const double value = sameRate ? linearSampleAt(m_pos) : sampleAt(m_pos);
+        const int sample = qBound(-32768, qRound(value), 32767);
         output.append(static_cast<qint16>(sample));
         m_pos += step;
     }
@@ -105,6 +127,18 @@ double AudioResampler::sampleAt(double position) const
     return sum / norm;
 }
 
+double AudioResampler::linearSampleAt(double position) const
+{
+    if (m_cache.isEmpty())
+        return 0.0;
+
+    const int index = static_cast<int>(position);
+    const double frac = position - static_cast<double>(index);
+    const int next = qMin(index + 1, static_cast<int>(m_cache.size()) - 1);
+    return static_cast<double>(m_cache[index]) * (1.0 - frac) +
+           static_cast<double>(m_cache[next]) * frac;
+}
+
 double AudioResampler::sinc(double x)
 {
     if (qAbs(x) < 1.0e-9)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QSpan>
 #include <QVector>
 #include <QtGlobal>
 
@@ -7,16 +8,23 @@ class AudioResampler
 {
 public:
     void setRates(int inRate, int outRate);
+    // Nudges the conversion ratio by a few ppm; positive consumes input
+    // faster. Used to absorb clock drift between sender and receiver.
+    void setRatioAdjustPpm(double ppm);
+    double ratioAdjustPpm() const;
     void reset();
-    void push(const QVector<qint16>& input, QVector<qint16>& output);
+    // Appends the converted samples to output.
+    void push(QSpan<const qint16> input, QVector<qint16>& output);
 
 private:
     double sampleAt(double position) const;
+    double linearSampleAt(double position) const;
     static double sinc(double x);
 
     int m_inRate = 8000;
     int m_outRate = 8000;
     double m_pos = 0.0;
+    double m_ratioAdjustPpm = 0.0;
     QVector<qint16> m_cache;
     int m_tapCount = 32;
     int m_halfTaps = 16;
@@ -0,0 +1,185 @@
+#include "NoiseSuppressor.h"
+
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+constexpr int kHopMs = 10;
+// Minimum statistics: the noise floor is the smallest smoothed power seen
+// over kSubwindows x kSubwindowFrames hops (about 1.5 s).
+constexpr int kSubwindows = 8;
+constexpr int kSubwindowFrames = 19;
+constexpr float kPowerSmoothing = 0.8f;
+constexpr float kMinimumBias = 2.0f;
+// Decision-directed a-priori SNR weight and lower bound (-25 dB).
+constexpr float kDecisionDirectedAlpha = 0.98f;
+constexpr float kMinPrioriSnr = 0.00316f;
+constexpr float kTinyPower = 1.0e-3f;
+}
+
+void NoiseSuppressor::configure(int sampleRate)
+{
+    if (sampleRate <= 0 || sampleRate == m_sampleRate)
+        return;
+
+    m_sampleRate = sampleRate;
+    m_hop = qMax(8, (sampleRate * kHopMs) / 1000);
+    m_window = 2 * m_hop;
+    int fftSize = 4;
+    while (fftSize < m_window)
+        fftSize <<= 1;
+    m_fft.setSize(fftSize);
+    m_bins = m_fft.bins();
+
+    // sqrt of a periodic Hann on both analysis and synthesis sums to one at
+    // 50% overlap, so unity gain reconstructs the input exactly.
+    m_analysisWindow.resize(m_window);
+    for (int n = 0; n < m_window; ++n)
+        m_analysisWindow[n] = static_cast<float>(qSqrt(0.5 - 0.5 * qCos(2.0 * M_PI * n / m_window)));
+
+    m_input.resize(m_window);
+    m_frame.resize(fftSize);
+    m_spectrum.resize(2 * m_bins);
+    m_overlap.resize(m_hop);
+    m_output.resize(m_hop);
+    m_smoothedPower.resize(m_bins);
+    m_prevCleanPower.resize(m_bins);
+    m_subwindowMin.resize(kSubwindows * m_bins);
+    m_windowMin.resize(m_bins);
+    m_currentMin.resize(m_bins);
+    setLevel(m_level);
+    reset();
+}
+
+int NoiseSuppressor::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+void NoiseSuppressor::setLevel(int level)
+{
+    m_level = qBound(0, level, 100);
+    const float strength = static_cast<float>(m_level) / 100.0f;
+    // Floor from -6 dB at level 0 to -30 dB at level 100.
+    m_gainFloor = std::pow(10.0f, -(6.0f + 24.0f * strength) / 20.0f);
+    m_overSubtraction = 1.0f + strength;
+}
+
+int NoiseSuppressor::level() const
+{
+    return m_level;
+}
+
+int NoiseSuppressor::hopSamples() const
+{
+    return m_hop;
+}
+
+int NoiseSuppressor::latencySamples() const
+{
+    return m_window;
+}
+
+void NoiseSuppressor::reset()
+{
+    constexpr float kUnset = std::numeric_limits<float>::max();
+    std::fill(m_input.begin(), m_input.end(), 0.0f);
+    std::fill(m_overlap.begin(), m_overlap.end(), 0.0f);
+    std::fill(m_output.begin(), m_output.end(), 0.0f);
+    std::fill(m_prevCleanPower.begin(), m_prevCleanPower.end(), 0.0f);
+    std::fill(m_subwindowMin.begin(), m_subwindowMin.end(), kUnset);
+    std::fill(m_windowMin.begin(), m_windowMin.end(), kUnset);
+    std::fill(m_currentMin.begin(), m_currentMin.end(), kUnset);
+    m_inputFill = 0;
+    m_subwindowFrames = 0;
+    m_subwindowIndex = 0;
+    m_primed = false;
+}
+
+void NoiseSuppressor::process(QSpan<qint16> samples)
+{
+    if (m_hop <= 0)
+        return;
+
+    float* input = m_input.data() + m_hop;
+    for (qint16& sample : samples)
+    {
+        input[m_inputFill] = static_cast<float>(sample);
+        sample = static_cast<qint16>(std::lrint(qBound(-32768.0f, m_output.at(m_inputFill), 32767.0f)));
+        if (++m_inputFill == m_hop)
+        {
+            processHop();
+            m_inputFill = 0;
+        }
+    }
+}
+
+void NoiseSuppressor::processHop()
+{
+    const int fftSize = m_fft.size();
+    for (int n = 0; n < m_window; ++n)
+        m_frame[n] = m_input.at(n) * m_analysisWindow.at(n);
+    std::fill(m_frame.begin() + m_window, m_frame.begin() + fftSize, 0.0f);
+    m_fft.forward(m_frame.constData(), m_spectrum.data());
+
+    bool subwindowDone = false;
+    if (++m_subwindowFrames >= kSubwindowFrames)
+    {
+        m_subwindowFrames = 0;
+        subwindowDone = true;
+    }
+
+    float* spectrum = m_spectrum.data();
+    float* storedMin = m_subwindowMin.data() + m_subwindowIndex * m_bins;
+    for (int k = 0; k < m_bins; ++k)
+    {
+        const float re = spectrum[2 * k];
+        const float im = spectrum[2 * k + 1];
+        const float power = re * re + im * im;
+
+        float& smoothed = m_smoothedPower[k];
+        smoothed = m_primed ? kPowerSmoothing * smoothed + (1.0f - kPowerSmoothing) * power : power;
+        float& currentMin = m_currentMin[k];
+        currentMin = qMin(currentMin, smoothed);
+        const float noise = qMax(kTinyPower, qMin(m_windowMin.at(k), currentMin) * kMinimumBias);
+        if (subwindowDone)
+        {
+            storedMin[k] = currentMin;
+            currentMin = smoothed;
+        }
+
+        const float lambda = noise * m_overSubtraction;
+        const float posteriori = power / lambda;
+        const float priori = qMax(kMinPrioriSnr,
+                                  kDecisionDirectedAlpha * (m_prevCleanPower.at(k) / lambda) +
+                                      (1.0f - kDecisionDirectedAlpha) * qMax(0.0f, posteriori - 1.0f));
+        const float gain = qMax(m_gainFloor, priori / (1.0f + priori));
+        m_prevCleanPower[k] = gain * gain * power;
+        spectrum[2 * k] = re * gain;
+        spectrum[2 * k + 1] = im * gain;
+    }
+    m_primed = true;
+
+    if (subwindowDone)
+    {
+        m_subwindowIndex = (m_subwindowIndex + 1) % kSubwindows;
+        for (int k = 0; k < m_bins; ++k)
+        {
+            float windowMin = m_subwindowMin.at(k);
+            for (int w = 1; w < kSubwindows; ++w)
+                windowMin = qMin(windowMin, m_subwindowMin.at(w * m_bins + k));
+            m_windowMin[k] = windowMin;
+        }
+    }
+
+    m_fft.inverse(m_spectrum.constData(), m_frame.data());
+    for (int n = 0; n < m_hop; ++n)
+    {
+        m_output[n] = m_frame.at(n) * m_analysisWindow.at(n) + m_overlap.at(n);
+        m_overlap[n] = m_frame.at(m_hop + n) * m_analysisWindow.at(m_hop + n);
+    }
+    std::copy(m_input.cbegin() + m_hop, m_input.cend(), m_input.begin());
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QSpan>
+#include <QVector>
+#include <QtGlobal>
+
+#include "audio/RealFft.h"
+
+// Short-time spectral noise suppressor: Wiener gain with a decision-directed
+// a-priori SNR over a minimum-statistics noise estimate. Runs on 10 ms hops
+// with 50% overlapped sqrt-Hann windows and delays the signal by one 20 ms
+// window.
+class NoiseSuppressor
+{
+public:
+    void configure(int sampleRate);
+    int sampleRate() const;
+    // 0..100; higher values allow deeper attenuation of noise-only bins.
+    void setLevel(int level);
+    int level() const;
+    int hopSamples() const;
+    int latencySamples() const;
+    void reset();
+
+    // Filters samples in place; any length is accepted.
+    void process(QSpan<qint16> samples);
+
+private:
+    void processHop();
+
+    RealFft m_fft;
+    int m_sampleRate = 0;
+    int m_hop = 0;
+    int m_window = 0;
+    int m_bins = 0;
+    int m_level = 45;
+    float m_gainFloor = 0.0f;
+    float m_overSubtraction = 1.0f;
+
+    QVector<float> m_analysisWindow;
+    QVector<float> m_input;    // last m_window samples
+    QVector<float> m_frame;    // FFT input / output, m_fft.size()
+    QVector<float> m_spectrum; // interleaved re/im
+    QVector<float> m_overlap;  // synthesis tail carried to the next hop
+    QVector<float> m_output;   // one hop ready to hand out
+    int m_inputFill = 0;
+
+    QVector<float> m_smoothedPower;
+    QVector<float> m_prevCleanPower;
+    QVector<float> m_subwindowMin; // kSubwindows x m_bins
+    QVector<float> m_windowMin;    // minimum over the completed subwindows
+    QVector<float> m_currentMin;
+    int m_subwindowFrames = 0;
+    int m_subwindowIndex = 0;
+    bool m_primed = false;
+};
@@ -0,0 +1,154 @@
+#include "RealFft.h"
+
+#include <QtMath>
+#include <utility>
+
+void RealFft::setSize(int size)
+{
+    if (size < 4 || (size & (size - 1)) != 0 || size == m_size)
+        return;
+
+    m_size = size;
+    m_half = size / 2;
+
+    int bits = 0;
+    while ((1 << bits) < m_half)
+        ++bits;
+    m_bitReverse.resize(m_half);
+    for (int i = 0; i < m_half; ++i)
+    {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b)
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        m_bitReverse[i] = reversed;
+    }
+
+    m_twiddles.resize(qMax(2, m_half));
+    for (int k = 0; k < m_half / 2; ++k)
+    {
+        const double phase = -2.0 * M_PI * k / m_half;
+        m_twiddles[2 * k] = static_cast<float>(qCos(phase));
+        m_twiddles[2 * k + 1] = static_cast<float>(qSin(phase));
+    }
+
+    m_splitTwiddles.resize(2 * (m_half + 1));
+    for (int k = 0; k <= m_half; ++k)
+    {
+        const double phase = -2.0 * M_PI * k / m_size;
+        m_splitTwiddles[2 * k] = static_cast<float>(qCos(phase));
+        m_splitTwiddles[2 * k + 1] = static_cast<float>(qSin(phase));
+    }
+
+    m_work.resize(m_size);
+}
+
+int RealFft::size() const
+{
+    return m_size;
+}
+
+int RealFft::bins() const
+{
+    return m_half + 1;
+}
+
+void RealFft::complexFft(float* data, bool inverse) const
+{
+    for (int i = 0; i < m_half; ++i)
+    {
+        const int j = m_bitReverse.at(i);
+        if (j > i)
+        {
+            std::swap(data[2 * i], data[2 * j]);
+            std::swap(data[2 * i + 1], data[2 * j + 1]);
+        }
+    }
+
+    const float sign = inverse ? -1.0f : 1.0f;
+    for (int len = 2; len <= m_half; len <<= 1)
+    {
+        const int halfLen = len / 2;
+        const int stride = m_half / len;
+        for (int start = 0; start < m_half; start += len)
+        {
+            for (int k = 0; k < halfLen; ++k)
+            {
+                const float wr = m_twiddles.at(2 * k * stride);
+                const float wi = sign * m_twiddles.at(2 * k * stride + 1);
+                float* a = data + 2 * (start + k);
+                float* b = data + 2 * (start + k + halfLen);
+                const float tr = b[0] * wr - b[1] * wi;
+                const float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+void RealFft::forward(const float* in, float* out)
+{
+    if (m_size == 0)
+        return;
+
+    // Pack even/odd samples as one complex sequence, transform, then split
+    // the result into the spectrum of the real input.
+    float* z = m_work.data();
+    for (int i = 0; i < m_size; ++i)
+        z[i] = in[i];
+    complexFft(z, false);
+
+    out[0] = z[0] + z[1];
+    out[1] = 0.0f;
+    out[2 * m_half] = z[0] - z[1];
+    out[2 * m_half + 1] = 0.0f;
+    for (int k = 1; k < m_half; ++k)
+    {
+        const float zr = z[2 * k];
+        const float zi = z[2 * k + 1];
+        const float cr = z[2 * (m_half - k)];
+        const float ci = -z[2 * (m_half - k) + 1];
+        const float er = 0.5f * (zr + cr);
+        const float ei = 0.5f * (zi + ci);
+        // O = -i/2 (Z - conj Z[M-k])
+        const float or_ = 0.5f * (zi - ci);
+        const float oi = -0.5f * (zr - cr);
+        const float wr = m_splitTwiddles.at(2 * k);
+        const float wi = m_splitTwiddles.at(2 * k + 1);
+        out[2 * k] = er + (or_ * wr - oi * wi);
+        out[2 * k + 1] = ei + (or_ * wi + oi * wr);
+    }
+}
+
+void RealFft::inverse(const float* in, float* out)
+{
+    if (m_size == 0)
+        return;
+
+    float* z = m_work.data();
+    for (int k = 0; k < m_half; ++k)
+    {
+        const float xr = in[2 * k];
+        const float xi = in[2 * k + 1];
+        const float cr = in[2 * (m_half - k)];
+        const float ci = -in[2 * (m_half - k) + 1];
+        const float er = 0.5f * (xr + cr);
+        const float ei = 0.5f * (xi + ci);
+        const float dr = 0.5f * (xr - cr);
+        const float di = 0.5f * (xi - ci);
+        // O = D * conj(W^k); Z = E + iO
+        const float wr = m_splitTwiddles.at(2 * k);
+        const float wi = -m_splitTwiddles.at(2 * k + 1);
+        const float or_ = dr * wr - di * wi;
+        const float oi = dr * wi + di * wr;
+        z[2 * k] = er - oi;
+        z[2 * k + 1] = ei + or_;
+    }
+    complexFft(z, true);
+
+    const float scale = 1.0f / static_cast<float>(m_half);
+    for (int i = 0; i < m_size; ++i)
+        out[i] = z[i] * scale;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QVector>
+
+// Power-of-two real FFT computed as a half-size complex FFT. Twiddles and
+// the bit-reversal table are built in setSize(); transforms do not allocate.
+class RealFft
+{
+public:
+    void setSize(int size);
+    int size() const;
+    int bins() const;
+
+    // in: size() samples. out: bins() complex values as interleaved re/im.
+    void forward(const float* in, float* out);
+    // Inverse of forward(), including the 1/size scaling.
+    void inverse(const float* in, float* out);
+
+private:
+    void complexFft(float* data, bool inverse) const;
+
+    int m_size = 0;
+    int m_half = 0;
+    QVector<int> m_bitReverse;
+    QVector<float> m_twiddles;      // e^{-2πik/half}, k < half/2
+    QVector<float> m_splitTwiddles; // e^{-2πik/size}, k <= half
+    QVector<float> m_work;
+};
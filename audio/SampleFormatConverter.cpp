@@ -0,0 +1,321 @@
+#include "SampleFormatConverter.h"
+
+#include <QtGlobal>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INCOMUDON_CONVERT_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define INCOMUDON_CONVERT_NEON 1
+#endif
+
+namespace
+{
+// Scaling matches the previous per-sample conversion: float input is taken
+// as +-1.0 -> +-32767, output as int16 / 32768.
+constexpr float kFloatToInt16 = 32767.0f;
+constexpr float kInt16ToFloat = 1.0f / 32768.0f;
+
+template <typename T>
+struct SampleTraits;
+
+template <>
+struct SampleTraits<qint16>
+{
+    static float toInt16Domain(qint16 v) { return static_cast<float>(v); }
+    static qint16 fromInt16(qint16 s) { return s; }
+};
+
+template <>
+struct SampleTraits<qint32>
+{
+    static float toInt16Domain(qint32 v) { return static_cast<float>(v) / 65536.0f; }
+    static qint32 fromInt16(qint16 s) { return static_cast<qint32>(s) * 65536; }
+};
+
+template <>
+struct SampleTraits<float>
+{
+    static float toInt16Domain(float v) { return v * kFloatToInt16; }
+    static float fromInt16(qint16 s) { return static_cast<float>(s) * kInt16ToFloat; }
+};
+
+template <>
+struct SampleTraits<quint8>
+{
+    static float toInt16Domain(quint8 v) { return static_cast<float>((static_cast<int>(v) - 128) * 256); }
+    static quint8 fromInt16(qint16 s) { return static_cast<quint8>((s >> 8) + 128); }
+};
+
+inline qint16 roundToInt16(float v)
+{
+    return static_cast<qint16>(std::lrint(qBound(-32768.0f, v, 32767.0f)));
+}
+
+template <typename T>
+void toMonoGeneric(const char* in, int frames, int channels, qint16* out)
+{
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (int i = 0; i < frames; ++i)
+    {
+        float sum = 0.0f;
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            T v;
+            std::memcpy(&v, in + (i * channels + ch) * static_cast<int>(sizeof(T)), sizeof(T));
+            sum += SampleTraits<T>::toInt16Domain(v);
+        }
+        out[i] = roundToInt16(sum * scale);
+    }
+}
+
+template <typename T>
+void fromMonoGeneric(const qint16* in, int frames, int channels, char* out)
+{
+    for (int i = 0; i < frames; ++i)
+    {
+        const T v = SampleTraits<T>::fromInt16(in[i]);
+        for (int ch = 0; ch < channels; ++ch)
+            std::memcpy(out + (i * channels + ch) * static_cast<int>(sizeof(T)), &v, sizeof(T));
+    }
+}
+
+void copyInt16(const char* in, int frames, int, qint16* out)
+{
+    std::memcpy(out, in, static_cast<size_t>(frames) * sizeof(qint16));
+}
+
+void copyInt16Out(const qint16* in, int frames, int, char* out)
+{
+    std::memcpy(out, in, static_cast<size_t>(frames) * sizeof(qint16));
+}
+
+// (l + r) / 2 rounded half away from zero, like the qRound() it replaced:
+// adding 1 - (sum < 0) before the arithmetic shift.
+void int16StereoToMono(const char* in, int frames, int, qint16* out)
+{
+    const qint16* src = reinterpret_cast<const qint16*>(in);
+    int i = 0;
+#if defined(INCOMUDON_CONVERT_SSE2)
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i one32 = _mm_set1_epi32(1);
+    const auto halve = [one32](__m128i sum) {
+        return _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(sum, one32), _mm_srai_epi32(sum, 31)), 1);
+    };
+    for (; i + 8 <= frames; i += 8)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 8));
+        const __m128i sumA = halve(_mm_madd_epi16(a, ones));
+        const __m128i sumB = halve(_mm_madd_epi16(b, ones));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(sumA, sumB));
+    }
+#elif defined(INCOMUDON_CONVERT_NEON)
+    const int32x4_t one32 = vdupq_n_s32(1);
+    const auto halve = [one32](int32x4_t sum) {
+        return vmovn_s32(vshrq_n_s32(vaddq_s32(vaddq_s32(sum, one32), vshrq_n_s32(sum, 31)), 1));
+    };
+    for (; i + 8 <= frames; i += 8)
+    {
+        const int16x8x2_t lr = vld2q_s16(src + 2 * i);
+        const int32x4_t lo = vaddl_s16(vget_low_s16(lr.val[0]), vget_low_s16(lr.val[1]));
+        const int32x4_t hi = vaddl_s16(vget_high_s16(lr.val[0]), vget_high_s16(lr.val[1]));
+        vst1q_s16(out + i, vcombine_s16(halve(lo), halve(hi)));
+    }
+#endif
+    for (; i < frames; ++i)
+    {
+        qint16 l;
+        qint16 r;
+        std::memcpy(&l, in + i * 4, sizeof(l));
+        std::memcpy(&r, in + i * 4 + 2, sizeof(r));
+        const int sum = static_cast<int>(l) + r;
+        out[i] = static_cast<qint16>((sum + 1 - (sum < 0 ? 1 : 0)) >> 1);
+    }
+}
+
+void int16MonoToStereo(const qint16* in, int frames, int, char* out)
+{
+    qint16* dst = reinterpret_cast<qint16*>(out);
+    int i = 0;
+#if defined(INCOMUDON_CONVERT_SSE2)
+    for (; i + 8 <= frames; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_unpacklo_epi16(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 8), _mm_unpackhi_epi16(v, v));
+    }
+#elif defined(INCOMUDON_CONVERT_NEON)
+    for (; i + 8 <= frames; i += 8)
+    {
+        const int16x8_t v = vld1q_s16(in + i);
+        vst2q_s16(dst + 2 * i, int16x8x2_t{{v, v}});
+    }
+#endif
+    for (; i < frames; ++i)
+    {
+        std::memcpy(out + i * 4, &in[i], sizeof(qint16));
+        std::memcpy(out + i * 4 + 2, &in[i], sizeof(qint16));
+    }
+}
+
+void floatStereoToMono(const char* in, int frames, int, qint16* out)
+{
+    const float* src = reinterpret_cast<const float*>(in);
+    constexpr float scale = kFloatToInt16 * 0.5f;
+    int i = 0;
+#if defined(INCOMUDON_CONVERT_SSE2)
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= frames; i += 8)
+    {
+        const __m128 a = _mm_loadu_ps(src + 2 * i);
+        const __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+        const __m128 c = _mm_loadu_ps(src + 2 * i + 8);
+        const __m128 d = _mm_loadu_ps(src + 2 * i + 12);
+        __m128 m0 = _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                               _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128 m1 = _mm_add_ps(_mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0)),
+                               _mm_shuffle_ps(c, d, _MM_SHUFFLE(3, 1, 3, 1)));
+        m0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(m0, s), lo), hi);
+        m1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(m1, s), lo), hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(m0), _mm_cvtps_epi32(m1)));
+    }
+#elif defined(INCOMUDON_CONVERT_NEON) && defined(__aarch64__)
+    for (; i + 4 <= frames; i += 4)
+    {
+        const float32x4x2_t lr = vld2q_f32(src + 2 * i);
+        const float32x4_t m = vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), scale);
+        vst1_s16(out + i, vqmovn_s32(vcvtnq_s32_f32(m)));
+    }
+#endif
+    for (; i < frames; ++i)
+    {
+        float l;
+        float r;
+        std::memcpy(&l, in + i * 8, sizeof(l));
+        std::memcpy(&r, in + i * 8 + 4, sizeof(r));
+        out[i] = roundToInt16((l + r) * scale);
+    }
+}
+
+void floatMonoToStereo(const qint16* in, int frames, int, char* out)
+{
+    int i = 0;
+#if defined(INCOMUDON_CONVERT_SSE2)
+    float* dst = reinterpret_cast<float*>(out);
+    const __m128 s = _mm_set1_ps(kInt16ToFloat);
+    for (; i + 8 <= frames; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128 f0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), s);
+        const __m128 f1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), s);
+        _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(f0, f0));
+        _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(f0, f0));
+        _mm_storeu_ps(dst + 2 * i + 8, _mm_unpacklo_ps(f1, f1));
+        _mm_storeu_ps(dst + 2 * i + 12, _mm_unpackhi_ps(f1, f1));
+    }
+#elif defined(INCOMUDON_CONVERT_NEON)
+    float* dst = reinterpret_cast<float*>(out);
+    for (; i + 4 <= frames; i += 4)
+    {
+        const float32x4_t f = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(in + i))), kInt16ToFloat);
+        vst2q_f32(dst + 2 * i, float32x4x2_t{{f, f}});
+    }
+#endif
+    for (; i < frames; ++i)
+    {
+        const float v = SampleTraits<float>::fromInt16(in[i]);
+        std::memcpy(out + i * 8, &v, sizeof(v));
+        std::memcpy(out + i * 8 + 4, &v, sizeof(v));
+    }
+}
+}
+
+void SampleFormatConverter::setFormat(const QAudioFormat& format)
+{
+    m_toMono = nullptr;
+    m_fromMono = nullptr;
+    m_channels = qMax(1, format.channelCount());
+    m_bytesPerFrame = qMax(0, format.bytesPerSample()) * m_channels;
+
+    switch (format.sampleFormat())
+    {
+    case QAudioFormat::Int16:
+        if (m_channels == 1)
+        {
+            m_toMono = copyInt16;
+            m_fromMono = copyInt16Out;
+        }
+        else if (m_channels == 2)
+        {
+            m_toMono = int16StereoToMono;
+            m_fromMono = int16MonoToStereo;
+        }
+        else
+        {
+            m_toMono = toMonoGeneric<qint16>;
+            m_fromMono = fromMonoGeneric<qint16>;
+        }
+        break;
+    case QAudioFormat::Float:
+        if (m_channels == 2)
+        {
+            m_toMono = floatStereoToMono;
+            m_fromMono = floatMonoToStereo;
+        }
+        else
+        {
+            m_toMono = toMonoGeneric<float>;
+            m_fromMono = fromMonoGeneric<float>;
+        }
+        break;
+    case QAudioFormat::Int32:
+        m_toMono = toMonoGeneric<qint32>;
+        m_fromMono = fromMonoGeneric<qint32>;
+        break;
+    case QAudioFormat::UInt8:
+        m_toMono = toMonoGeneric<quint8>;
+        m_fromMono = fromMonoGeneric<quint8>;
+        break;
+    default:
+        m_bytesPerFrame = 0;
+        break;
+    }
+}
+
+bool SampleFormatConverter::isValid() const
+{
+    return m_toMono && m_bytesPerFrame > 0;
+}
+
+int SampleFormatConverter::bytesPerFrame() const
+{
+    return m_bytesPerFrame;
+}
+
+int SampleFormatConverter::toMono(QSpan<const char> in, QSpan<qint16> out) const
+{
+    if (!isValid())
+        return 0;
+
+    const int frames = qMin(static_cast<int>(in.size()) / m_bytesPerFrame, static_cast<int>(out.size()));
+    if (frames > 0)
+        m_toMono(in.data(), frames, m_channels, out.data());
+    return qMax(0, frames);
+}
+
+void SampleFormatConverter::appendFromMono(QSpan<const qint16> in, QByteArray& out) const
+{
+    if (!isValid() || in.isEmpty())
+        return;
+
+    const int offset = out.size();
+    out.resize(offset + static_cast<int>(in.size()) * m_bytesPerFrame);
+    m_fromMono(in.data(), static_cast<int>(in.size()), m_channels, out.data() + offset);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QAudioFormat>
+#include <QByteArray>
+#include <QSpan>
+#include <QtGlobal>
+
+// Converts between the app's mono int16 PCM and a device's interleaved
+// format. The kernel for the (sample format, channel count) pair is picked
+// once in setFormat() instead of being switched on per sample.
+class SampleFormatConverter
+{
+public:
+    void setFormat(const QAudioFormat& format);
+    bool isValid() const;
+    int bytesPerFrame() const;
+
+    // Downmixes whole device frames from in; returns the samples written,
+    // bounded by out.size().
+    int toMono(QSpan<const char> in, QSpan<qint16> out) const;
+    // Appends mono in expanded to every device channel; out keeps its
+    // capacity across calls.
+    void appendFromMono(QSpan<const qint16> in, QByteArray& out) const;
+
+private:
+    using ToMonoFn = void (*)(const char* in, int frames, int channels, qint16* out);
+    using FromMonoFn = void (*)(const qint16* in, int frames, int channels, char* out);
+
+    ToMonoFn m_toMono = nullptr;
+    FromMonoFn m_fromMono = nullptr;
+    int m_channels = 1;
+    int m_bytesPerFrame = 0;
+};
@@ -0,0 +1,87 @@
+#include "SampleRing.h"
+
+#include <algorithm>
+
+void SampleRing::reserve(int capacity)
+{
+    if (capacity <= m_buffer.size())
+        return;
+
+    QVector<qint16> grown(capacity, 0);
+    const int count = read(QSpan<qint16>(grown));
+    m_buffer.swap(grown);
+    m_head = 0;
+    m_size = count;
+}
+
+void SampleRing::clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+int SampleRing::size() const
+{
+    return m_size;
+}
+
+bool SampleRing::isEmpty() const
+{
+    return m_size == 0;
+}
+
+int SampleRing::capacity() const
+{
+    return m_buffer.size();
+}
+
+void SampleRing::write(QSpan<const qint16> samples)
+{
+    const int count = static_cast<int>(samples.size());
+    if (count <= 0)
+        return;
+    if (m_size + count > m_buffer.size())
+        reserve(qMax(m_size + count, m_buffer.size() * 2));
+
+    const int capacity = m_buffer.size();
+    int tail = m_head + m_size;
+    if (tail >= capacity)
+        tail -= capacity;
+    const int firstPart = qMin(count, capacity - tail);
+    qint16* data = m_buffer.data();
+    std::copy_n(samples.data(), firstPart, data + tail);
+    std::copy_n(samples.data() + firstPart, count - firstPart, data);
+    m_size += count;
+}
+
+int SampleRing::read(QSpan<qint16> out)
+{
+    const int count = qMin(m_size, static_cast<int>(out.size()));
+    if (count <= 0)
+        return 0;
+
+    const int capacity = m_buffer.size();
+    const int firstPart = qMin(count, capacity - m_head);
+    const qint16* data = m_buffer.constData();
+    std::copy_n(data + m_head, firstPart, out.data());
+    std::copy_n(data, count - firstPart, out.data() + firstPart);
+    m_head += count;
+    if (m_head >= capacity)
+        m_head -= capacity;
+    m_size -= count;
+    if (m_size == 0)
+        m_head = 0;
+    return count;
+}
+
+int SampleRing::discard(int count)
+{
+    count = qBound(0, count, m_size);
+    m_head += count;
+    if (m_head >= m_buffer.size())
+        m_head -= m_buffer.size();
+    m_size -= count;
+    if (m_size == 0)
+        m_head = 0;
+    return count;
+}
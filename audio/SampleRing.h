@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QSpan>
+#include <QVector>
+#include <QtGlobal>
+
+// Single-threaded FIFO of int16 samples. Storage only grows, so once sized
+// for the largest burst, reads and writes never allocate.
+class SampleRing
+{
+public:
+    void reserve(int capacity);
+    void clear();
+
+    int size() const;
+    bool isEmpty() const;
+    int capacity() const;
+
+    void write(QSpan<const qint16> samples);
+    int read(QSpan<qint16> out);
+    // Drops up to count of the oldest samples; returns how many were dropped.
+    int discard(int count);
+
+private:
+    QVector<qint16> m_buffer;
+    int m_head = 0;
+    int m_size = 0;
+};
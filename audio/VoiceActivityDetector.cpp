@@ -0,0 +1,126 @@
+#include "VoiceActivityDetector.h"
+
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Frames classified as speech while the noise floor is first learned.
+constexpr int kWarmupFrames = 10;
+constexpr float kSpeechBandLowHz = 300.0f;
+constexpr float kSpeechBandHighHz = 3400.0f;
+// Below this the input is treated as silence regardless of the floor.
+constexpr float kAbsoluteFloorDb = 25.0f;
+constexpr float kLoudSnrDb = 12.0f;
+constexpr float kVoicedSnrDb = 5.0f;
+// Speech is harmonic; steady noise has a flat spectrum near 1.
+constexpr float kVoicedFlatness = 0.3f;
+// The floor falls quickly and climbs slowly (about 2.5 dB/s at 20 ms),
+// faster while the frame looks like noise so a new fan or engine is learned
+// within a second or two.
+constexpr float kFloorFall = 0.2f;
+constexpr float kFloorRiseDbPerFrame = 0.05f;
+constexpr float kNoiseFloorRiseDbPerFrame = 0.5f;
+constexpr float kNoiseFlatness = 0.45f;
+}
+
+void VoiceActivityDetector::configure(int sampleRate, int frameSamples)
+{
+    if (sampleRate <= 0 || frameSamples <= 0)
+        return;
+    if (sampleRate == m_sampleRate && frameSamples == m_frameSamples)
+        return;
+
+    m_sampleRate = sampleRate;
+    m_frameSamples = frameSamples;
+    int fftSize = 4;
+    while (fftSize < frameSamples)
+        fftSize <<= 1;
+    m_fft.setSize(fftSize);
+
+    m_window.resize(frameSamples);
+    for (int n = 0; n < frameSamples; ++n)
+        m_window[n] = static_cast<float>(0.5 - 0.5 * qCos(2.0 * M_PI * n / frameSamples));
+    m_frame.resize(fftSize);
+    m_spectrum.resize(2 * m_fft.bins());
+
+    const float binHz = static_cast<float>(sampleRate) / fftSize;
+    m_lowBin = qBound(1, static_cast<int>(kSpeechBandLowHz / binHz), m_fft.bins() - 1);
+    m_highBin = qBound(m_lowBin + 1, static_cast<int>(kSpeechBandHighHz / binHz), m_fft.bins());
+    setHangoverMs(m_hangoverMs);
+    reset();
+}
+
+void VoiceActivityDetector::setHangoverMs(int ms)
+{
+    m_hangoverMs = qMax(0, ms);
+    const int frameMs = m_sampleRate > 0 ? qMax(1, (m_frameSamples * 1000) / m_sampleRate) : 20;
+    m_hangoverFrames = (m_hangoverMs + frameMs - 1) / frameMs;
+}
+
+void VoiceActivityDetector::reset()
+{
+    m_hangoverLeft = 0;
+    m_framesSeen = 0;
+    m_noiseDb = 0.0f;
+    m_speech = true;
+}
+
+bool VoiceActivityDetector::process(QSpan<const qint16> frame)
+{
+    if (m_frameSamples <= 0 || frame.isEmpty())
+        return m_speech;
+
+    const int count = qMin(static_cast<int>(frame.size()), m_frameSamples);
+    double energy = 0.0;
+    for (int n = 0; n < count; ++n)
+    {
+        const float v = static_cast<float>(frame[n]);
+        energy += static_cast<double>(v) * v;
+        m_frame[n] = v * m_window.at(n);
+    }
+    std::fill(m_frame.begin() + count, m_frame.end(), 0.0f);
+    const float energyDb = static_cast<float>(10.0 * std::log10(energy / count + 1.0));
+
+    m_fft.forward(m_frame.constData(), m_spectrum.data());
+    double logSum = 0.0;
+    double linearSum = 0.0;
+    for (int k = m_lowBin; k < m_highBin; ++k)
+    {
+        const double re = m_spectrum.at(2 * k);
+        const double im = m_spectrum.at(2 * k + 1);
+        const double power = re * re + im * im + 1.0;
+        logSum += std::log(power);
+        linearSum += power;
+    }
+    const int bandBins = m_highBin - m_lowBin;
+    const float flatness = static_cast<float>(std::exp(logSum / bandBins) / (linearSum / bandBins));
+
+    if (m_framesSeen == 0 || energyDb < m_noiseDb)
+        m_noiseDb += (energyDb - m_noiseDb) * (m_framesSeen == 0 ? 1.0f : kFloorFall);
+    else
+        m_noiseDb += qMin(flatness > kNoiseFlatness ? kNoiseFloorRiseDbPerFrame : kFloorRiseDbPerFrame,
+                          (energyDb - m_noiseDb) * 0.02f);
+
+    const float snrDb = energyDb - m_noiseDb;
+    bool voiced = energyDb >= kAbsoluteFloorDb &&
+                  (snrDb > kLoudSnrDb || (snrDb > kVoicedSnrDb && flatness < kVoicedFlatness));
+    if (m_framesSeen < kWarmupFrames)
+    {
+        ++m_framesSeen;
+        voiced = true;
+    }
+
+    if (voiced)
+        m_hangoverLeft = m_hangoverFrames;
+    else if (m_hangoverLeft > 0)
+        --m_hangoverLeft;
+    m_speech = voiced || m_hangoverLeft > 0;
+    return m_speech;
+}
+
+bool VoiceActivityDetector::isSpeech() const
+{
+    return m_speech;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QSpan>
+#include <QVector>
+#include <QtGlobal>
+
+#include "audio/RealFft.h"
+
+// Per-frame speech/non-speech classifier for the capture stream. Combines
+// frame energy against a tracked noise floor with speech-band spectral
+// flatness, and holds the speech decision for a hangover after the last
+// voiced frame so word endings are not clipped.
+class VoiceActivityDetector
+{
+public:
+    void configure(int sampleRate, int frameSamples);
+    void setHangoverMs(int ms);
+    void reset();
+
+    // Classifies one capture frame, hangover included.
+    bool process(QSpan<const qint16> frame);
+    bool isSpeech() const;
+
+private:
+    RealFft m_fft;
+    QVector<float> m_window;
+    QVector<float> m_frame;
+    QVector<float> m_spectrum;
+    int m_sampleRate = 0;
+    int m_frameSamples = 0;
+    int m_lowBin = 1;
+    int m_highBin = 1;
+    int m_hangoverMs = 300;
+    int m_hangoverFrames = 15;
+    int m_hangoverLeft = 0;
+    int m_framesSeen = 0;
+    float m_noiseDb = 0.0f;
+    bool m_speech = true;
+};
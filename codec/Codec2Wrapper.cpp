@@ -2,19 +2,27 @@
 #include "net/packet.h"
 
 #include <QtGlobal>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QCoreApplication>
+#include <QHash>
 #include <QLibrary>
+#include <QMutex>
 #include <QMutexLocker>
+#include <QSettings>
+#include <QSpan>
 #include <QStringList>
 #include <QUrl>
 #include <QVector>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <utility>
@@ -30,6 +38,7 @@
 namespace
 {
 QString normalizeDynamicLibraryPath(const QString& path, QString* error);
+QString sharedLibraryKey(const QString& path);
 #if defined(Q_OS_ANDROID) && defined(INCOMUDON_USE_CODEC2)
 template <typename Fn>
 bool runGuardedCodec2InitCall(const char* callName, Fn&& fn);
@@ -47,12 +56,110 @@ bool runGuardedCodec2InitCall(const char* callName, Fn&& fn);
 #endif
 
 #ifdef INCOMUDON_USE_OPUS
+// One loaded opus runtime per file, shared by every Codec2Wrapper in the
+// process so RX streams do not reload and re-resolve the library.
+struct Codec2Wrapper::SharedOpusLibrary
+{
+    SharedOpusLibrary()
+    {
+        library.setLoadHints(QLibrary::ResolveAllSymbolsHint);
+    }
+
+    ~SharedOpusLibrary()
+    {
+        if (library.isLoaded())
+            library.unload();
+    }
+
+    static QMutex& registryMutex()
+    {
+        static QMutex mutex;
+        return mutex;
+    }
+
+    static QHash<QString, std::weak_ptr<SharedOpusLibrary>>& registry()
+    {
+        static QHash<QString, std::weak_ptr<SharedOpusLibrary>> libraries;
+        return libraries;
+    }
+
+    static std::shared_ptr<SharedOpusLibrary> acquire(const QString& candidate,
+                                                      QString* error,
+                                                      bool* symbolsMissing);
+
+    QLibrary library;
+    OpusEncoderCreateFn encoderCreate = nullptr;
+    OpusEncoderDestroyFn encoderDestroy = nullptr;
+    OpusEncodeFn encode = nullptr;
+    OpusEncoderCtlFn encoderCtl = nullptr;
+    OpusDecoderCreateFn decoderCreate = nullptr;
+    OpusDecoderDestroyFn decoderDestroy = nullptr;
+    OpusDecodeFn decode = nullptr;
+};
+
+std::shared_ptr<Codec2Wrapper::SharedOpusLibrary>
+Codec2Wrapper::SharedOpusLibrary::acquire(const QString& candidate,
+                                          QString* error,
+                                          bool* symbolsMissing)
+{
+    QMutexLocker<QMutex> locker(&registryMutex());
+    auto& libraries = registry();
+    const QString key = sharedLibraryKey(candidate);
+    if (std::shared_ptr<SharedOpusLibrary> existing = libraries.value(key).lock())
+        return existing;
+
+    auto shared = std::make_shared<SharedOpusLibrary>();
+    shared->library.setFileName(candidate);
+    if (!shared->library.load())
+    {
+        if (error)
+            *error = shared->library.errorString();
+        return nullptr;
+    }
+
+    shared->encoderCreate = reinterpret_cast<OpusEncoderCreateFn>(
+        shared->library.resolve("opus_encoder_create"));
+    shared->encoderDestroy = reinterpret_cast<OpusEncoderDestroyFn>(
+        shared->library.resolve("opus_encoder_destroy"));
+    shared->encode = reinterpret_cast<OpusEncodeFn>(
+        shared->library.resolve("opus_encode"));
+    shared->encoderCtl = reinterpret_cast<OpusEncoderCtlFn>(
+        shared->library.resolve("opus_encoder_ctl"));
+    shared->decoderCreate = reinterpret_cast<OpusDecoderCreateFn>(
+        shared->library.resolve("opus_decoder_create"));
+    shared->decoderDestroy = reinterpret_cast<OpusDecoderDestroyFn>(
+        shared->library.resolve("opus_decoder_destroy"));
+    shared->decode = reinterpret_cast<OpusDecodeFn>(
+        shared->library.resolve("opus_decode"));
+
+    const bool symbolsOk = shared->encoderCreate &&
+                           shared->encoderDestroy &&
+                           shared->encode &&
+                           shared->encoderCtl &&
+                           shared->decoderCreate &&
+                           shared->decoderDestroy &&
+                           shared->decode;
+    if (!symbolsOk)
+    {
+        if (symbolsMissing)
+            *symbolsMissing = true;
+        return nullptr;
+    }
+
+    for (auto it = libraries.begin(); it != libraries.end();)
+    {
+        if (it.value().expired())
+            it = libraries.erase(it);
+        else
+            ++it;
+    }
+    libraries.insert(key, shared);
+    return shared;
+}
+
 void Codec2Wrapper::unloadOpusLibrary()
 {
-    if (!m_opusLibrary)
-        return;
-    if (m_opusLibrary->isLoaded())
-        m_opusLibrary->unload();
+    m_opusShared.reset();
 }
 
 void Codec2Wrapper::clearOpusApi()
@@ -90,8 +197,6 @@ void Codec2Wrapper::setOpusLibraryErrorInternal(const QString& error)
 void Codec2Wrapper::refreshOpusLibrary()
 {
     QMutexLocker<QRecursiveMutex> locker(&m_mutex);
-    if (!m_opusLibrary)
-        return;
 
     clearOpusApi();
     unloadOpusLibrary();
@@ -147,74 +252,52 @@ void Codec2Wrapper::refreshOpusLibrary()
 #endif
     }
 
-    QString loadedCandidate;
     QString loadError;
     for (const QString& candidate : std::as_const(loadCandidates))
     {
         if (candidate.trimmed().isEmpty())
             continue;
-        m_opusLibrary->setFileName(candidate);
-        if (m_opusLibrary->load())
-        {
-            loadedCandidate = candidate;
-            break;
-        }
-        loadError = m_opusLibrary->errorString();
-    }
 
-    if (loadedCandidate.isEmpty())
-    {
-        setOpusLibraryLoadedInternal(false);
-        if (explicitPath)
-        {
-            setOpusLibraryErrorInternal(QStringLiteral("Failed to load opus library: %1")
-                                            .arg(loadError));
-        }
-        else
+        bool symbolsMissing = false;
+        std::shared_ptr<SharedOpusLibrary> shared =
+            SharedOpusLibrary::acquire(candidate, &loadError, &symbolsMissing);
+        if (symbolsMissing)
         {
-#ifndef INCOMUDON_USE_OPUS_LINKED
-            setOpusLibraryErrorInternal(QStringLiteral("Failed to load bundled opus runtime library"));
-#else
-            setOpusLibraryErrorInternal(QString());
-#endif
+            setOpusLibraryLoadedInternal(false);
+            setOpusLibraryErrorInternal(
+                QStringLiteral("Required opus symbols were not found in: %1").arg(candidate));
+            return;
         }
-        return;
-    }
+        if (!shared)
+            continue;
 
-    m_opusEncoderCreate = reinterpret_cast<OpusEncoderCreateFn>(
-        m_opusLibrary->resolve("opus_encoder_create"));
-    m_opusEncoderDestroy = reinterpret_cast<OpusEncoderDestroyFn>(
-        m_opusLibrary->resolve("opus_encoder_destroy"));
-    m_opusEncode = reinterpret_cast<OpusEncodeFn>(
-        m_opusLibrary->resolve("opus_encode"));
-    m_opusEncoderCtl = reinterpret_cast<OpusEncoderCtlFn>(
-        m_opusLibrary->resolve("opus_encoder_ctl"));
-    m_opusDecoderCreate = reinterpret_cast<OpusDecoderCreateFn>(
-        m_opusLibrary->resolve("opus_decoder_create"));
-    m_opusDecoderDestroy = reinterpret_cast<OpusDecoderDestroyFn>(
-        m_opusLibrary->resolve("opus_decoder_destroy"));
-    m_opusDecode = reinterpret_cast<OpusDecodeFn>(
-        m_opusLibrary->resolve("opus_decode"));
-
-    const bool symbolsOk = m_opusEncoderCreate &&
-                           m_opusEncoderDestroy &&
-                           m_opusEncode &&
-                           m_opusEncoderCtl &&
-                           m_opusDecoderCreate &&
-                           m_opusDecoderDestroy &&
-                           m_opusDecode;
-    if (symbolsOk)
-    {
+        m_opusShared = shared;
+        m_opusEncoderCreate = shared->encoderCreate;
+        m_opusEncoderDestroy = shared->encoderDestroy;
+        m_opusEncode = shared->encode;
+        m_opusEncoderCtl = shared->encoderCtl;
+        m_opusDecoderCreate = shared->decoderCreate;
+        m_opusDecoderDestroy = shared->decoderDestroy;
+        m_opusDecode = shared->decode;
         setOpusLibraryLoadedInternal(true);
         setOpusLibraryErrorInternal(QString());
         return;
     }
 
-    clearOpusApi();
-    unloadOpusLibrary();
     setOpusLibraryLoadedInternal(false);
-    setOpusLibraryErrorInternal(
-        QStringLiteral("Required opus symbols were not found in: %1").arg(loadedCandidate));
+    if (explicitPath)
+    {
+        setOpusLibraryErrorInternal(QStringLiteral("Failed to load opus library: %1")
+                                        .arg(loadError));
+    }
+    else
+    {
+#ifndef INCOMUDON_USE_OPUS_LINKED
+        setOpusLibraryErrorInternal(QStringLiteral("Failed to load bundled opus runtime library"));
+#else
+        setOpusLibraryErrorInternal(QString());
+#endif
+    }
 }
 #endif
 
@@ -232,6 +315,8 @@ constexpr int kCodec2Mode1600 = 2;
 constexpr int kCodec2Mode700C = 8;
 constexpr int kCodec2Mode450 = 10;
 constexpr int kIncomUdonCodec2AbiVersion = 2026022801;
+// Roughly one second of TX+RX frames before a library is trusted.
+constexpr int kCodec2GuardedWarmupCalls = 100;
 #endif
 
 #ifdef INCOMUDON_USE_CODEC2
@@ -240,6 +325,89 @@ QRecursiveMutex& codec2ApiMutex()
     static QRecursiveMutex mutex;
     return mutex;
 }
+
+#if defined(Q_OS_ANDROID)
+// Only the Android signal guard uses stored verdicts, so only Android pays
+// for hashing the library.
+QString codec2LibraryFingerprint(const QString& path)
+{
+    const QFileInfo info(path);
+    if (!info.isFile())
+        return QString();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file))
+        return QString();
+
+    return QStringLiteral("%1-%2-%3")
+        .arg(QString::fromLatin1(hash.result().toHex()))
+        .arg(info.size())
+        .arg(info.lastModified().toMSecsSinceEpoch());
+}
+#endif
+
+QString codec2VerdictKey(const QString& fingerprint, int codecMode)
+{
+    return QStringLiteral("codec2Verdicts/%1/mode%2").arg(fingerprint).arg(codecMode);
+}
+
+bool codec2VerdictTrusted(const QString& fingerprint, int codecMode)
+{
+    if (fingerprint.isEmpty())
+        return false;
+    QSettings settings;
+    return settings.value(codec2VerdictKey(fingerprint, codecMode), false).toBool();
+}
+
+void storeCodec2Verdict(const QString& fingerprint, int codecMode, bool trusted)
+{
+    if (fingerprint.isEmpty())
+        return;
+    QSettings settings;
+    if (trusted)
+        settings.setValue(codec2VerdictKey(fingerprint, codecMode), true);
+    else
+        settings.remove(codec2VerdictKey(fingerprint, codecMode));
+}
+
+QString codec2ProbeKey(const QString& fingerprint, int codecMode)
+{
+    return QStringLiteral("codec2Probes/%1/mode%2").arg(fingerprint).arg(codecMode);
+}
+
+void codec2ModeSymbolNames(int codecMode, const char** encodeName, const char** decodeName)
+{
+    *encodeName = nullptr;
+    *decodeName = nullptr;
+    switch (codecMode)
+    {
+    case kCodec2Mode3200:
+        *encodeName = "codec2_encode_3200";
+        *decodeName = "codec2_decode_3200";
+        break;
+    case kCodec2Mode2400:
+        *encodeName = "codec2_encode_2400";
+        *decodeName = "codec2_decode_2400";
+        break;
+    case kCodec2Mode1600:
+        *encodeName = "codec2_encode_1600";
+        *decodeName = "codec2_decode_1600";
+        break;
+    case kCodec2Mode700C:
+        *encodeName = "codec2_encode_700c";
+        *decodeName = "codec2_decode_700c";
+        break;
+    case kCodec2Mode450:
+        *encodeName = "codec2_encode_450";
+        *decodeName = "codec2_decode_450";
+        break;
+    default:
+        break;
+    }
+}
 #endif
 
 void logCodec2Status(const char* fmt, ...)
@@ -794,26 +962,312 @@ QString normalizeDynamicLibraryPath(const QString& path, QString* error)
 #endif
     return QDir::toNativeSeparators(trimmed);
 }
+
+// A rebuilt library dropped over the same path must not reuse the handle
+// loaded from the old file, so the registries key on size and mtime too.
+QString sharedLibraryKey(const QString& path)
+{
+    const QFileInfo info(path);
+    if (!info.isFile())
+        return path;
+    return QStringLiteral("%1|%2|%3")
+        .arg(path)
+        .arg(info.size())
+        .arg(info.lastModified().toMSecsSinceEpoch());
+}
 }
 
-Codec2Wrapper::Codec2Wrapper(QObject* parent)
+#ifdef INCOMUDON_USE_CODEC2
+// One loaded codec2 runtime per file. Symbol resolution, relocation patching,
+// ABI and init probes run once per process, and per-mode probe verdicts are
+// kept here so new RX streams can skip the encode/decode probes.
+struct Codec2Wrapper::SharedCodec2Library
+{
+    struct ModeProbe
+    {
+        bool ok = false;
+        Codec2EncodeFn encode = nullptr;
+        Codec2DecodeFn decode = nullptr;
+    };
+
+    SharedCodec2Library()
+    {
+        // Runtime-loaded codec2 builds can crash on first PLT call on some Android
+        // linkers when loaded lazily. Force eager resolution (RTLD_NOW-like).
+        library.setLoadHints(QLibrary::ResolveAllSymbolsHint);
+    }
+
+    ~SharedCodec2Library()
+    {
+#if defined(Q_OS_ANDROID)
+        if (dlHandle)
+        {
+            dlclose(dlHandle);
+            dlHandle = nullptr;
+        }
+#endif
+        if (library.isLoaded())
+            library.unload();
+    }
+
+    static QHash<QString, std::weak_ptr<SharedCodec2Library>>& registry()
+    {
+        static QHash<QString, std::weak_ptr<SharedCodec2Library>> libraries;
+        return libraries;
+    }
+
+    static std::shared_ptr<SharedCodec2Library> acquire(const QString& candidate,
+                                                        QString* error,
+                                                        bool* incompatible);
+
+    QFunctionPointer resolve(const char* name)
+    {
+        if (!name || name[0] == '\0')
+            return nullptr;
+#if defined(Q_OS_ANDROID)
+        if (dlHandle)
+            return reinterpret_cast<QFunctionPointer>(dlsym(dlHandle, name));
+        return nullptr;
+#else
+        return library.resolve(name);
+#endif
+    }
+
+    QLibrary library;
+#if defined(Q_OS_ANDROID)
+    void* dlHandle = nullptr;
+#endif
+    QString fingerprint;
+    Codec2CreateFn create = nullptr;
+    Codec2DestroyFn destroy = nullptr;
+    Codec2EncodeFn encode = nullptr;
+    Codec2DecodeFn decode = nullptr;
+    Codec2BitsPerFrameFn bitsPerFrame = nullptr;
+    Codec2SamplesPerFrameFn samplesPerFrame = nullptr;
+    Codec2AbiVersionFn abiVersion = nullptr;
+    // Rebuilds a passing verdict stored by an earlier launch for this exact
+    // file (hash, size and mtime), so the encode/decode probes can be skipped.
+    bool restoreModeProbe(int codecMode, ModeProbe* probe)
+    {
+        if (fingerprint.isEmpty())
+            return false;
+
+        QSettings settings;
+        const QString entry = settings.value(codec2ProbeKey(fingerprint, codecMode)).toString();
+        ModeProbe restored;
+        if (entry == QStringLiteral("generic"))
+        {
+            restored.encode = encode;
+            restored.decode = decode;
+        }
+        else if (entry == QStringLiteral("mode"))
+        {
+            const char* encodeName = nullptr;
+            const char* decodeName = nullptr;
+            codec2ModeSymbolNames(codecMode, &encodeName, &decodeName);
+            restored.encode = reinterpret_cast<Codec2EncodeFn>(resolve(encodeName));
+            restored.decode = reinterpret_cast<Codec2DecodeFn>(resolve(decodeName));
+        }
+        if (!restored.encode || !restored.decode)
+            return false;
+
+        restored.ok = true;
+        modeProbes.insert(codecMode, restored);
+        *probe = restored;
+        return true;
+    }
+
+    void storeModeProbe(int codecMode, const ModeProbe& probe)
+    {
+        modeProbes.insert(codecMode, probe);
+        if (fingerprint.isEmpty())
+            return;
+
+        // Failures are not persisted so a later launch probes again.
+        QSettings settings;
+        const QString key = codec2ProbeKey(fingerprint, codecMode);
+        if (!probe.ok)
+            settings.remove(key);
+        else if (probe.encode == encode && probe.decode == decode)
+            settings.setValue(key, QStringLiteral("generic"));
+        else
+            settings.setValue(key, QStringLiteral("mode"));
+    }
+
+    QHash<int, ModeProbe> modeProbes;
+};
+
+std::shared_ptr<Codec2Wrapper::SharedCodec2Library>
+Codec2Wrapper::SharedCodec2Library::acquire(const QString& candidate,
+                                            QString* error,
+                                            bool* incompatible)
+{
+    QMutexLocker<QRecursiveMutex> apiLocker(&codec2ApiMutex());
+    auto& libraries = registry();
+    const QString key = sharedLibraryKey(candidate);
+    if (std::shared_ptr<SharedCodec2Library> existing = libraries.value(key).lock())
+        return existing;
+
+    auto shared = std::make_shared<SharedCodec2Library>();
+#if defined(Q_OS_ANDROID)
+    QByteArray candidateBytes = QFile::encodeName(candidate);
+    dlerror();
+    shared->dlHandle = dlopen(candidateBytes.constData(), RTLD_NOW | RTLD_GLOBAL);
+    if (!shared->dlHandle)
+    {
+        const char* globalErr = dlerror();
+        const QString globalErrText = globalErr
+                                          ? QString::fromUtf8(globalErr)
+                                          : QStringLiteral("dlopen failed (RTLD_NOW|RTLD_GLOBAL)");
+        dlerror();
+        shared->dlHandle = dlopen(candidateBytes.constData(), RTLD_NOW | RTLD_LOCAL);
+        if (!shared->dlHandle)
+        {
+            const char* localErr = dlerror();
+            const QString localErrText = localErr
+                                             ? QString::fromUtf8(localErr)
+                                             : QStringLiteral("dlopen failed (RTLD_NOW|RTLD_LOCAL)");
+            if (error)
+            {
+                *error = QStringLiteral("RTLD_GLOBAL: %1 / RTLD_LOCAL: %2")
+                             .arg(globalErrText, localErrText);
+            }
+            return nullptr;
+        }
+    }
+#else
+    shared->library.setFileName(candidate);
+    if (!shared->library.load())
+    {
+        if (error)
+            *error = shared->library.errorString();
+        return nullptr;
+    }
+#endif
+    shared->create = reinterpret_cast<Codec2CreateFn>(shared->resolve("codec2_create"));
+    shared->destroy = reinterpret_cast<Codec2DestroyFn>(shared->resolve("codec2_destroy"));
+    shared->encode = reinterpret_cast<Codec2EncodeFn>(shared->resolve("codec2_encode"));
+    shared->decode = reinterpret_cast<Codec2DecodeFn>(shared->resolve("codec2_decode"));
+    shared->bitsPerFrame = reinterpret_cast<Codec2BitsPerFrameFn>(shared->resolve("codec2_bits_per_frame"));
+    shared->samplesPerFrame = reinterpret_cast<Codec2SamplesPerFrameFn>(shared->resolve("codec2_samples_per_frame"));
+    shared->abiVersion = reinterpret_cast<Codec2AbiVersionFn>(shared->resolve("incomudon_codec2_abi_version"));
+
+#if defined(Q_OS_ANDROID)
+    const QFileInfo candidateInfo(candidate);
+    logCodec2Status("Codec2 candidate loaded: %s (size=%lld)",
+                    candidate.toUtf8().constData(),
+                    static_cast<long long>(candidateInfo.size()));
+    logCodec2Status("Codec2 symbols create=%p destroy=%p abi=%p",
+                    reinterpret_cast<void*>(shared->create),
+                    reinterpret_cast<void*>(shared->destroy),
+                    reinterpret_cast<void*>(shared->abiVersion));
+    if (shared->create)
+    {
+        Dl_info dlinfo {};
+        if (dladdr(reinterpret_cast<void*>(shared->create), &dlinfo) != 0 &&
+            dlinfo.dli_fname)
+        {
+            logCodec2Status("Codec2 dladdr create: base=%p sym=%p file=%s",
+                            dlinfo.dli_fbase,
+                            dlinfo.dli_saddr,
+                            dlinfo.dli_fname);
+
+            QString patchError;
+            int patchedSlots = 0;
+            if (patchAndroidJumpSlotsFromFile(candidate, dlinfo.dli_fbase, &patchError, &patchedSlots))
+            {
+                if (patchedSlots > 0)
+                {
+                    logCodec2Status("Codec2 relocation workaround applied: patched=%d",
+                                    patchedSlots);
+                }
+            }
+            else if (!patchError.isEmpty())
+            {
+                logCodec2Status("Codec2 relocation workaround skipped: %s",
+                                patchError.toUtf8().constData());
+            }
+        }
+    }
+#endif
+
+    const bool symbolsOk = (shared->create && shared->destroy &&
+                            shared->encode && shared->decode &&
+                            shared->bitsPerFrame && shared->samplesPerFrame &&
+                            shared->abiVersion);
+    if (!symbolsOk)
+    {
+        if (error)
+        {
+            *error = QStringLiteral(
+                "Required codec2 symbols were not found (including incomudon_codec2_abi_version): %1")
+                         .arg(candidate);
+        }
+        return nullptr;
+    }
+
+    const int abiVersion = shared->abiVersion();
+    if (abiVersion != kIncomUdonCodec2AbiVersion)
+    {
+        if (incompatible)
+            *incompatible = true;
+        if (error)
+        {
+            *error = QStringLiteral(
+                "codec2 ABI mismatch (expected %1, got %2)")
+                    .arg(kIncomUdonCodec2AbiVersion)
+                    .arg(abiVersion);
+        }
+        return nullptr;
+    }
+
+    CODEC2* probeCodec = nullptr;
+    const bool probeOk = runGuardedCodec2InitCall("codec2_create_probe", [&]() {
+        probeCodec = shared->create(kCodec2Mode1600);
+    });
+    if (!probeOk || probeCodec == nullptr)
+    {
+        if (incompatible)
+            *incompatible = true;
+        if (error)
+            *error = QStringLiteral("codec2 library crashed during probe (incompatible build)");
+        return nullptr;
+    }
+    runGuardedCodec2InitCall("codec2_destroy_probe", [&]() {
+        shared->destroy(probeCodec);
+    });
+
+#if defined(Q_OS_ANDROID)
+    shared->fingerprint = codec2LibraryFingerprint(candidate);
+#endif
+    for (auto it = libraries.begin(); it != libraries.end();)
+    {
+        if (it.value().expired())
+            it = libraries.erase(it);
+        else
+            ++it;
+    }
+    libraries.insert(key, shared);
+    return shared;
+}
+#endif
+
+Codec2Wrapper::Codec2Wrapper(QObject* parent, LibraryLoad load)
     : QObject(parent)
 {
+    const bool loadNow = (load == LibraryLoad::Immediate);
+    Q_UNUSED(loadNow)
 #ifdef INCOMUDON_USE_CODEC2
-    m_codec2Library = new QLibrary(this);
-    // Runtime-loaded codec2 builds can crash on first PLT call on some Android
-    // linkers when loaded lazily. Force eager resolution (RTLD_NOW-like).
-    m_codec2Library->setLoadHints(QLibrary::ResolveAllSymbolsHint);
-    refreshCodec2Library();
-    logCodec2Status("INCOMUDON_USE_CODEC2=1 (runtime load)");
+    if (loadNow)
+        refreshCodec2Library();
+    logCodec2Status("INCOMUDON_USE_CODEC2=1 (runtime load%s)", loadNow ? "" : ", deferred");
 #else
     m_codec2LibraryError = QStringLiteral("Codec2 support disabled at build time");
     logCodec2Status("INCOMUDON_USE_CODEC2=0 (disabled at build time)");
 #endif
 #ifdef INCOMUDON_USE_OPUS
-    m_opusLibrary = new QLibrary(this);
-    m_opusLibrary->setLoadHints(QLibrary::ResolveAllSymbolsHint);
-    refreshOpusLibrary();
+    if (loadNow)
+        refreshOpusLibrary();
 #else
     m_opusLibraryError = QStringLiteral("Opus support disabled at build time");
 #endif
@@ -831,8 +1285,6 @@ Codec2Wrapper::~Codec2Wrapper()
         m_codec = nullptr;
     }
     unloadCodec2Library();
-    delete m_codec2Library;
-    m_codec2Library = nullptr;
 #endif
 #ifdef INCOMUDON_USE_OPUS
     if (m_opusEncoder)
@@ -857,8 +1309,6 @@ Codec2Wrapper::~Codec2Wrapper()
     }
     m_opusUsingRuntimeApi = false;
     unloadOpusLibrary();
-    delete m_opusLibrary;
-    m_opusLibrary = nullptr;
 #endif
 }
 
@@ -1067,99 +1517,181 @@ QByteArray Codec2Wrapper::encode(const QByteArray& pcmFrame) const
     if (m_forcePcm || m_pcmFrameBytes <= 0)
         return pcmFrame;
 
+    QByteArray output(maxEncodedFrameBytes(), 0);
+    const int bytes = encode(QSpan<const qint16>(reinterpret_cast<const qint16*>(pcmFrame.constData()),
+                                                 pcmFrame.size() / static_cast<int>(sizeof(qint16))),
+                             QSpan<quint8>(reinterpret_cast<quint8*>(output.data()), output.size()));
+    if (bytes <= 0)
+        return QByteArray();
+    output.truncate(bytes);
+    return output;
+}
+
+QByteArray Codec2Wrapper::decode(const QByteArray& codecFrame) const
+{
+    QMutexLocker<QRecursiveMutex> locker(&m_mutex);
+    if (m_forcePcm || m_pcmFrameBytes <= 0)
+        return codecFrame;
+
+    QByteArray output(m_pcmFrameBytes, 0);
+    decode(QSpan<const quint8>(reinterpret_cast<const quint8*>(codecFrame.constData()),
+                               codecFrame.size()),
+           QSpan<qint16>(reinterpret_cast<qint16*>(output.data()),
+                         output.size() / static_cast<int>(sizeof(qint16))));
+    return output;
+}
+
+int Codec2Wrapper::maxEncodedFrameBytes() const
+{
+    QMutexLocker<QRecursiveMutex> locker(&m_mutex);
+    if (m_forcePcm || m_pcmFrameBytes <= 0)
+        return qMax(0, m_pcmFrameBytes);
 #ifdef INCOMUDON_USE_OPUS
-    if (m_opusActive && m_codecType == CodecTypeOpus && m_opusEncoder)
-    {
-        const int expectedSamples = m_pcmFrameBytes / static_cast<int>(sizeof(opus_int16));
-        QVector<opus_int16> inputSamples(expectedSamples, 0);
-        const int copyBytes = qMin(pcmFrame.size(), m_pcmFrameBytes);
+    if (m_opusActive && m_codecType == CodecTypeOpus)
+        return 512;
+#endif
+    return qMax(m_frameBytes, m_pcmFrameBytes);
+}
+
+int Codec2Wrapper::encode(QSpan<const qint16> pcmFrame, QSpan<quint8> out) const
+{
+    QMutexLocker<QRecursiveMutex> locker(&m_mutex);
+    const int pcmBytes = static_cast<int>(pcmFrame.size()) * static_cast<int>(sizeof(qint16));
+    const auto passThrough = [&]() {
+        const int copyBytes = qMin(pcmBytes, static_cast<int>(out.size()));
         if (copyBytes > 0)
-            std::memcpy(inputSamples.data(), pcmFrame.constData(), copyBytes);
+            std::memcpy(out.data(), pcmFrame.data(), copyBytes);
+        return copyBytes;
+    };
+    if (m_forcePcm || m_pcmFrameBytes <= 0)
+        return passThrough();
 
-        QByteArray output(512, 0);
+    const int expectedSamples = m_pcmFrameBytes / static_cast<int>(sizeof(qint16));
+    // Codec APIs want exactly one frame; pad short input into the scratch
+    // buffer, which only reallocates when the frame size changes.
+    const qint16* input = pcmFrame.data();
+    if (pcmFrame.size() < expectedSamples)
+    {
+        if (m_encodeScratch.size() != expectedSamples)
+            m_encodeScratch.resize(expectedSamples);
+        const int copySamples = static_cast<int>(pcmFrame.size());
+        if (copySamples > 0)
+            std::memcpy(m_encodeScratch.data(), pcmFrame.data(), copySamples * sizeof(qint16));
+        std::fill(m_encodeScratch.begin() + copySamples, m_encodeScratch.end(), qint16(0));
+        input = m_encodeScratch.constData();
+    }
+
+#ifdef INCOMUDON_USE_OPUS
+    if (m_opusActive && m_codecType == CodecTypeOpus && m_opusEncoder)
+    {
         int encodedBytes = -1;
         if (m_opusUsingRuntimeApi && m_opusEncode)
         {
             encodedBytes = m_opusEncode(m_opusEncoder,
-                                        inputSamples.constData(),
+                                        input,
                                         expectedSamples,
-                                        reinterpret_cast<unsigned char*>(output.data()),
-                                        output.size());
+                                        out.data(),
+                                        static_cast<int>(out.size()));
         }
 #ifdef INCOMUDON_USE_OPUS_LINKED
         else
         {
             encodedBytes = opus_encode(m_opusEncoder,
-                                       inputSamples.constData(),
+                                       input,
                                        expectedSamples,
-                                       reinterpret_cast<unsigned char*>(output.data()),
-                                       output.size());
+                                       out.data(),
+                                       static_cast<int>(out.size()));
         }
 #endif
-        if (encodedBytes <= 0)
-            return QByteArray();
-        output.truncate(encodedBytes);
-        return output;
+        return encodedBytes > 0 ? encodedBytes : 0;
     }
 #endif
 
 #ifdef INCOMUDON_USE_CODEC2
     if (!m_codec || m_frameBytes <= 0)
-        return pcmFrame;
+        return passThrough();
 
     Codec2EncodeFn encodeFn = m_codec2EncodeActive ? m_codec2EncodeActive : m_codec2Encode;
     if (!encodeFn)
-        return pcmFrame;
-
-    const int samples = m_pcmFrameBytes / static_cast<int>(sizeof(short));
-    QVector<short> inputSamples(samples);
+        return passThrough();
+    if (out.size() < static_cast<qsizetype>(m_frameBytes))
+        return 0;
 
-    const int copyBytes = qMin(pcmFrame.size(), m_pcmFrameBytes);
-    if (copyBytes > 0)
-        std::memcpy(inputSamples.data(), pcmFrame.constData(), copyBytes);
-    if (copyBytes < m_pcmFrameBytes)
-        std::memset(reinterpret_cast<char*>(inputSamples.data()) + copyBytes, 0,
-                    m_pcmFrameBytes - copyBytes);
+    // codec2_encode takes a non-const pointer, so always hand it the scratch copy.
+    if (input != m_encodeScratch.constData())
+    {
+        if (m_encodeScratch.size() != expectedSamples)
+            m_encodeScratch.resize(expectedSamples);
+        std::memcpy(m_encodeScratch.data(), input, expectedSamples * sizeof(qint16));
+    }
 
-    QByteArray output(m_frameBytes, 0);
+    // Trusted calls skip only the signal guard. codec2 is not known to be
+    // safe across instances on different threads (TX encodes on its own
+    // thread while RX decodes), so every call stays serialized.
     bool encodeOk = true;
+    const bool guarded = m_codec2GuardedCallsLeft > 0;
     {
         QMutexLocker<QRecursiveMutex> apiLocker(&codec2ApiMutex());
-        encodeOk = runGuardedCodec2Call("codec2_encode", [&]() {
-            encodeFn(m_codec,
-                     reinterpret_cast<unsigned char*>(output.data()),
-                     inputSamples.data());
-        });
+        if (guarded)
+        {
+            encodeOk = runGuardedCodec2Call("codec2_encode", [&]() {
+                encodeFn(m_codec, out.data(), m_encodeScratch.data());
+            });
+        }
+        else
+        {
+            encodeFn(m_codec, out.data(), m_encodeScratch.data());
+        }
     }
-    if (!encodeOk)
-        return QByteArray();
-    return output;
+    if (guarded)
+        noteGuardedCodec2Call(encodeOk);
+    return encodeOk ? m_frameBytes : 0;
 #else
-    return pcmFrame;
+    return passThrough();
 #endif
 }
 
-QByteArray Codec2Wrapper::decode(const QByteArray& codecFrame) const
+int Codec2Wrapper::decode(QSpan<const quint8> codecFrame, QSpan<qint16> out) const
 {
     QMutexLocker<QRecursiveMutex> locker(&m_mutex);
+    const auto passThrough = [&]() {
+        const int copySamples = qMin(static_cast<int>(codecFrame.size()) / static_cast<int>(sizeof(qint16)),
+                                     static_cast<int>(out.size()));
+        if (copySamples > 0)
+            std::memcpy(out.data(), codecFrame.data(), copySamples * sizeof(qint16));
+        return copySamples;
+    };
     if (m_forcePcm || m_pcmFrameBytes <= 0)
-        return codecFrame;
+        return passThrough();
+
+    const int expectedSamples = m_pcmFrameBytes / static_cast<int>(sizeof(qint16));
+    if (m_decodeScratch.size() != expectedSamples)
+        m_decodeScratch.resize(expectedSamples);
+    // Decode straight into the caller's buffer when it can hold a full frame.
+    qint16* target = out.size() >= static_cast<qsizetype>(expectedSamples)
+        ? out.data()
+        : m_decodeScratch.data();
+    const auto finish = [&](int decodedSamples) {
+        const int produced = qBound(0, decodedSamples, expectedSamples);
+        if (produced < expectedSamples)
+            std::fill(target + produced, target + expectedSamples, qint16(0));
+        const int outSamples = qMin(expectedSamples, static_cast<int>(out.size()));
+        if (target != out.data() && outSamples > 0)
+            std::memcpy(out.data(), target, outSamples * sizeof(qint16));
+        return outSamples;
+    };
 
 #ifdef INCOMUDON_USE_OPUS
     if (m_opusActive && m_codecType == CodecTypeOpus && m_opusDecoder)
     {
-        const int expectedSamples = m_pcmFrameBytes / static_cast<int>(sizeof(opus_int16));
-        QVector<opus_int16> outputSamples(expectedSamples, 0);
         int decodedSamples = -1;
         if (m_opusUsingRuntimeApi && m_opusDecode)
         {
             decodedSamples = m_opusDecode(
                 m_opusDecoder,
-                codecFrame.isEmpty()
-                    ? nullptr
-                    : reinterpret_cast<const unsigned char*>(codecFrame.constData()),
-                codecFrame.size(),
-                outputSamples.data(),
+                codecFrame.empty() ? nullptr : codecFrame.data(),
+                static_cast<int>(codecFrame.size()),
+                target,
                 expectedSamples,
                 0);
         }
@@ -1168,62 +1700,131 @@ QByteArray Codec2Wrapper::decode(const QByteArray& codecFrame) const
         {
             decodedSamples = opus_decode(
                 m_opusDecoder,
-                codecFrame.isEmpty()
-                    ? nullptr
-                    : reinterpret_cast<const unsigned char*>(codecFrame.constData()),
-                codecFrame.size(),
-                outputSamples.data(),
+                codecFrame.empty() ? nullptr : codecFrame.data(),
+                static_cast<int>(codecFrame.size()),
+                target,
                 expectedSamples,
                 0);
         }
 #endif
-
-        QByteArray output(m_pcmFrameBytes, 0);
-        if (decodedSamples <= 0)
-            return output;
-
-        const int copySamples = qMin(decodedSamples, expectedSamples);
-        const int copyBytes = copySamples * static_cast<int>(sizeof(opus_int16));
-        if (copyBytes > 0)
-            std::memcpy(output.data(), outputSamples.constData(), copyBytes);
-        return output;
+        return finish(decodedSamples);
     }
 #endif
 
 #ifdef INCOMUDON_USE_CODEC2
     if (!m_codec || m_frameBytes <= 0)
-        return QByteArray(m_pcmFrameBytes, 0);
+        return finish(0);
 
     Codec2DecodeFn decodeFn = m_codec2DecodeActive ? m_codec2DecodeActive : m_codec2Decode;
     if (!decodeFn)
-        return QByteArray(m_pcmFrameBytes, 0);
+        return finish(0);
 
-    QByteArray input = codecFrame;
-    if (input.size() < m_frameBytes)
-        input.append(QByteArray(m_frameBytes - input.size(), 0));
-    else if (input.size() > m_frameBytes)
-        input.truncate(m_frameBytes);
+    const quint8* input = codecFrame.data();
+    if (codecFrame.size() < static_cast<qsizetype>(m_frameBytes))
+    {
+        if (m_decodeInputScratch.size() != m_frameBytes)
+            m_decodeInputScratch.resize(m_frameBytes);
+        const int copyBytes = static_cast<int>(codecFrame.size());
+        if (copyBytes > 0)
+            std::memcpy(m_decodeInputScratch.data(), codecFrame.data(), copyBytes);
+        std::fill(m_decodeInputScratch.begin() + copyBytes, m_decodeInputScratch.end(), quint8(0));
+        input = m_decodeInputScratch.constData();
+    }
 
-    const int samples = m_pcmFrameBytes / static_cast<int>(sizeof(short));
-    QVector<short> outputSamples(samples);
+    // Serialized like encode; only the signal guard is skipped once trusted.
     bool decodeOk = true;
+    const bool guarded = m_codec2GuardedCallsLeft > 0;
     {
         QMutexLocker<QRecursiveMutex> apiLocker(&codec2ApiMutex());
-        decodeOk = runGuardedCodec2Call("codec2_decode", [&]() {
-            decodeFn(m_codec,
-                     outputSamples.data(),
-                     reinterpret_cast<const unsigned char*>(input.constData()));
-        });
+        if (guarded)
+        {
+            decodeOk = runGuardedCodec2Call("codec2_decode", [&]() {
+                decodeFn(m_codec, target, input);
+            });
+        }
+        else
+        {
+            decodeFn(m_codec, target, input);
+        }
     }
-    if (!decodeOk)
-        return QByteArray(m_pcmFrameBytes, 0);
-
-    QByteArray output(m_pcmFrameBytes, 0);
-    std::memcpy(output.data(), outputSamples.data(), m_pcmFrameBytes);
-    return output;
+    if (guarded)
+        noteGuardedCodec2Call(decodeOk);
+    return finish(decodeOk ? expectedSamples : 0);
 #else
-    return codecFrame;
+    Q_UNUSED(finish);
+    return passThrough();
+#endif
+}
+
+void Codec2Wrapper::resetCodecState()
+{
+    // Library handles and probe verdicts are shared, so this only rebuilds
+    // the encoder/decoder state for the current codec and mode.
+    QMutexLocker<QRecursiveMutex> locker(&m_mutex);
+    updateCodec();
+}
+
+struct Codec2Wrapper::PreloadedLibraries
+{
+    QString codec2Path;
+    QString opusPath;
+#ifdef INCOMUDON_USE_CODEC2
+    std::shared_ptr<SharedCodec2Library> codec2;
+#endif
+#ifdef INCOMUDON_USE_OPUS
+    std::shared_ptr<SharedOpusLibrary> opus;
+#endif
+};
+
+std::shared_ptr<Codec2Wrapper::PreloadedLibraries> Codec2Wrapper::preloadLibraries(const QString& codec2Path,
+                                                                                   const QString& opusPath,
+                                                                                   int codecType,
+                                                                                   int mode)
+{
+    // Select the codec first so the library loads below probe only the mode
+    // that will actually be used.
+    Codec2Wrapper loader(nullptr, LibraryLoad::Deferred);
+    loader.setCodecType(codecType);
+    loader.setMode(mode);
+
+    auto preload = std::make_shared<PreloadedLibraries>();
+    preload->codec2Path = codec2Path;
+    preload->opusPath = opusPath;
+    loader.attachPreloadedLibraries(*preload);
+
+    QMutexLocker<QRecursiveMutex> locker(&loader.m_mutex);
+#ifdef INCOMUDON_USE_CODEC2
+    preload->codec2 = loader.m_codec2Shared;
+#endif
+#ifdef INCOMUDON_USE_OPUS
+    preload->opus = loader.m_opusShared;
+#endif
+    return preload;
+}
+
+void Codec2Wrapper::attachPreloadedLibraries(const PreloadedLibraries& preload)
+{
+    // Unlike the path setters this loads even when a path is unchanged,
+    // which is what a deferred wrapper with default paths needs.
+    QMutexLocker<QRecursiveMutex> locker(&m_mutex);
+    if (m_codec2LibraryPath != preload.codec2Path)
+    {
+        m_codec2LibraryPath = preload.codec2Path;
+        m_codec2KnownBadPath.clear();
+        emit codec2LibraryPathChanged();
+    }
+    if (m_opusLibraryPath != preload.opusPath)
+    {
+        m_opusLibraryPath = preload.opusPath;
+        emit opusLibraryPathChanged();
+    }
+#ifdef INCOMUDON_USE_CODEC2
+    refreshCodec2Library();
+#endif
+#ifdef INCOMUDON_USE_OPUS
+    refreshOpusLibrary();
 #endif
+    updateCodec();
 }
 
 void Codec2Wrapper::updateCodec()
@@ -1461,7 +2062,33 @@ void Codec2Wrapper::updateCodec()
             bool decodeProducedNonZero = false;
             m_codec2EncodeActive = m_codec2Encode;
             m_codec2DecodeActive = m_codec2Decode;
-            if (bitsPerFrame > 0 && bitsPerFrame <= 4096 &&
+            bool probeCached = false;
+            if (m_codec2Shared)
+            {
+                QMutexLocker<QRecursiveMutex> apiLocker(&codec2ApiMutex());
+                SharedCodec2Library::ModeProbe cached;
+                const auto cachedIt = m_codec2Shared->modeProbes.constFind(codecMode);
+                if (cachedIt != m_codec2Shared->modeProbes.constEnd())
+                {
+                    cached = *cachedIt;
+                    probeCached = true;
+                }
+                else if (m_codec2Shared->restoreModeProbe(codecMode, &cached))
+                {
+                    probeCached = true;
+                    logCodec2Status("codec2 probe verdict restored from settings mode=%d", codecMode);
+                }
+                if (probeCached)
+                {
+                    encodeProbeOk = cached.ok;
+                    m_codec2EncodeActive = cached.encode;
+                    m_codec2DecodeActive = cached.decode;
+                    logCodec2Status("codec2 probe verdict reused mode=%d ok=%d",
+                                    codecMode, encodeProbeOk ? 1 : 0);
+                }
+            }
+            if (!probeCached &&
+                bitsPerFrame > 0 && bitsPerFrame <= 4096 &&
                 samples > 0 && samples <= 4096)
             {
                 auto hasNonZeroByte = [](const QByteArray& data) {
@@ -1593,46 +2220,14 @@ void Codec2Wrapper::updateCodec()
                 if (!genericProbeOk || !decodeProbeOk)
                 {
                     const auto resolveCodec2Symbol = [&](const char* name) -> QFunctionPointer {
-                        if (!name || name[0] == '\0')
+                        if (!m_codec2Shared)
                             return nullptr;
-#if defined(Q_OS_ANDROID)
-                        if (m_codec2DlHandle)
-                            return reinterpret_cast<QFunctionPointer>(dlsym(m_codec2DlHandle, name));
-                        return nullptr;
-#else
-                        if (m_codec2Library)
-                            return m_codec2Library->resolve(name);
-                        return nullptr;
-#endif
+                        return m_codec2Shared->resolve(name);
                     };
 
                     const char* modeEncodeName = nullptr;
                     const char* modeDecodeName = nullptr;
-                    switch (codecMode)
-                    {
-                    case kCodec2Mode3200:
-                        modeEncodeName = "codec2_encode_3200";
-                        modeDecodeName = "codec2_decode_3200";
-                        break;
-                    case kCodec2Mode2400:
-                        modeEncodeName = "codec2_encode_2400";
-                        modeDecodeName = "codec2_decode_2400";
-                        break;
-                    case kCodec2Mode1600:
-                        modeEncodeName = "codec2_encode_1600";
-                        modeDecodeName = "codec2_decode_1600";
-                        break;
-                    case kCodec2Mode700C:
-                        modeEncodeName = "codec2_encode_700c";
-                        modeDecodeName = "codec2_decode_700c";
-                        break;
-                    case kCodec2Mode450:
-                        modeEncodeName = "codec2_encode_450";
-                        modeDecodeName = "codec2_decode_450";
-                        break;
-                    default:
-                        break;
-                    }
+                    codec2ModeSymbolNames(codecMode, &modeEncodeName, &modeDecodeName);
 
                     Codec2EncodeFn modeEncodeFn = reinterpret_cast<Codec2EncodeFn>(
                         resolveCodec2Symbol(modeEncodeName));
@@ -1679,7 +2274,8 @@ void Codec2Wrapper::updateCodec()
                 }
             }
 
-            if (encodeProbeOk && (!encodeProducedNonZero || !decodeProducedNonZero))
+            if (!probeCached && encodeProbeOk &&
+                (!encodeProducedNonZero || !decodeProducedNonZero))
             {
                 logCodec2Status(
                     "codec2 probe produced silent payload mode=%d bitrate=%d (encodeNonZero=%d decodeNonZero=%d).",
@@ -1690,7 +2286,7 @@ void Codec2Wrapper::updateCodec()
                 encodeProbeOk = false;
             }
 
-            if (encodeProbeOk)
+            if (!probeCached && encodeProbeOk)
             {
                 // Probes exercise codec state with synthetic data.
                 // Recreate the codec so real TX/RX starts from a clean state.
@@ -1727,6 +2323,16 @@ void Codec2Wrapper::updateCodec()
                 }
             }
 
+            if (!probeCached && m_codec2Shared)
+            {
+                SharedCodec2Library::ModeProbe verdict;
+                verdict.ok = encodeProbeOk;
+                verdict.encode = m_codec2EncodeActive;
+                verdict.decode = m_codec2DecodeActive;
+                QMutexLocker<QRecursiveMutex> apiLocker(&codec2ApiMutex());
+                m_codec2Shared->storeModeProbe(codecMode, verdict);
+            }
+
             if (!encodeProbeOk)
             {
                 m_codec2EncodeActive = nullptr;
@@ -1814,6 +2420,7 @@ void Codec2Wrapper::updateCodec()
                         m_frameMs = newFrameMs;
                         emit frameMsChanged();
                     }
+                    resetCodec2Guard(codecMode);
                     return;
                 }
             }
@@ -1919,17 +2526,7 @@ int Codec2Wrapper::opusPcmSampleRateForMode(int mode) const
 #ifdef INCOMUDON_USE_CODEC2
 void Codec2Wrapper::unloadCodec2Library()
 {
-#if defined(Q_OS_ANDROID)
-    if (m_codec2DlHandle)
-    {
-        dlclose(m_codec2DlHandle);
-        m_codec2DlHandle = nullptr;
-    }
-#endif
-    if (!m_codec2Library)
-        return;
-    if (m_codec2Library->isLoaded())
-        m_codec2Library->unload();
+    m_codec2Shared.reset();
 }
 
 void Codec2Wrapper::clearCodec2Api()
@@ -1966,11 +2563,53 @@ void Codec2Wrapper::setCodec2LibraryErrorInternal(const QString& error)
     emit codec2LibraryErrorChanged();
 }
 
+void Codec2Wrapper::resetCodec2Guard(int codecMode)
+{
+    if (codecMode == m_codec2GuardMode &&
+        m_codec2GuardedCallsLeft == 0 &&
+        !m_codec2GuardPinned)
+    {
+        return;
+    }
+
+    m_codec2GuardMode = codecMode;
+    if (!m_codec2GuardPinned &&
+        codec2VerdictTrusted(m_codec2LibraryFingerprint, codecMode))
+    {
+        m_codec2GuardedCallsLeft = 0;
+        logCodec2Status("codec2 library previously validated mode=%d; using direct calls.",
+                        codecMode);
+        return;
+    }
+    m_codec2GuardedCallsLeft = kCodec2GuardedWarmupCalls;
+}
+
+void Codec2Wrapper::noteGuardedCodec2Call(bool ok) const
+{
+    if (!ok)
+    {
+        // A fault after validation means the verdict was wrong; keep this
+        // library guarded for the rest of the session.
+        m_codec2GuardPinned = true;
+        m_codec2GuardedCallsLeft = qMax(m_codec2GuardedCallsLeft, 1);
+        storeCodec2Verdict(m_codec2LibraryFingerprint, m_codec2GuardMode, false);
+        return;
+    }
+    if (m_codec2GuardPinned || m_codec2GuardedCallsLeft <= 0)
+        return;
+
+    --m_codec2GuardedCallsLeft;
+    if (m_codec2GuardedCallsLeft > 0)
+        return;
+
+    storeCodec2Verdict(m_codec2LibraryFingerprint, m_codec2GuardMode, true);
+    logCodec2Status("codec2 runtime calls validated mode=%d; switching to direct calls.",
+                    m_codec2GuardMode);
+}
+
 void Codec2Wrapper::refreshCodec2Library()
 {
     QMutexLocker<QRecursiveMutex> locker(&m_mutex);
-    if (!m_codec2Library)
-        return;
 
     if (m_codec && m_codec2Destroy)
     {
@@ -1981,6 +2620,9 @@ void Codec2Wrapper::refreshCodec2Library()
 
     clearCodec2Api();
     unloadCodec2Library();
+    m_codec2LibraryFingerprint.clear();
+    m_codec2GuardMode = -1;
+    m_codec2GuardPinned = false;
 
     const bool explicitPath = !m_codec2LibraryPath.trimmed().isEmpty();
     QString normalizedError;
@@ -2021,146 +2663,30 @@ void Codec2Wrapper::refreshCodec2Library()
     QString lastError;
     for (const QString& candidate : candidates)
     {
-#if defined(Q_OS_ANDROID)
-        QByteArray candidateBytes = QFile::encodeName(candidate);
-        dlerror();
-        m_codec2DlHandle = dlopen(candidateBytes.constData(), RTLD_NOW | RTLD_GLOBAL);
-        if (!m_codec2DlHandle)
-        {
-            const char* globalErr = dlerror();
-            const QString globalErrText = globalErr
-                                              ? QString::fromUtf8(globalErr)
-                                              : QStringLiteral("dlopen failed (RTLD_NOW|RTLD_GLOBAL)");
-            dlerror();
-            m_codec2DlHandle = dlopen(candidateBytes.constData(), RTLD_NOW | RTLD_LOCAL);
-            if (!m_codec2DlHandle)
-            {
-                const char* localErr = dlerror();
-                const QString localErrText = localErr
-                                                 ? QString::fromUtf8(localErr)
-                                                 : QStringLiteral("dlopen failed (RTLD_NOW|RTLD_LOCAL)");
-                lastError = QStringLiteral("RTLD_GLOBAL: %1 / RTLD_LOCAL: %2")
-                                .arg(globalErrText, localErrText);
-                continue;
-            }
-        }
-#else
-        m_codec2Library->setFileName(candidate);
-        if (!m_codec2Library->load())
-        {
-            lastError = m_codec2Library->errorString();
-            continue;
-        }
-#endif
-#if defined(Q_OS_ANDROID)
-        m_codec2Create = reinterpret_cast<Codec2CreateFn>(dlsym(m_codec2DlHandle, "codec2_create"));
-        m_codec2Destroy = reinterpret_cast<Codec2DestroyFn>(dlsym(m_codec2DlHandle, "codec2_destroy"));
-        m_codec2Encode = reinterpret_cast<Codec2EncodeFn>(dlsym(m_codec2DlHandle, "codec2_encode"));
-        m_codec2Decode = reinterpret_cast<Codec2DecodeFn>(dlsym(m_codec2DlHandle, "codec2_decode"));
-        m_codec2BitsPerFrame = reinterpret_cast<Codec2BitsPerFrameFn>(dlsym(m_codec2DlHandle, "codec2_bits_per_frame"));
-        m_codec2SamplesPerFrame = reinterpret_cast<Codec2SamplesPerFrameFn>(dlsym(m_codec2DlHandle, "codec2_samples_per_frame"));
-        m_codec2AbiVersion = reinterpret_cast<Codec2AbiVersionFn>(dlsym(m_codec2DlHandle, "incomudon_codec2_abi_version"));
-#else
-        m_codec2Create = reinterpret_cast<Codec2CreateFn>(m_codec2Library->resolve("codec2_create"));
-        m_codec2Destroy = reinterpret_cast<Codec2DestroyFn>(m_codec2Library->resolve("codec2_destroy"));
-        m_codec2Encode = reinterpret_cast<Codec2EncodeFn>(m_codec2Library->resolve("codec2_encode"));
-        m_codec2Decode = reinterpret_cast<Codec2DecodeFn>(m_codec2Library->resolve("codec2_decode"));
-        m_codec2BitsPerFrame = reinterpret_cast<Codec2BitsPerFrameFn>(m_codec2Library->resolve("codec2_bits_per_frame"));
-        m_codec2SamplesPerFrame = reinterpret_cast<Codec2SamplesPerFrameFn>(m_codec2Library->resolve("codec2_samples_per_frame"));
-        m_codec2AbiVersion = reinterpret_cast<Codec2AbiVersionFn>(m_codec2Library->resolve("incomudon_codec2_abi_version"));
-#endif
-        m_codec2EncodeActive = m_codec2Encode;
-        m_codec2DecodeActive = m_codec2Decode;
-
-#if defined(Q_OS_ANDROID)
-        const QFileInfo candidateInfo(candidate);
-        logCodec2Status("Codec2 candidate loaded: %s (size=%lld)",
-                        candidate.toUtf8().constData(),
-                        static_cast<long long>(candidateInfo.size()));
-        logCodec2Status("Codec2 symbols create=%p destroy=%p abi=%p",
-                        reinterpret_cast<void*>(m_codec2Create),
-                        reinterpret_cast<void*>(m_codec2Destroy),
-                        reinterpret_cast<void*>(m_codec2AbiVersion));
-        if (m_codec2Create)
-        {
-            Dl_info dlinfo {};
-            if (dladdr(reinterpret_cast<void*>(m_codec2Create), &dlinfo) != 0 &&
-                dlinfo.dli_fname)
-            {
-                logCodec2Status("Codec2 dladdr create: base=%p sym=%p file=%s",
-                                dlinfo.dli_fbase,
-                                dlinfo.dli_saddr,
-                                dlinfo.dli_fname);
-
-#if defined(INCOMUDON_USE_CODEC2)
-                QString patchError;
-                int patchedSlots = 0;
-                if (patchAndroidJumpSlotsFromFile(candidate, dlinfo.dli_fbase, &patchError, &patchedSlots))
-                {
-                    if (patchedSlots > 0)
-                    {
-                        logCodec2Status("Codec2 relocation workaround applied: patched=%d",
-                                        patchedSlots);
-                    }
-                }
-                else if (!patchError.isEmpty())
-                {
-                    logCodec2Status("Codec2 relocation workaround skipped: %s",
-                                    patchError.toUtf8().constData());
-                }
-#endif
-            }
-        }
-#endif
-
-        const bool symbolsOk = (m_codec2Create && m_codec2Destroy &&
-                                m_codec2Encode && m_codec2Decode &&
-                                m_codec2BitsPerFrame && m_codec2SamplesPerFrame &&
-                                m_codec2AbiVersion);
-        if (symbolsOk)
+        bool incompatible = false;
+        std::shared_ptr<SharedCodec2Library> shared =
+            SharedCodec2Library::acquire(candidate, &lastError, &incompatible);
+        if (!shared)
         {
-            const int abiVersion = m_codec2AbiVersion();
-            if (abiVersion == kIncomUdonCodec2AbiVersion)
-            {
-                CODEC2* probeCodec = nullptr;
-                const bool probeOk = runGuardedCodec2InitCall("codec2_create_probe", [&]() {
-                    probeCodec = m_codec2Create(kCodec2Mode1600);
-                });
-                if (!probeOk || probeCodec == nullptr)
-                {
-                    clearCodec2Api();
-                    unloadCodec2Library();
-                    if (explicitPath)
-                        m_codec2KnownBadPath = normalizedPath;
-                    lastError = QStringLiteral(
-                        "codec2 library crashed during probe (incompatible build)");
-                    continue;
-                }
-                runGuardedCodec2InitCall("codec2_destroy_probe", [&]() {
-                    m_codec2Destroy(probeCodec);
-                });
-
-                setCodec2LibraryLoadedInternal(true);
-                setCodec2LibraryErrorInternal(QString());
-                return;
-            }
-
-            clearCodec2Api();
-            unloadCodec2Library();
-            if (explicitPath)
+            if (explicitPath && incompatible)
                 m_codec2KnownBadPath = normalizedPath;
-            lastError = QStringLiteral(
-                "codec2 ABI mismatch (expected %1, got %2)")
-                    .arg(kIncomUdonCodec2AbiVersion)
-                    .arg(abiVersion);
             continue;
         }
 
-        lastError = QStringLiteral(
-            "Required codec2 symbols were not found (including incomudon_codec2_abi_version): %1")
-                        .arg(candidate);
-        clearCodec2Api();
-        unloadCodec2Library();
+        m_codec2Shared = shared;
+        m_codec2Create = shared->create;
+        m_codec2Destroy = shared->destroy;
+        m_codec2Encode = shared->encode;
+        m_codec2Decode = shared->decode;
+        m_codec2BitsPerFrame = shared->bitsPerFrame;
+        m_codec2SamplesPerFrame = shared->samplesPerFrame;
+        m_codec2AbiVersion = shared->abiVersion;
+        m_codec2EncodeActive = m_codec2Encode;
+        m_codec2DecodeActive = m_codec2Decode;
+        m_codec2LibraryFingerprint = shared->fingerprint;
+        setCodec2LibraryLoadedInternal(true);
+        setCodec2LibraryErrorInternal(QString());
+        return;
     }
 
     setCodec2LibraryLoadedInternal(false);
@@ -3,7 +3,11 @@
 #include <QObject>
 #include <QByteArray>
 #include <QRecursiveMutex>
+#include <QSpan>
 #include <QString>
+#include <QVector>
+
+#include <memory>
 
 #ifdef INCOMUDON_USE_CODEC2
 struct CODEC2;
@@ -72,7 +76,19 @@ public:
     };
     Q_ENUM(CodecType)
 
-    explicit Codec2Wrapper(QObject* parent = nullptr);
+    // Deferred wrappers load no library until attachPreloadedLibraries()
+    // or a library path is set, so they can be built on the GUI thread
+    // while preloadLibraries() runs elsewhere.
+    enum class LibraryLoad {
+        Immediate,
+        Deferred
+    };
+
+    // Handle returned by preloadLibraries(); holding it keeps the loaded
+    // runtimes resident.
+    struct PreloadedLibraries;
+
+    explicit Codec2Wrapper(QObject* parent = nullptr, LibraryLoad load = LibraryLoad::Immediate);
     ~Codec2Wrapper() override;
 
     int codecType() const;
@@ -102,6 +118,22 @@ public:
 
     QByteArray encode(const QByteArray& pcmFrame) const;
     QByteArray decode(const QByteArray& codecFrame) const;
+    // Allocation-free variants writing into caller-owned buffers. encode
+    // returns the encoded byte count (0 on failure) and needs room for
+    // maxEncodedFrameBytes(); decode returns the number of samples written.
+    int encode(QSpan<const qint16> pcmFrame, QSpan<quint8> out) const;
+    int decode(QSpan<const quint8> codecFrame, QSpan<qint16> out) const;
+    int maxEncodedFrameBytes() const;
+    void resetCodecState();
+    // Loads and probes the codec runtimes on the calling thread. The handle
+    // keeps them resident, so wrappers given the same paths while it is held
+    // attach without reloading or re-probing.
+    static std::shared_ptr<PreloadedLibraries> preloadLibraries(const QString& codec2Path,
+                                                                const QString& opusPath,
+                                                                int codecType,
+                                                                int mode);
+    // Takes the preload's library paths and attaches to its runtimes.
+    void attachPreloadedLibraries(const PreloadedLibraries& preload);
 
 signals:
     void codecTypeChanged();
@@ -143,6 +175,9 @@ private:
     QString m_codec2LibraryPath;
     bool m_codec2LibraryLoaded = false;
     QString m_codec2LibraryError;
+    mutable QVector<qint16> m_encodeScratch;
+    mutable QVector<qint16> m_decodeScratch;
+    mutable QVector<quint8> m_decodeInputScratch;
 
 #ifdef INCOMUDON_USE_CODEC2
     typedef CODEC2* (*Codec2CreateFn)(int);
@@ -151,6 +186,8 @@ private:
     typedef void (*Codec2DecodeFn)(CODEC2*, short*, const unsigned char*);
     typedef int (*Codec2BitsPerFrameFn)(CODEC2*);
     typedef int (*Codec2SamplesPerFrameFn)(CODEC2*);
+    typedef int (*Codec2AbiVersionFn)();
+    struct SharedCodec2Library;
 
     void unloadCodec2Library();
     void clearCodec2Api();
@@ -158,6 +195,8 @@ private:
     void refreshCodec2Library();
     void setCodec2LibraryLoadedInternal(bool loaded);
     void setCodec2LibraryErrorInternal(const QString& error);
+    void resetCodec2Guard(int codecMode);
+    void noteGuardedCodec2Call(bool ok) const;
 
     mutable struct CODEC2* m_codec = nullptr;
     Codec2CreateFn m_codec2Create = nullptr;
@@ -166,15 +205,17 @@ private:
     Codec2DecodeFn m_codec2Decode = nullptr;
     Codec2EncodeFn m_codec2EncodeActive = nullptr;
     Codec2DecodeFn m_codec2DecodeActive = nullptr;
-    typedef int (*Codec2AbiVersionFn)();
 
     Codec2BitsPerFrameFn m_codec2BitsPerFrame = nullptr;
     Codec2SamplesPerFrameFn m_codec2SamplesPerFrame = nullptr;
     Codec2AbiVersionFn m_codec2AbiVersion = nullptr;
     QString m_codec2KnownBadPath;
-#if defined(Q_OS_ANDROID)
-    void* m_codec2DlHandle = nullptr;
-#endif
+    QString m_codec2LibraryFingerprint;
+    int m_codec2GuardMode = -1;
+    // Runtime calls stay signal-guarded until this many frames succeed.
+    mutable int m_codec2GuardedCallsLeft = 0;
+    mutable bool m_codec2GuardPinned = false;
+    std::shared_ptr<SharedCodec2Library> m_codec2Shared;
 #endif
 
 #ifdef INCOMUDON_USE_OPUS
@@ -185,6 +226,7 @@ private:
     typedef struct OpusDecoder* (*OpusDecoderCreateFn)(int, int, int*);
     typedef void (*OpusDecoderDestroyFn)(struct OpusDecoder*);
     typedef int (*OpusDecodeFn)(struct OpusDecoder*, const unsigned char*, int, short*, int, int);
+    struct SharedOpusLibrary;
 
     void unloadOpusLibrary();
     void clearOpusApi();
@@ -202,10 +244,6 @@ private:
     OpusDecoderCreateFn m_opusDecoderCreate = nullptr;
     OpusDecoderDestroyFn m_opusDecoderDestroy = nullptr;
     OpusDecodeFn m_opusDecode = nullptr;
-    class QLibrary* m_opusLibrary = nullptr;
-#endif
-
-#ifdef INCOMUDON_USE_CODEC2
-    class QLibrary* m_codec2Library = nullptr;
+    std::shared_ptr<SharedOpusLibrary> m_opusShared;
 #endif
 };
@@ -421,6 +421,20 @@ void AppState::setNoiseSuppressionLevel(int level)
     emit noiseSuppressionLevelChanged();
 }
 
+bool AppState::voiceActivityDetectionEnabled() const
+{
+    return m_voiceActivityDetectionEnabled;
+}
+
+void AppState::setVoiceActivityDetectionEnabled(bool enabled)
+{
+    if (m_voiceActivityDetectionEnabled == enabled)
+        return;
+
+    m_voiceActivityDetectionEnabled = enabled;
+    emit voiceActivityDetectionEnabledChanged();
+}
+
 int AppState::speakerVolumePercent() const
 {
     return m_speakerVolumePercent;
@@ -89,6 +89,10 @@ class AppState : public QObject
                READ noiseSuppressionLevel
                WRITE setNoiseSuppressionLevel
                NOTIFY noiseSuppressionLevelChanged)
+    Q_PROPERTY(bool voiceActivityDetectionEnabled
+               READ voiceActivityDetectionEnabled
+               WRITE setVoiceActivityDetectionEnabled
+               NOTIFY voiceActivityDetectionEnabledChanged)
     Q_PROPERTY(int speakerVolumePercent
                READ speakerVolumePercent
                WRITE setSpeakerVolumePercent
@@ -187,6 +191,8 @@ public:
     void setNoiseSuppressionEnabled(bool enabled);
     int noiseSuppressionLevel() const;
     void setNoiseSuppressionLevel(int level);
+    bool voiceActivityDetectionEnabled() const;
+    void setVoiceActivityDetectionEnabled(bool enabled);
     int speakerVolumePercent() const;
     void setSpeakerVolumePercent(int percent);
     bool keepMicSessionAlwaysOn() const;
@@ -224,6 +230,7 @@ signals:
     void micVolumePercentChanged();
     void noiseSuppressionEnabledChanged();
     void noiseSuppressionLevelChanged();
+    void voiceActivityDetectionEnabledChanged();
     void speakerVolumePercentChanged();
     void keepMicSessionAlwaysOnChanged();
     void codec2LibraryPathChanged();
@@ -260,6 +267,7 @@ private:
     int m_micVolumePercent = 200;
     bool m_noiseSuppressionEnabled = false;
     int m_noiseSuppressionLevel = 45;
+    bool m_voiceActivityDetectionEnabled = false;
     int m_speakerVolumePercent = 100;
     bool m_keepMicSessionAlwaysOn = false;
     QString m_codec2LibraryPath;
@@ -8,10 +8,33 @@
 
 #include <QAbstractSocket>
 #include <QHostInfo>
+#include <QSpan>
 #include <QtEndian>
 #include <QtMath>
 #include <algorithm>
-#include <cstring>
+
+// Idle decoders kept for reuse; at least kMaxMixedStreams.
+static constexpr int kMaxPooledStreamCodecs = 8;
+// Streams mixed per tick beyond pinned priority talkers. The rest are only
+// drained, with a couple of them decoded each tick to refresh their level.
+static constexpr int kMaxMixedStreams = 4;
+static constexpr int kMixProbeStreamsPerTick = 2;
+// A challenger must be this much louder to displace a mixed stream.
+static constexpr float kMixSelectionHysteresis = 1.5f;
+// Drift control: the resampler ratio is steered once a second from the
+// smoothed jitter fill, so sender/receiver clock offsets of tens of ppm are
+// absorbed without dropping or repeating frames.
+static constexpr int kDriftUpdateTicks = 50;
+static constexpr double kDriftFillSmoothing = 0.02;
+static constexpr double kDriftProportionalPpmPerMs = 20.0;
+static constexpr double kDriftIntegralPpmPerMs = 0.2;
+static constexpr double kMaxDriftPpm = 500.0;
+
+static quint32 streamCodecPoolKey(int codecId, int mode)
+{
+    return (static_cast<quint32>(codecId & 0xFF) << 16) |
+           static_cast<quint32>(mode & 0xFFFF);
+}
 
 static quint32 readU32Payload(const QByteArray& payload, quint32 fallback)
 {
@@ -21,106 +44,88 @@ static quint32 readU32Payload(const QByteArray& payload, quint32 fallback)
     return qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(payload.constData()));
 }
 
-static QByteArray crossfadePcm16(const QByteArray& fromPcm,
-                                 const QByteArray& toPcm,
-                                 int fadeSamples)
+static void fadeInFromSilence(QSpan<qint16> samples, int fadeSamples)
 {
-    if (fromPcm.size() != toPcm.size())
-        return toPcm;
-
-    const int totalSamples = toPcm.size() / static_cast<int>(sizeof(qint16));
-    if (totalSamples <= 0 || fadeSamples <= 0)
-        return toPcm;
-
-    const int count = qMin(fadeSamples, totalSamples);
-    QByteArray out = toPcm;
-    const char* fromPtr = fromPcm.constData();
-    const char* toPtr = toPcm.constData();
-    char* outPtr = out.data();
-
+    const int count = qMin(fadeSamples, static_cast<int>(samples.size()));
     for (int i = 0; i < count; ++i)
     {
-        const qint16 a = qFromLittleEndian<qint16>(
-            reinterpret_cast<const uchar*>(fromPtr + i * static_cast<int>(sizeof(qint16))));
-        const qint16 b = qFromLittleEndian<qint16>(
-            reinterpret_cast<const uchar*>(toPtr + i * static_cast<int>(sizeof(qint16))));
         const float t = static_cast<float>(i) / static_cast<float>(count);
-        const float v = (1.0f - t) * static_cast<float>(a) + t * static_cast<float>(b);
-        const qint16 mixed = static_cast<qint16>(qBound(-32768, static_cast<int>(qRound(v)), 32767));
-        const qint16 le = qToLittleEndian<qint16>(mixed);
-        std::memcpy(outPtr + i * static_cast<int>(sizeof(qint16)), &le, sizeof(le));
+        const float v = t * static_cast<float>(samples[i]);
+        samples[i] = static_cast<qint16>(qBound(-32768, static_cast<int>(qRound(v)), 32767));
     }
-
-    return out;
 }
 
-static QByteArray holdDecayFromTailPcm16(const QByteArray& pcm)
+static void fadeOutToSilence(QSpan<const qint16> from, QSpan<qint16> out, int fadeSamples)
 {
-    if (pcm.isEmpty())
-        return pcm;
+    const int total = static_cast<int>(qMin(from.size(), out.size()));
+    const int count = qMax(0, qMin(fadeSamples, total));
+    for (int i = 0; i < count; ++i)
+    {
+        const float t = static_cast<float>(i) / static_cast<float>(count);
+        const float v = (1.0f - t) * static_cast<float>(from[i]);
+        out[i] = static_cast<qint16>(qBound(-32768, static_cast<int>(qRound(v)), 32767));
+    }
+    std::fill(out.begin() + count, out.end(), qint16(0));
+}
 
-    const int totalSamples = pcm.size() / static_cast<int>(sizeof(qint16));
-    if (totalSamples <= 0)
-        return pcm;
+static float frameLevel(QSpan<const qint16> samples)
+{
+    if (samples.isEmpty())
+        return 0.0f;
 
-    const qint16 tail = qFromLittleEndian<qint16>(
-        reinterpret_cast<const uchar*>(pcm.constData() +
-        (totalSamples - 1) * static_cast<int>(sizeof(qint16))));
+    qint64 sum = 0;
+    for (qint16 sample : samples)
+        sum += qAbs(static_cast<int>(sample));
+    return static_cast<float>(sum) / static_cast<float>(samples.size());
+}
 
-    QByteArray out(pcm.size(), 0);
-    char* outPtr = out.data();
-    const int denom = qMax(1, totalSamples - 1);
-    for (int i = 0; i < totalSamples; ++i)
-    {
-        const float t = static_cast<float>(i) / static_cast<float>(denom);
-        const float v = static_cast<float>(tail) * (1.0f - t);
-        const qint16 sample = static_cast<qint16>(qBound(-32768, static_cast<int>(qRound(v)), 32767));
-        const qint16 le = qToLittleEndian<qint16>(sample);
-        std::memcpy(outPtr + i * static_cast<int>(sizeof(qint16)), &le, sizeof(le));
-    }
-    return out;
+static void updateLevelEstimate(float* level, bool* known, float frame)
+{
+    *level = *known ? (0.7f * *level + 0.3f * frame) : frame;
+    *known = true;
 }
 
-static QVector<qint16> pcmToSamples(const QByteArray& pcm)
+// Background estimate for comfort noise: follows quiet frames down at once
+// and creeps up slowly, so it settles on the level between words. The
+// additive step lets it recover from an all-zero frame, where a purely
+// multiplicative creep would stay at 0 for good.
+static void updateComfortLevel(float* level, bool* known, float frame)
 {
-    const int sampleCount = pcm.size() / static_cast<int>(sizeof(qint16));
-    QVector<qint16> out;
-    out.reserve(sampleCount);
-    const char* data = pcm.constData();
-    for (int i = 0; i < sampleCount; ++i)
-    {
-        const qint16 sample = qFromLittleEndian<qint16>(
-            reinterpret_cast<const uchar*>(data + i * static_cast<int>(sizeof(qint16))));
-        out.append(sample);
-    }
-    return out;
+    if (!*known || frame < *level)
+        *level = frame;
+    else
+        *level = qMax(*level * 1.02f, *level + 1.0f);
+    *known = true;
 }
 
-static QByteArray samplesToPcm(const QVector<qint16>& samples, int offset, int count)
+static void addComfortNoise(QSpan<qint16> out, float level, quint32* seed)
 {
-    const int boundedOffset = qBound(0, offset, samples.size());
-    const int boundedCount = qMax(0, qMin(count, samples.size() - boundedOffset));
-    QByteArray out(boundedCount * static_cast<int>(sizeof(qint16)), 0);
-    char* ptr = out.data();
-    for (int i = 0; i < boundedCount; ++i)
+    // Uniform noise in [-2L, 2L] has a mean absolute level of L.
+    const float amplitude = qMin(level, 400.0f) * 2.0f;
+    if (amplitude < 1.0f)
+        return;
+    for (qint16& sample : out)
     {
-        const qint16 le = qToLittleEndian<qint16>(samples.at(boundedOffset + i));
-        std::memcpy(ptr + i * static_cast<int>(sizeof(qint16)), &le, sizeof(le));
+        *seed = *seed * 1664525u + 1013904223u;
+        const float noise = (static_cast<float>(*seed >> 8) / 8388608.0f - 1.0f) * amplitude;
+        sample = static_cast<qint16>(qBound(-32768, sample + qRound(noise), 32767));
     }
-    return out;
 }
 
-static QByteArray padPcmToSize(const QByteArray& pcm, int targetBytes)
+static void holdDecayFromTail(QSpan<const qint16> from, QSpan<qint16> out)
 {
-    if (targetBytes <= 0)
-        return QByteArray();
-    if (pcm.size() >= targetBytes)
-        return pcm.left(targetBytes);
+    const int totalSamples = static_cast<int>(out.size());
+    if (from.isEmpty() || totalSamples <= 0)
+        return;
 
-    QByteArray padded = pcm;
-    padded.resize(targetBytes);
-    std::memset(padded.data() + pcm.size(), 0, targetBytes - pcm.size());
-    return padded;
+    const qint16 tail = from.back();
+    const int denom = qMax(1, totalSamples - 1);
+    for (int i = 0; i < totalSamples; ++i)
+    {
+        const float t = static_cast<float>(i) / static_cast<float>(denom);
+        const float v = static_cast<float>(tail) * (1.0f - t);
+        out[i] = static_cast<qint16>(qBound(-32768, static_cast<int>(qRound(v)), 32767));
+    }
 }
 
 ChannelManager::ChannelManager(QObject* parent)
@@ -141,6 +146,8 @@ ChannelManager::ChannelManager(QObject* parent)
 
 ChannelManager::~ChannelManager()
 {
+    if (m_audioOutput)
+        m_audioOutput->setPlayoutSource(nullptr);
     clearStreams();
 }
 
@@ -189,28 +196,44 @@ void ChannelManager::setCodec(Codec2Wrapper* codec)
     {
         connect(m_codecTemplate, &Codec2Wrapper::frameMsChanged,
                 this, &ChannelManager::updatePlayoutParams);
+        const auto applyPathsToStreams = [this]() {
+            for (RxStreamState* stream : std::as_const(m_streams))
+                applyTemplateLibraryPaths(stream->codec);
+            for (const QVector<Codec2Wrapper*>& pooled : std::as_const(m_streamCodecPool))
+            {
+                for (Codec2Wrapper* codec : pooled)
+                    applyTemplateLibraryPaths(codec);
+            }
+        };
         connect(m_codecTemplate, &Codec2Wrapper::codec2LibraryPathChanged,
-                this, [this]() {
-                    for (RxStreamState* stream : std::as_const(m_streams))
-                        applyTemplateLibraryPaths(stream);
-                });
+                this, applyPathsToStreams);
         connect(m_codecTemplate, &Codec2Wrapper::opusLibraryPathChanged,
-                this, [this]() {
-                    for (RxStreamState* stream : std::as_const(m_streams))
-                        applyTemplateLibraryPaths(stream);
-                });
+                this, applyPathsToStreams);
     }
 
     for (RxStreamState* stream : std::as_const(m_streams))
-        applyTemplateLibraryPaths(stream);
+        applyTemplateLibraryPaths(stream->codec);
+    for (const QVector<Codec2Wrapper*>& pooled : std::as_const(m_streamCodecPool))
+    {
+        for (Codec2Wrapper* codec : pooled)
+            applyTemplateLibraryPaths(codec);
+    }
     updatePlayoutParams();
 }
 
 void ChannelManager::setAudioOutput(AudioOutput* output)
 {
+    if (m_audioOutput == output)
+        return;
+
+    if (m_audioOutput)
+        m_audioOutput->setPlayoutSource(nullptr);
     m_audioOutput = output;
     if (m_audioOutput)
+    {
         m_audioOutput->setSampleRate(m_mixSampleRate);
+        m_audioOutput->setPlayoutSource(this);
+    }
 }
 
 void ChannelManager::setFecEnabled(bool enabled)
@@ -318,6 +341,7 @@ bool ChannelManager::joinChannel(const ChannelConfig& config)
     m_joinRetriesLeft = 5;
     m_serverMultiTalkEnabled = false;
     m_serverMaxActiveTalkers = 1;
+    m_streamCodecPrewarmTarget = 0;
     m_activeTalkers.clear();
     m_codecConfigCache.clear();
     emitActiveTalkersState();
@@ -351,16 +375,42 @@ void ChannelManager::leaveChannel()
     m_serverLocked = false;
     m_serverMultiTalkEnabled = false;
     m_serverMaxActiveTalkers = 1;
+    m_streamCodecPrewarmTarget = 0;
     m_joinRetryTimer.stop();
     m_joinRetriesLeft = 0;
     m_activeTalkers.clear();
     m_codecConfigCache.clear();
+    m_talkerDriftPpm.clear();
     emitActiveTalkersState();
     clearStreams();
     emit channelIdChanged();
     emit targetChanged();
 }
 
+void ChannelManager::setTalkerGain(quint32 talkerId, qreal gain)
+{
+    TalkerMix& mix = m_talkerMix[talkerId];
+    mix.gain = static_cast<float>(qBound(0.0, gain, 4.0));
+    if (RxStreamState* stream = m_streams.value(talkerId, nullptr))
+        stream->mixGain = mix.gain;
+}
+
+void ChannelManager::setTalkerPan(quint32 talkerId, qreal pan)
+{
+    TalkerMix& mix = m_talkerMix[talkerId];
+    mix.pan = static_cast<float>(qBound(-1.0, pan, 1.0));
+    if (RxStreamState* stream = m_streams.value(talkerId, nullptr))
+        stream->mixPan = mix.pan;
+}
+
+void ChannelManager::setTalkerPriority(quint32 talkerId, bool priority)
+{
+    TalkerMix& mix = m_talkerMix[talkerId];
+    mix.priority = priority;
+    if (RxStreamState* stream = m_streams.value(talkerId, nullptr))
+        stream->mixPriority = priority;
+}
+
 quint32 ChannelManager::channelId() const
 {
     return m_config.channelId;
@@ -382,11 +432,12 @@ void ChannelManager::clearStreams()
     for (auto it = m_streams.begin(); it != m_streams.end(); ++it)
     {
         RxStreamState* stream = it.value();
-        delete stream->codec;
+        recycleStreamCodec(stream->codec);
         delete stream->jitter;
         delete stream;
     }
     m_streams.clear();
+    m_playoutOrder.clear();
     emitPlayoutTalkersState();
 }
 
@@ -399,9 +450,7 @@ QList<quint32> ChannelManager::sortedActiveTalkers() const
 
 QList<quint32> ChannelManager::sortedPlayoutTalkers() const
 {
-    QList<quint32> talkers = m_streams.keys();
-    std::sort(talkers.begin(), talkers.end());
-    return talkers;
+    return m_playoutOrder;
 }
 
 void ChannelManager::emitActiveTalkersState()
@@ -416,15 +465,15 @@ void ChannelManager::emitPlayoutTalkersState()
     emit playoutTalkersChanged(sortedPlayoutTalkers());
 }
 
-void ChannelManager::applyTemplateLibraryPaths(RxStreamState* stream)
+void ChannelManager::applyTemplateLibraryPaths(Codec2Wrapper* codec)
 {
-    if (!stream || !stream->codec)
+    if (!codec)
         return;
 
     if (m_codecTemplate)
     {
-        stream->codec->setCodec2LibraryPath(m_codecTemplate->codec2LibraryPath());
-        stream->codec->setOpusLibraryPath(m_codecTemplate->opusLibraryPath());
+        codec->setCodec2LibraryPath(m_codecTemplate->codec2LibraryPath());
+        codec->setOpusLibraryPath(m_codecTemplate->opusLibraryPath());
     }
 }
 
@@ -439,26 +488,37 @@ void ChannelManager::resetStreamState(RxStreamState* stream, bool clearBuffers)
     stream->talkEnded = false;
     stream->releaseCompletionPending = false;
     stream->pcmMissCount = 0;
-    stream->lastPcmFrame.clear();
-    stream->pendingMixedSamples.clear();
+    stream->hasLastFrame = false;
+    stream->pendingSamples.clear();
     stream->resampler.reset();
+    stream->fillEmaMs = -1.0;
+    stream->driftTicks = 0;
+    stream->comfortNoise = false;
+    stream->comfortLevelKnown = false;
     stream->fecDecoder.reset();
     if (clearBuffers && stream->jitter)
         stream->jitter->clear();
 }
 
+ChannelManager::RxCodecConfig ChannelManager::streamCodecConfig(const RxStreamState* stream) const
+{
+    if (stream && stream->configKnown)
+        return stream->config;
+
+    return RxCodecConfig{m_codecTemplate ? m_codecTemplate->mode() : 1600,
+                         (m_codecTemplate && m_codecTemplate->activeCodecTransportId() == Proto::CODEC_TRANSPORT_OPUS)
+                             ? Proto::CODEC_TRANSPORT_OPUS
+                             : ((m_codecTemplate && m_codecTemplate->forcePcm())
+                                    ? Proto::CODEC_TRANSPORT_PCM
+                                    : Proto::CODEC_TRANSPORT_CODEC2)};
+}
+
 void ChannelManager::applyStreamCodecConfig(RxStreamState* stream, bool resetState)
 {
     if (!stream || !stream->codec)
         return;
 
-    const RxCodecConfig config = stream->configKnown ? stream->config
-        : RxCodecConfig{m_codecTemplate ? m_codecTemplate->mode() : 1600,
-                        (m_codecTemplate && m_codecTemplate->activeCodecTransportId() == Proto::CODEC_TRANSPORT_OPUS)
-                            ? Proto::CODEC_TRANSPORT_OPUS
-                            : ((m_codecTemplate && m_codecTemplate->forcePcm())
-                                   ? Proto::CODEC_TRANSPORT_PCM
-                                   : Proto::CODEC_TRANSPORT_CODEC2)};
+    const RxCodecConfig config = streamCodecConfig(stream);
 
     if (config.codecId == Proto::CODEC_TRANSPORT_OPUS)
         stream->codec->setCodecType(Codec2Wrapper::CodecTypeOpus);
@@ -483,23 +543,35 @@ ChannelManager::RxStreamState* ChannelManager::ensureStream(quint32 senderId)
 
     RxStreamState* stream = new RxStreamState;
     stream->senderId = senderId;
-    stream->codec = new Codec2Wrapper(this);
-    stream->jitter = new JitterBuffer(this);
-    stream->fecDecoder.setEnabled(m_fecEnabled);
-    applyTemplateLibraryPaths(stream);
-
     const auto configIt = m_codecConfigCache.constFind(senderId);
     if (configIt != m_codecConfigCache.constEnd())
     {
         stream->config = configIt.value();
         stream->configKnown = true;
     }
+    stream->codec = acquireStreamCodec(streamCodecConfig(stream));
+    stream->jitter = new JitterBuffer(this);
+    stream->fecDecoder.setEnabled(m_fecEnabled);
     applyStreamCodecConfig(stream, false);
     if (stream->jitter)
         stream->jitter->setMinBufferedFrames(streamMinBufferedFrames(stream));
     stream->fadeInOnNextFrame = true;
+    stream->pendingSamples.reserve(mixFrameSamples() * 4);
+    // Clock offsets belong to the sender's device, so start from what was
+    // learned during its previous transmissions.
+    stream->driftIntegralPpm = m_talkerDriftPpm.value(senderId, 0.0);
+    stream->resampler.setRatioAdjustPpm(stream->driftIntegralPpm);
+    const auto mixIt = m_talkerMix.constFind(senderId);
+    if (mixIt != m_talkerMix.constEnd())
+    {
+        stream->mixGain = mixIt->gain;
+        stream->mixPan = mixIt->pan;
+        stream->mixPriority = mixIt->priority;
+    }
 
     m_streams.insert(senderId, stream);
+    m_playoutOrder.insert(std::lower_bound(m_playoutOrder.begin(), m_playoutOrder.end(), senderId),
+                          senderId);
     emitPlayoutTalkersState();
     return stream;
 }
@@ -510,12 +582,87 @@ void ChannelManager::deleteStream(quint32 senderId)
     if (!stream)
         return;
 
-    delete stream->codec;
+    const auto orderIt = std::lower_bound(m_playoutOrder.begin(), m_playoutOrder.end(), senderId);
+    if (orderIt != m_playoutOrder.end() && *orderIt == senderId)
+        m_playoutOrder.erase(orderIt);
+
+    recycleStreamCodec(stream->codec);
     delete stream->jitter;
     delete stream;
     emitPlayoutTalkersState();
 }
 
+Codec2Wrapper* ChannelManager::acquireStreamCodec(const RxCodecConfig& config)
+{
+    auto it = m_streamCodecPool.find(streamCodecPoolKey(config.codecId, config.mode));
+    if (it == m_streamCodecPool.end() || it->isEmpty())
+    {
+        // Any idle decoder is still cheaper than a new one: the library and
+        // probe verdicts are shared, only the codec state is rebuilt.
+        it = m_streamCodecPool.begin();
+        while (it != m_streamCodecPool.end() && it->isEmpty())
+            ++it;
+    }
+
+    if (it != m_streamCodecPool.end() && !it->isEmpty())
+    {
+        Codec2Wrapper* codec = it->takeLast();
+        --m_streamCodecPoolSize;
+        return codec;
+    }
+
+    Codec2Wrapper* codec = new Codec2Wrapper(this);
+    applyTemplateLibraryPaths(codec);
+    return codec;
+}
+
+void ChannelManager::recycleStreamCodec(Codec2Wrapper* codec)
+{
+    if (!codec)
+        return;
+
+    if (m_streamCodecPoolSize >= kMaxPooledStreamCodecs)
+    {
+        delete codec;
+        return;
+    }
+
+    // Reset now so the next talker's first frame does not pay for it.
+    codec->resetCodecState();
+    int codecId = Proto::CODEC_TRANSPORT_CODEC2;
+    if (codec->forcePcm())
+        codecId = Proto::CODEC_TRANSPORT_PCM;
+    else if (codec->codecType() == Codec2Wrapper::CodecTypeOpus)
+        codecId = Proto::CODEC_TRANSPORT_OPUS;
+    m_streamCodecPool[streamCodecPoolKey(codecId, codec->mode())].append(codec);
+    ++m_streamCodecPoolSize;
+}
+
+void ChannelManager::prewarmStreamCodecs(int count)
+{
+    // Only mixed streams are decoded every tick, so warming more than that
+    // buys nothing. One codec now for the first talker; the rest follow one
+    // per playout tick so a SERVER_CONFIG never stalls the UI thread.
+    m_streamCodecPrewarmTarget = qMin(count, kMaxMixedStreams);
+    prewarmStreamCodec();
+}
+
+void ChannelManager::prewarmStreamCodec()
+{
+    if (m_streamCodecPoolSize + m_streams.size() >= m_streamCodecPrewarmTarget)
+        return;
+
+    const RxCodecConfig config = streamCodecConfig(nullptr);
+    Codec2Wrapper* codec = new Codec2Wrapper(this);
+    applyTemplateLibraryPaths(codec);
+    codec->setCodecType(config.codecId == Proto::CODEC_TRANSPORT_OPUS
+                            ? Codec2Wrapper::CodecTypeOpus
+                            : Codec2Wrapper::CodecTypeCodec2);
+    codec->setForcePcm(config.codecId == Proto::CODEC_TRANSPORT_PCM);
+    codec->setMode(config.mode);
+    recycleStreamCodec(codec);
+}
+
 int ChannelManager::mixFrameSamples() const
 {
     return m_playoutPcmBytes / static_cast<int>(sizeof(qint16));
@@ -558,6 +705,7 @@ void ChannelManager::updatePlayoutParams()
     m_playoutTimer.setInterval(m_playoutFrameMs);
     const int samples = mixFrameSamples();
     m_crossfadeSamples = qMax(10, samples / 2);
+    m_mixer.configure(samples, m_mixSampleRate);
 
     if (m_audioOutput)
         m_audioOutput->setSampleRate(m_mixSampleRate);
@@ -644,9 +792,12 @@ void ChannelManager::onDatagramReceived(const QByteArray& datagram,
                 stream->fadeInOnNextFrame = true;
                 stream->silenceMode = true;
                 stream->pcmMissCount = 0;
-                stream->lastPcmFrame.clear();
-                stream->pendingMixedSamples.clear();
+                stream->hasLastFrame = false;
+                stream->pendingSamples.clear();
                 stream->resampler.reset();
+                stream->fillEmaMs = -1.0;
+                stream->driftTicks = 0;
+                stream->comfortNoise = false;
                 stream->fecDecoder.reset();
                 if (stream->jitter)
                     stream->jitter->clear();
@@ -662,8 +813,8 @@ void ChannelManager::onDatagramReceived(const QByteArray& datagram,
             stream->talkEnded = true;
             stream->releaseCompletionPending = true;
             const bool drained = stream->jitter->size() == 0 &&
-                                 stream->pendingMixedSamples.isEmpty() &&
-                                 stream->lastPcmFrame.isEmpty();
+                                 stream->pendingSamples.isEmpty() &&
+                                 !stream->hasLastFrame;
             if (drained)
             {
                 deleteStream(talkerId);
@@ -736,6 +887,7 @@ void ChannelManager::onDatagramReceived(const QByteArray& datagram,
             const int maxActiveTalkers = qMax(1, static_cast<int>(static_cast<quint8>(parsed.encryptedPayload.at(3))));
             m_serverMultiTalkEnabled = (flags & 0x01) != 0;
             m_serverMaxActiveTalkers = maxActiveTalkers;
+            prewarmStreamCodecs(m_serverMultiTalkEnabled ? m_serverMaxActiveTalkers : 1);
             emit serverMultiTalkConfigured(m_serverMultiTalkEnabled, m_serverMaxActiveTalkers);
         }
         return;
@@ -776,9 +928,10 @@ void ChannelManager::onDatagramReceived(const QByteArray& datagram,
             stream->fecDecoder.pushParity(blockStart, blockSize, parityIndex, parity);
         for (const FecDecodedFrame& frame : frames)
             stream->jitter->pushFrame(frame.seq, frame.frame);
+        m_fecRecoveredFrames += static_cast<quint64>(frames.size());
 
-        if ((!frames.isEmpty() || stream->jitter->size() > 0) && !m_playoutTimer.isActive())
-            m_playoutTimer.start();
+        if (!frames.isEmpty() || stream->jitter->size() > 0)
+            ensurePlayoutRunning();
         return;
     }
 
@@ -798,7 +951,14 @@ void ChannelManager::onDatagramReceived(const QByteArray& datagram,
         frame = plaintext;
     }
     if (frame.isEmpty())
+    {
+        // Silence marker from a sender's VAD.
+        stream->comfortNoise = true;
+        ensurePlayoutRunning();
         return;
+    }
+    if (stream->playoutPrimed)
+        stream->comfortNoise = false;
     stream->jitter->pushFrame(audioSeq, frame);
 
     if (m_fecEnabled)
@@ -806,10 +966,10 @@ void ChannelManager::onDatagramReceived(const QByteArray& datagram,
         const QVector<FecDecodedFrame> frames = stream->fecDecoder.pushData(audioSeq, frame);
         for (const FecDecodedFrame& outFrame : frames)
             stream->jitter->pushFrame(outFrame.seq, outFrame.frame);
+        m_fecRecoveredFrames += static_cast<quint64>(frames.size());
     }
 
-    if (!m_playoutTimer.isActive())
-        m_playoutTimer.start();
+    ensurePlayoutRunning();
 }
 
 void ChannelManager::onJoinRetryTimeout()
@@ -842,93 +1002,142 @@ void ChannelManager::onJoinRetryTimeout()
 ChannelManager::StreamRenderResult ChannelManager::renderStreamFrame(RxStreamState* stream)
 {
     StreamRenderResult result;
-    result.pcm = m_silenceFrame;
     if (!stream || !stream->codec || !stream->jitter)
         return result;
 
     const int targetSamples = mixFrameSamples();
     if (targetSamples <= 0)
         return result;
+    if (stream->frameSamples.size() != targetSamples)
+        stream->frameSamples.resize(targetSamples);
+    const QSpan<qint16> frame(stream->frameSamples);
+    // Copy rather than share, so the next write to frameSamples cannot detach.
+    const auto rememberLastFrame = [stream, frame]() {
+        stream->lastFrame.resize(frame.size());
+        std::copy(frame.begin(), frame.end(), stream->lastFrame.begin());
+        stream->hasLastFrame = true;
+    };
 
     if (!stream->playoutPrimed)
     {
         if (stream->jitter->size() < stream->jitter->minBufferedFrames())
         {
-            if (stream->talkEnded && stream->jitter->size() == 0 && stream->pendingMixedSamples.isEmpty())
+            if (stream->talkEnded && stream->jitter->size() == 0 && stream->pendingSamples.isEmpty())
             {
                 result.removeStream = true;
                 result.releaseCompleted = stream->releaseCompletionPending;
                 result.talkerId = stream->senderId;
             }
+            else if (stream->comfortNoise && !stream->talkEnded)
+            {
+                std::fill(frame.begin(), frame.end(), qint16(0));
+                addComfortNoise(frame, stream->comfortLevel, &stream->comfortSeed);
+                result.audible = true;
+            }
             return result;
         }
         stream->playoutPrimed = true;
         stream->fadeInOnNextFrame = true;
         stream->silenceMode = false;
+        stream->comfortNoise = false;
     }
 
-    while (stream->pendingMixedSamples.size() < targetSamples)
+    while (stream->pendingSamples.size() < targetSamples)
     {
         const QByteArray encoded = stream->jitter->popFrame(false);
         if (encoded.isEmpty())
             break;
 
-        QByteArray decoded = stream->codec->decode(encoded);
-        if (decoded.isEmpty())
-            decoded = QByteArray(stream->codec->pcmFrameBytes(), 0);
-        const QVector<qint16> input = pcmToSamples(decoded);
-        QVector<qint16> resampled;
-        stream->resampler.push(input, resampled);
-        if (!resampled.isEmpty())
-            stream->pendingMixedSamples += resampled;
+        const int frameSamples = stream->codec->pcmFrameBytes() / static_cast<int>(sizeof(qint16));
+        if (stream->decodedSamples.size() != frameSamples)
+            stream->decodedSamples.resize(frameSamples);
+        const int decodedCount = stream->codec->decode(
+            QSpan<const quint8>(reinterpret_cast<const quint8*>(encoded.constData()), encoded.size()),
+            QSpan<qint16>(stream->decodedSamples));
+        if (decodedCount < frameSamples)
+            std::fill(stream->decodedSamples.begin() + qMax(0, decodedCount),
+                      stream->decodedSamples.end(),
+                      qint16(0));
+        const float decodedLevel = frameLevel(stream->decodedSamples);
+        updateLevelEstimate(&stream->level, &stream->levelKnown, decodedLevel);
+        updateComfortLevel(&stream->comfortLevel, &stream->comfortLevelKnown, decodedLevel);
+        stream->resampledSamples.clear();
+        stream->resampler.push(stream->decodedSamples, stream->resampledSamples);
+        stream->pendingSamples.write(stream->resampledSamples);
+        ++m_decodedFrames;
     }
 
-    if (stream->pendingMixedSamples.size() >= targetSamples)
+    if (stream->pendingSamples.size() >= targetSamples)
     {
-        QByteArray pcm = samplesToPcm(stream->pendingMixedSamples, 0, targetSamples);
-        stream->pendingMixedSamples.remove(0, targetSamples);
+        stream->pendingSamples.read(frame);
+        const qint64 bufferedUs = static_cast<qint64>(stream->jitter->size()) * stream->codec->frameMs() * 1000 +
+                                  static_cast<qint64>(stream->pendingSamples.size()) * 1000000 / m_mixSampleRate;
+        ++m_playedFrames;
+        m_bufferedUsTotal += static_cast<quint64>(bufferedUs);
+        if (!stream->talkEnded)
+            updateStreamDrift(stream);
         if (stream->fadeInOnNextFrame)
         {
-            pcm = crossfadePcm16(m_silenceFrame, pcm, m_crossfadeSamples);
+            fadeInFromSilence(frame, m_crossfadeSamples);
             stream->fadeInOnNextFrame = false;
         }
-        stream->lastPcmFrame = pcm;
+        rememberLastFrame();
         stream->silenceMode = false;
         stream->pcmMissCount = 0;
-        result.pcm = pcm;
+        result.audible = true;
         return result;
     }
 
     if (stream->talkEnded)
     {
-        if (!stream->pendingMixedSamples.isEmpty())
+        if (!stream->pendingSamples.isEmpty())
         {
-            QByteArray pcm = samplesToPcm(stream->pendingMixedSamples, 0, stream->pendingMixedSamples.size());
-            stream->pendingMixedSamples.clear();
-            pcm = padPcmToSize(pcm, m_playoutPcmBytes);
-            stream->lastPcmFrame = pcm;
+            const int count = stream->pendingSamples.read(frame);
+            std::fill(frame.begin() + count, frame.end(), qint16(0));
+            rememberLastFrame();
             stream->silenceMode = false;
-            result.pcm = pcm;
+            result.audible = true;
             return result;
         }
 
-        if (!stream->lastPcmFrame.isEmpty() && !stream->silenceMode)
+        if (stream->hasLastFrame && !stream->silenceMode)
         {
-            result.pcm = crossfadePcm16(stream->lastPcmFrame, m_silenceFrame, m_crossfadeSamples);
+            fadeOutToSilence(stream->lastFrame, frame, m_crossfadeSamples);
+            result.audible = true;
         }
         result.removeStream = true;
         result.releaseCompleted = stream->releaseCompletionPending;
         result.talkerId = stream->senderId;
-        stream->lastPcmFrame.clear();
+        stream->hasLastFrame = false;
         stream->silenceMode = true;
         return result;
     }
 
     ++stream->pcmMissCount;
-    if (!stream->lastPcmFrame.isEmpty() && !stream->silenceMode)
+    if (!stream->comfortNoise)
+        ++m_concealedFrames;
+    // A stalled stream should not hold its mix slot on a stale level.
+    stream->level *= 0.7f;
+    if (stream->comfortNoise)
+    {
+        // The sender went silent on purpose: fade into comfort noise and
+        // re-prime so the next talkspurt gets its jitter margin back.
+        if (stream->hasLastFrame && !stream->silenceMode)
+            fadeOutToSilence(stream->lastFrame, frame, m_crossfadeSamples);
+        else
+            std::fill(frame.begin(), frame.end(), qint16(0));
+        addComfortNoise(frame, stream->comfortLevel, &stream->comfortSeed);
+        stream->pendingSamples.clear();
+        stream->playoutPrimed = false;
+        stream->silenceMode = true;
+        result.audible = true;
+        return result;
+    }
+    if (stream->hasLastFrame && !stream->silenceMode)
     {
-        result.pcm = holdDecayFromTailPcm16(stream->lastPcmFrame);
+        holdDecayFromTail(stream->lastFrame, frame);
         stream->silenceMode = true;
+        result.audible = true;
         return result;
     }
 
@@ -936,68 +1145,278 @@ ChannelManager::StreamRenderResult ChannelManager::renderStreamFrame(RxStreamSta
     return result;
 }
 
-void ChannelManager::onPlayoutTick()
+void ChannelManager::updateStreamDrift(RxStreamState* stream)
 {
-    if (!m_audioOutput)
+    const int codecFrameMs = qMax(1, stream->codec->frameMs());
+    const double fillMs = stream->jitter->size() * codecFrameMs +
+                          (stream->pendingSamples.size() * 1000.0) / m_mixSampleRate;
+    if (stream->fillEmaMs < 0.0)
+        stream->fillEmaMs = fillMs;
+    else
+        stream->fillEmaMs += (fillMs - stream->fillEmaMs) * kDriftFillSmoothing;
+
+    if (++stream->driftTicks < kDriftUpdateTicks)
         return;
+    stream->driftTicks = 0;
+
+    // Positive error means the buffer is filling: the sender's clock runs
+    // fast, so consume input slightly faster.
+    const double errorMs = stream->fillEmaMs - stream->jitter->minBufferedFrames() * codecFrameMs;
+    stream->driftIntegralPpm = qBound(-kMaxDriftPpm,
+                                      stream->driftIntegralPpm + errorMs * kDriftIntegralPpmPerMs,
+                                      kMaxDriftPpm);
+    const double ppm = qBound(-kMaxDriftPpm,
+                              stream->driftIntegralPpm + errorMs * kDriftProportionalPpmPerMs,
+                              kMaxDriftPpm);
+    stream->resampler.setRatioAdjustPpm(ppm);
+    m_talkerDriftPpm.insert(stream->senderId, stream->driftIntegralPpm);
+}
 
-    if (m_streams.isEmpty())
+ChannelManager::StreamRenderResult ChannelManager::skimStreamFrame(RxStreamState* stream, bool probe)
+{
+    StreamRenderResult result;
+    if (!stream || !stream->codec || !stream->jitter)
+        return result;
+
+    if (!stream->playoutPrimed)
     {
-        m_playoutTimer.stop();
-        return;
+        if (stream->jitter->size() < stream->jitter->minBufferedFrames())
+        {
+            if (stream->talkEnded && stream->jitter->size() == 0)
+            {
+                result.removeStream = true;
+                result.releaseCompleted = stream->releaseCompletionPending;
+                result.talkerId = stream->senderId;
+            }
+            return result;
+        }
+        stream->playoutPrimed = true;
+    }
+
+    // Just dropped out of the mix: fade the last mixed frame out once.
+    if (stream->hasLastFrame && !stream->silenceMode)
+    {
+        const int targetSamples = mixFrameSamples();
+        if (stream->frameSamples.size() != targetSamples)
+            stream->frameSamples.resize(targetSamples);
+        fadeOutToSilence(stream->lastFrame, stream->frameSamples, m_crossfadeSamples);
+        result.audible = true;
+    }
+    stream->hasLastFrame = false;
+    stream->silenceMode = true;
+    stream->fadeInOnNextFrame = true;
+    stream->pendingSamples.clear();
+    stream->resampler.reset();
+
+    // Consume the stream at its own frame rate so its jitter buffer stays
+    // aligned with wall clock while it is not mixed.
+    const int codecFrameMs = qMax(1, stream->codec->frameMs());
+    stream->skimCreditMs += m_playoutFrameMs;
+    bool consumed = false;
+    while (stream->skimCreditMs >= codecFrameMs)
+    {
+        const QByteArray encoded = stream->jitter->popFrame(false);
+        if (encoded.isEmpty())
+        {
+            stream->skimCreditMs = 0;
+            break;
+        }
+        stream->skimCreditMs -= codecFrameMs;
+        consumed = true;
+        if (!probe)
+            continue;
+
+        const int frameSamples = stream->codec->pcmFrameBytes() / static_cast<int>(sizeof(qint16));
+        if (stream->decodedSamples.size() != frameSamples)
+            stream->decodedSamples.resize(frameSamples);
+        const int decodedCount = stream->codec->decode(
+            QSpan<const quint8>(reinterpret_cast<const quint8*>(encoded.constData()), encoded.size()),
+            QSpan<qint16>(stream->decodedSamples));
+        updateLevelEstimate(&stream->level, &stream->levelKnown,
+                            frameLevel(QSpan<const qint16>(stream->decodedSamples).first(qMax(0, decodedCount))));
+        probe = false;
     }
 
-    QVector<int> mix(mixFrameSamples(), 0);
-    QList<quint32> removeTalkers;
-    QList<quint32> completedTalkers;
-    bool anyAudible = false;
-    int contributingStreams = 0;
+    if (!consumed && stream->talkEnded && stream->jitter->size() == 0)
+    {
+        result.removeStream = true;
+        result.releaseCompleted = stream->releaseCompletionPending;
+        result.talkerId = stream->senderId;
+    }
+    return result;
+}
 
-    const QList<quint32> talkers = sortedPlayoutTalkers();
-    for (quint32 senderId : talkers)
+void ChannelManager::selectMixedStreams()
+{
+    m_mixCandidates.clear();
+    for (quint32 senderId : std::as_const(m_playoutOrder))
     {
         RxStreamState* stream = m_streams.value(senderId, nullptr);
         if (!stream)
             continue;
+        if (stream->mixPriority)
+            stream->mixSelected = true;
+        else
+            m_mixCandidates.append(stream);
+    }
 
-        const StreamRenderResult render = renderStreamFrame(stream);
-        const QVector<qint16> samples = pcmToSamples(render.pcm);
-        for (int i = 0; i < mix.size() && i < samples.size(); ++i)
-            mix[i] += samples.at(i);
-        if (render.pcm != m_silenceFrame)
+    if (m_mixCandidates.size() <= kMaxMixedStreams)
+    {
+        for (RxStreamState* stream : std::as_const(m_mixCandidates))
+            stream->mixSelected = true;
+        return;
+    }
+
+    // Streams without a level yet are probed before anything else, so a
+    // newly keyed talker is ranked within a few ticks.
+    int probes = 0;
+    for (RxStreamState* stream : std::as_const(m_mixCandidates))
+    {
+        stream->mixProbe = false;
+        if (!stream->levelKnown && !stream->mixSelected && probes < kMixProbeStreamsPerTick)
         {
-            anyAudible = true;
-            ++contributingStreams;
+            stream->mixProbe = true;
+            ++probes;
         }
+    }
+    const int count = m_mixCandidates.size();
+    const int cursor = m_mixProbeCursor % count;
+    for (int i = 0; i < count && probes < kMixProbeStreamsPerTick; ++i)
+    {
+        RxStreamState* stream = m_mixCandidates.at((cursor + i) % count);
+        if (stream->mixSelected || stream->mixProbe)
+            continue;
+        stream->mixProbe = true;
+        ++probes;
+        m_mixProbeCursor = (cursor + i + 1) % count;
+    }
+
+    const auto score = [](const RxStreamState* stream) {
+        return stream->mixSelected ? stream->level * kMixSelectionHysteresis : stream->level;
+    };
+    std::partial_sort(m_mixCandidates.begin(),
+                      m_mixCandidates.begin() + kMaxMixedStreams,
+                      m_mixCandidates.end(),
+                      [&score](const RxStreamState* a, const RxStreamState* b) {
+                          return score(a) > score(b);
+                      });
+    for (int i = 0; i < count; ++i)
+        m_mixCandidates.at(i)->mixSelected = i < kMaxMixedStreams;
+}
+
+int ChannelManager::playoutFrameSamples() const
+{
+    return mixFrameSamples();
+}
+
+bool ChannelManager::renderPlayout(QSpan<qint16> out)
+{
+    const int samples = mixFrameSamples();
+    if (m_streams.isEmpty() || samples <= 0 || static_cast<int>(out.size()) != samples)
+    {
+        std::fill(out.begin(), out.end(), qint16(0));
+        m_mixer.reset();
+        return false;
+    }
+
+    m_mixer.configure(samples, m_mixSampleRate);
+    m_mixer.begin();
+    m_playoutRemovals.clear();
+    m_playoutCompletions.clear();
+
+    selectMixedStreams();
+    for (quint32 senderId : std::as_const(m_playoutOrder))
+    {
+        RxStreamState* stream = m_streams.value(senderId, nullptr);
+        if (!stream)
+            continue;
+
+        const StreamRenderResult render = stream->mixSelected
+                                              ? renderStreamFrame(stream)
+                                              : skimStreamFrame(stream, stream->mixProbe);
+        if (render.audible)
+            m_mixer.add(stream->frameSamples, stream->mixGain, stream->mixPan);
         if (render.removeStream)
         {
-            removeTalkers.append(senderId);
+            m_playoutRemovals.append(senderId);
             if (render.releaseCompleted && render.talkerId != 0)
-                completedTalkers.append(render.talkerId);
+                m_playoutCompletions.append(render.talkerId);
         }
     }
 
-    if (mix.isEmpty())
-        return;
+    const bool audible = !m_mixer.idle();
+    if (audible)
+        m_mixer.mixTo(out);
+    else
+        std::fill(out.begin(), out.end(), qint16(0));
 
-    QVector<qint16> mixedSamples;
-    mixedSamples.reserve(mix.size());
-    const int divisor = qMax(1, contributingStreams);
-    for (int value : std::as_const(mix))
+    if (audible)
     {
-        const int scaled = value / divisor;
-        mixedSamples.append(static_cast<qint16>(qBound(-32768, scaled, 32767)));
+        if (m_mixedPcm.size() != m_playoutPcmBytes)
+            m_mixedPcm.resize(m_playoutPcmBytes);
+        qToLittleEndian<qint16>(out.data(), samples, m_mixedPcm.data());
+        emit audioFrameReceived(m_mixedPcm);
+    }
+    else
+    {
+        emit audioFrameReceived(m_silenceFrame);
     }
 
-    const QByteArray mixedPcm = samplesToPcm(mixedSamples, 0, mixedSamples.size());
-    m_audioOutput->playFrame(anyAudible ? mixedPcm : m_silenceFrame);
-    emit audioFrameReceived(anyAudible ? mixedPcm : m_silenceFrame);
-
-    for (quint32 senderId : std::as_const(removeTalkers))
+    for (quint32 senderId : std::as_const(m_playoutRemovals))
         deleteStream(senderId);
-    for (quint32 talkerId : std::as_const(completedTalkers))
+    for (quint32 talkerId : std::as_const(m_playoutCompletions))
         emit talkReleasePlayoutCompleted(talkerId);
 
+    prewarmStreamCodec();
+    if (m_streams.isEmpty())
+        m_mixer.reset();
+    return audible;
+}
+
+PlayoutStats ChannelManager::playoutStats() const
+{
+    PlayoutStats stats;
+    stats.decodedFrames = m_decodedFrames;
+    stats.playedFrames = m_playedFrames;
+    stats.concealedFrames = m_concealedFrames;
+    stats.fecRecoveredFrames = m_fecRecoveredFrames;
+    stats.bufferedUsTotal = m_bufferedUsTotal;
+    return stats;
+}
+
+void ChannelManager::ensurePlayoutRunning()
+{
+    // The audio sink pulls playout on its own clock; the timer only drives
+    // playout when no sink is running, so streams still drain and complete.
+    if (m_audioOutput && m_audioOutput->startPlayout())
+    {
+        m_playoutTimer.stop();
+        return;
+    }
+    if (!m_playoutTimer.isActive())
+        m_playoutTimer.start();
+}
+
+void ChannelManager::onPlayoutTick()
+{
+    if (m_audioOutput && m_audioOutput->playoutActive())
+    {
+        m_playoutTimer.stop();
+        return;
+    }
+
+    if (m_streams.isEmpty())
+    {
+        m_playoutTimer.stop();
+        m_mixer.reset();
+        return;
+    }
+
+    const int samples = mixFrameSamples();
+    if (m_mixedSamples.size() != samples)
+        m_mixedSamples.resize(samples);
+    renderPlayout(m_mixedSamples);
+
     if (m_streams.isEmpty())
         m_playoutTimer.stop();
 }
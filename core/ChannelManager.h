@@ -11,7 +11,10 @@
 #include <QVector>
 #include <QtGlobal>
 
+#include "audio/AudioMixer.h"
+#include "audio/AudioPlayoutSource.h"
 #include "audio/AudioResampler.h"
+#include "audio/SampleRing.h"
 #include "net/Packetizer.h"
 #include "net/Fec.h"
 
@@ -29,7 +32,21 @@ struct ChannelConfig
     QString password;
 };
 
-class ChannelManager : public QObject
+// Running playout counters, summed over all streams.
+struct PlayoutStats
+{
+    quint64 decodedFrames = 0;
+    quint64 playedFrames = 0;
+    // Ticks a talking stream ran dry and played its decaying tail or
+    // silence instead.
+    quint64 concealedFrames = 0;
+    quint64 fecRecoveredFrames = 0;
+    // Audio still queued (jitter buffer plus decoded PCM) behind each
+    // played frame, summed; divide by playedFrames for the mean delay.
+    quint64 bufferedUsTotal = 0;
+};
+
+class ChannelManager : public QObject, public AudioPlayoutSource
 {
     Q_OBJECT
 
@@ -60,6 +77,13 @@ public:
                                      int port,
                                      const QString& password);
     Q_INVOKABLE void disconnectFromServer();
+    // Per-talker mix hooks. Gain is linear (1.0 = unity); pan runs from -1
+    // (left) to +1 (right) and only applies when the mixer runs in stereo.
+    // Playout is mono for now, so pan is stored but not yet audible.
+    Q_INVOKABLE void setTalkerGain(quint32 talkerId, qreal gain);
+    Q_INVOKABLE void setTalkerPan(quint32 talkerId, qreal pan);
+    // Priority talkers are always mixed, on top of the loudest few others.
+    Q_INVOKABLE void setTalkerPriority(quint32 talkerId, bool priority);
 
     bool joinChannel(const ChannelConfig& config);
     void leaveChannel();
@@ -68,6 +92,10 @@ public:
     QString targetAddress() const;
     quint16 targetPort() const;
 
+    int playoutFrameSamples() const override;
+    bool renderPlayout(QSpan<qint16> out) override;
+    PlayoutStats playoutStats() const;
+
 signals:
     void channelReady();
     void channelError(const QString& message);
@@ -104,6 +132,13 @@ private:
         int codecId = Proto::CODEC_TRANSPORT_CODEC2;
     };
 
+    struct TalkerMix
+    {
+        float gain = 1.0f;
+        float pan = 0.0f;
+        bool priority = false;
+    };
+
     struct RxStreamState
     {
         quint32 senderId = 0;
@@ -119,13 +154,39 @@ private:
         bool talkEnded = false;
         bool releaseCompletionPending = false;
         int pcmMissCount = 0;
-        QByteArray lastPcmFrame;
-        QVector<qint16> pendingMixedSamples;
+        bool hasLastFrame = false;
+        float mixGain = 1.0f;
+        float mixPan = 0.0f;
+        bool mixPriority = false;
+        bool mixSelected = true;
+        bool mixProbe = false;
+        // Mean absolute sample level (EMA) of decoded frames.
+        float level = 0.0f;
+        bool levelKnown = false;
+        int skimCreditMs = 0;
+        // Smoothed jitter fill (ms, <0 until measured) steering the
+        // resampler's drift correction.
+        double fillEmaMs = -1.0;
+        double driftIntegralPpm = 0.0;
+        int driftTicks = 0;
+        // Set by a sender's silence marker: once buffered speech runs out,
+        // comfort noise at the background level of its recent frames plays
+        // until the next talkspurt primes again.
+        bool comfortNoise = false;
+        float comfortLevel = 0.0f;
+        bool comfortLevelKnown = false;
+        quint32 comfortSeed = 0x9e3779b9u;
+        QVector<qint16> decodedSamples;
+        QVector<qint16> resampledSamples;
+        QVector<qint16> frameSamples;
+        QVector<qint16> lastFrame;
+        SampleRing pendingSamples;
     };
 
+    // The rendered frame is left in RxStreamState::frameSamples.
     struct StreamRenderResult
     {
-        QByteArray pcm;
+        bool audible = false;
         bool removeStream = false;
         bool releaseCompleted = false;
         quint32 talkerId = 0;
@@ -138,14 +199,23 @@ private:
     void emitPlayoutTalkersState();
     RxStreamState* ensureStream(quint32 senderId);
     void deleteStream(quint32 senderId);
-    void applyTemplateLibraryPaths(RxStreamState* stream);
+    void applyTemplateLibraryPaths(Codec2Wrapper* codec);
+    RxCodecConfig streamCodecConfig(const RxStreamState* stream) const;
     void applyStreamCodecConfig(RxStreamState* stream, bool resetState);
+    Codec2Wrapper* acquireStreamCodec(const RxCodecConfig& config);
+    void recycleStreamCodec(Codec2Wrapper* codec);
+    void prewarmStreamCodecs(int count);
+    void prewarmStreamCodec();
     void resetStreamState(RxStreamState* stream, bool clearBuffers);
     int mixFrameSamples() const;
     int streamMinBufferedFrames(const RxStreamState* stream) const;
     void updateStreamJitterTargets();
     void updatePlayoutParams();
+    void ensurePlayoutRunning();
+    void updateStreamDrift(RxStreamState* stream);
     StreamRenderResult renderStreamFrame(RxStreamState* stream);
+    StreamRenderResult skimStreamFrame(RxStreamState* stream, bool probe);
+    void selectMixedStreams();
 
     ChannelConfig m_config;
     UdpTransport* m_transport = nullptr;
@@ -161,7 +231,21 @@ private:
     int m_mixSampleRate = 16000;
     QByteArray m_silenceFrame;
     QHash<quint32, RxStreamState*> m_streams;
+    QVector<quint32> m_playoutOrder;
+    QHash<quint32, TalkerMix> m_talkerMix;
+    QHash<quint32, double> m_talkerDriftPpm;
+    QVector<RxStreamState*> m_mixCandidates;
+    int m_mixProbeCursor = 0;
+    AudioMixer m_mixer;
+    QVector<qint16> m_mixedSamples;
+    QByteArray m_mixedPcm;
+    QVector<quint32> m_playoutRemovals;
+    QVector<quint32> m_playoutCompletions;
     QHash<quint32, RxCodecConfig> m_codecConfigCache;
+    // Idle RX decoders keyed by codec id and mode, reused across talkers.
+    QHash<quint32, QVector<Codec2Wrapper*>> m_streamCodecPool;
+    int m_streamCodecPoolSize = 0;
+    int m_streamCodecPrewarmTarget = 0;
     QSet<quint32> m_activeTalkers;
     bool m_fecEnabled = false;
     bool m_serverMultiTalkEnabled = false;
@@ -170,4 +254,12 @@ private:
     QTimer m_joinRetryTimer;
     int m_joinRetryMs = 1000;
     int m_joinRetriesLeft = 0;
+
+    // Playout statistics. Datagrams and playout (pull-mode readData or the
+    // fallback timer) both run on this object's thread.
+    quint64 m_decodedFrames = 0;
+    quint64 m_playedFrames = 0;
+    quint64 m_concealedFrames = 0;
+    quint64 m_fecRecoveredFrames = 0;
+    quint64 m_bufferedUsTotal = 0;
 };
@@ -2,20 +2,17 @@
 
 #include "audio/AudioInput.h"
 #include "codec/Codec2Wrapper.h"
+#include "core/TxPipeline.h"
 #include "net/Packetizer.h"
 #include "net/udptransport.h"
 
-#include <QtEndian>
-#include <cstring>
+#include <utility>
+
+static constexpr int kPreRollMs = 300;
 
 PttController::PttController(QObject* parent)
     : QObject(parent)
 {
-    m_txTimer.setTimerType(Qt::PreciseTimer);
-    m_txTimer.setInterval(20);
-    connect(&m_txTimer, &QTimer::timeout,
-            this, &PttController::onTxTick);
-
     m_txStartDelayTimer.setSingleShot(true);
     connect(&m_txStartDelayTimer, &QTimer::timeout,
             this, &PttController::onDelayedTxStart);
@@ -25,12 +22,37 @@ PttController::PttController(QObject* parent)
     connect(&m_inputIdleTimer, &QTimer::timeout,
             this, &PttController::onInputIdleTimeout);
 
+    m_pipeline = new TxPipeline;
+    m_pipeline->moveToThread(&m_txThread);
+    connect(m_pipeline, &TxPipeline::finished,
+            this, &PttController::onPipelineFinished);
+    connect(m_pipeline, &TxPipeline::queueDelayChanged,
+            this, &PttController::onPipelineQueueDelayChanged);
+    connect(m_pipeline, &TxPipeline::framesDropped,
+            this, &PttController::onPipelineFramesDropped);
+    m_txThread.setObjectName(QStringLiteral("IncomUdonTx"));
+    m_txThread.start(QThread::HighPriority);
+
 #ifdef Q_OS_ANDROID
     // Keep a short guard to avoid unstable start on some Android devices.
     m_txStartGuardMs = 0;
 #endif
 }
 
+PttController::~PttController()
+{
+    QMetaObject::invokeMethod(m_pipeline, &TxPipeline::abort, Qt::BlockingQueuedConnection);
+    m_txThread.quit();
+    m_txThread.wait();
+    delete m_pipeline;
+}
+
+template <typename Fn>
+void PttController::runOnPipeline(Fn&& fn)
+{
+    QMetaObject::invokeMethod(m_pipeline, std::forward<Fn>(fn), Qt::QueuedConnection);
+}
+
 void PttController::setAudioInput(AudioInput* input)
 {
     if (m_audioInput == input)
@@ -52,32 +74,30 @@ void PttController::setAudioInput(AudioInput* input)
 void PttController::setCodec(Codec2Wrapper* codec)
 {
     m_codec = codec;
+    runOnPipeline([pipeline = m_pipeline, codec]() { pipeline->setCodec(codec); });
 }
 
 void PttController::setCipher(AeadCipher* cipher)
 {
     m_cipher = cipher;
+    runOnPipeline([pipeline = m_pipeline, cipher]() { pipeline->setCipher(cipher); });
 }
 
 void PttController::setPacketizer(Packetizer* packetizer)
 {
     m_packetizer = packetizer;
+    runOnPipeline([pipeline = m_pipeline, packetizer]() { pipeline->setPacketizer(packetizer); });
 }
 
 void PttController::setTransport(UdpTransport* transport)
 {
     m_transport = transport;
+    runOnPipeline([pipeline = m_pipeline, transport]() { pipeline->setTransport(transport); });
 }
 
 void PttController::setFecEnabled(bool enabled)
 {
-    if (m_fecEnabled == enabled)
-        return;
-
-    m_fecEnabled = enabled;
-    m_fec.setEnabled(enabled);
-    m_fec.reset();
-    m_audioSeq = 0;
+    runOnPipeline([pipeline = m_pipeline, enabled]() { pipeline->setFecEnabled(enabled); });
 }
 
 void PttController::setAlwaysKeepInputSession(bool enabled)
@@ -118,6 +138,7 @@ void PttController::setTarget(const QHostAddress& address, quint16 port)
 {
     m_targetAddress = address;
     m_targetPort = port;
+    runOnPipeline([pipeline = m_pipeline, address, port]() { pipeline->setTarget(address, port); });
 }
 
 bool PttController::pttPressed() const
@@ -125,6 +146,16 @@ bool PttController::pttPressed() const
     return m_pttPressed;
 }
 
+int PttController::txQueueDelayMs() const
+{
+    return m_txQueueDelayMs;
+}
+
+int PttController::txDroppedFrames() const
+{
+    return m_txDroppedFrames;
+}
+
 void PttController::setPttPressed(bool pressed)
 {
     if (m_pttPressed == pressed)
@@ -139,10 +170,7 @@ void PttController::setPttPressed(bool pressed)
 
         // Keep draining queued TX audio first; send PTT_OFF afterwards.
         m_pendingPttOff = true;
-        if (!m_txTimer.isActive())
-            m_txTimer.start();
-        if (m_txQueue.isEmpty())
-            onTxTick();
+        finishTx(true);
         scheduleInputIdleStop();
         return;
     }
@@ -183,21 +211,16 @@ void PttController::setTalkAllowed(bool allowed)
     {
         m_txStartDelayTimer.stop();
 
-        // If release is pending, keep timer alive until queued frames are handled.
+        // Release is pending: whatever is still queued can no longer be
+        // sent, so finish right away and send PTT_OFF.
         if (!m_pttPressed && m_pendingPttOff)
         {
-            if (!m_txTimer.isActive())
-                m_txTimer.start();
-            if (m_txQueue.isEmpty())
-                onTxTick();
+            finishTx(false);
             return;
         }
 
         m_pendingPttOff = false;
-        m_txTimer.stop();
-        m_txQueue.clear();
-        m_fec.reset();
-        m_audioSeq = 0;
+        abortTx();
         emit txStopped();
         scheduleInputIdleStop();
     }
@@ -231,36 +254,82 @@ void PttController::tryStartTx()
     if (!m_audioInput->isRunning())
         return;
 
-    const int frameMs = (m_codec && m_codec->frameMs() > 0) ? m_codec->frameMs() : 20;
-    m_txTimer.setInterval(frameMs);
-    m_txQueue.clear();
-    m_fec.reset();
-    m_audioSeq = 0;
-    m_txTimer.start();
+    ++m_txSession;
+    m_txRunning = true;
+    runOnPipeline([pipeline = m_pipeline]() { pipeline->start(); });
     emit txStarted();
 }
 
-void PttController::onAudioFrameReady(const QByteArray& pcmFrame)
+void PttController::finishTx(bool flush)
 {
-    if (!m_pttPressed || !m_talkAllowed)
-        return;
+    m_txRunning = false;
+    runOnPipeline([pipeline = m_pipeline, session = m_txSession, flush]() {
+        pipeline->finish(session, flush);
+    });
+}
 
-    if (!m_codec || !m_cipher || !m_packetizer || !m_transport)
+void PttController::abortTx()
+{
+    m_txRunning = false;
+    runOnPipeline([pipeline = m_pipeline]() { pipeline->abort(); });
+}
+
+void PttController::onAudioFrameReady(const QByteArray& pcmFrame, bool speech)
+{
+    if (!m_txRunning || !m_cipher || !m_cipher->isReady())
+    {
+        // Buffer only while the mic is deliberately kept open or a press is
+        // waiting on the grant, input warm-up or the cipher.
+        if (m_pttPressed || m_alwaysKeepInputSession || m_rxHoldActive)
+            storePreRoll(pcmFrame);
         return;
+    }
+
+    if (!m_preRoll.isEmpty())
+        flushPreRoll();
+    pushTxFrame(pcmFrame, speech);
+}
 
-    if (!m_cipher->isReady())
+void PttController::pushTxFrame(const QByteArray& pcmFrame, bool speech, bool backlog)
+{
+    if (m_pipeline->pushFrame(pcmFrame, speech, backlog))
         return;
+    ++m_txDroppedFrames;
+    emit txDroppedFramesChanged();
+}
 
-    const QByteArray codecFrame = m_codec->encode(pcmFrame);
-    if (m_codec && m_codec->frameMs() > 0 && m_txTimer.interval() != m_codec->frameMs())
-        m_txTimer.setInterval(m_codec->frameMs());
+void PttController::storePreRoll(const QByteArray& pcmFrame)
+{
+    const int frameSamples = static_cast<int>(pcmFrame.size() / sizeof(qint16));
+    if (frameSamples <= 0)
+        return;
+    // A codec switch changes the frame size; audio at the old rate is useless.
+    if (m_preRollFrame.size() != pcmFrame.size())
+    {
+        m_preRoll.clear();
+        m_preRollFrame.resize(pcmFrame.size());
+    }
 
-    m_txQueue.enqueue(codecFrame);
-    while (m_txQueue.size() > m_txQueueMaxFrames)
-        m_txQueue.dequeue();
+    const int frameMs = (m_codec && m_codec->frameMs() > 0) ? m_codec->frameMs() : 20;
+    const int capacity = qMax(1, kPreRollMs / frameMs) * frameSamples;
+    m_preRoll.reserve(capacity);
+    m_preRoll.discard(m_preRoll.size() + frameSamples - capacity);
+    m_preRoll.write(QSpan<const qint16>(reinterpret_cast<const qint16*>(pcmFrame.constData()),
+                                        frameSamples));
+}
 
-    if (!m_txTimer.isActive())
-        m_txTimer.start();
+void PttController::flushPreRoll()
+{
+    // Hand the buffered audio over ahead of the live frame as a backlog,
+    // which the pipeline drains at its catch-up rate instead of in a burst.
+    const int frameSamples = static_cast<int>(m_preRollFrame.size() / sizeof(qint16));
+    const QSpan<qint16> frame(reinterpret_cast<qint16*>(m_preRollFrame.data()), frameSamples);
+    while (frameSamples > 0 && m_preRoll.size() >= frameSamples)
+    {
+        m_preRoll.read(frame);
+        pushTxFrame(m_preRollFrame, true, true);
+    }
+    m_preRoll.clear();
 }
 
 void PttController::onInputRunningChanged()
@@ -269,7 +338,10 @@ void PttController::onInputRunningChanged()
         return;
 
     if (!m_audioInput->isRunning())
+    {
+        m_preRoll.clear();
         return;
+    }
 
     if (m_pttPressed && m_talkAllowed)
     {
@@ -278,44 +350,36 @@ void PttController::onInputRunningChanged()
     }
 }
 
-void PttController::onTxTick()
+void PttController::onPipelineFinished(quint32 session)
 {
-    const bool canSendAudio = m_codec && m_cipher && m_packetizer && m_transport &&
-                              m_cipher->isReady() && m_talkAllowed;
-
-    if (canSendAudio && !m_txQueue.isEmpty())
-    {
-        sendCodecFrame(m_txQueue.dequeue());
+    // A finish from an older session, or one overtaken by a new press.
+    if (session != m_txSession || !m_pendingPttOff || m_txRunning)
         return;
-    }
 
-    if (m_pendingPttOff)
+    if (m_packetizer && m_transport &&
+        !m_targetAddress.isNull() && m_targetPort != 0)
     {
-        // If we can't send remaining queued frames anymore, drop them and finish.
-        if (!m_txQueue.isEmpty())
-            m_txQueue.clear();
+        const QByteArray packet = m_packetizer->packPlain(Proto::PKT_PTT_OFF, QByteArray());
+        m_transport->send(packet, m_targetAddress, m_targetPort);
+    }
 
-        if (m_packetizer && m_transport &&
-            !m_targetAddress.isNull() && m_targetPort != 0)
-        {
-            const QByteArray packet = m_packetizer->packPlain(Proto::PKT_PTT_OFF, QByteArray());
-            m_transport->send(packet, m_targetAddress, m_targetPort);
-        }
+    m_pendingPttOff = false;
+    emit txStopped();
+    scheduleInputIdleStop();
+}
 
-        m_pendingPttOff = false;
-        m_txTimer.stop();
-        m_fec.reset();
-        m_audioSeq = 0;
-        emit txStopped();
-        scheduleInputIdleStop();
+void PttController::onPipelineQueueDelayChanged(int delayMs)
+{
+    if (m_txQueueDelayMs == delayMs)
         return;
-    }
+    m_txQueueDelayMs = delayMs;
+    emit txQueueDelayMsChanged();
+}
 
-    if (!m_pttPressed && m_txQueue.isEmpty())
-    {
-        m_txTimer.stop();
-        scheduleInputIdleStop();
-    }
+void PttController::onPipelineFramesDropped(int count)
+{
+    m_txDroppedFrames += count;
+    emit txDroppedFramesChanged();
 }
 
 void PttController::onInputIdleTimeout()
@@ -323,7 +387,7 @@ void PttController::onInputIdleTimeout()
     if (!m_audioInput)
         return;
     if (m_alwaysKeepInputSession || m_rxHoldActive ||
-        m_pttPressed || m_pendingPttOff || m_txTimer.isActive())
+        m_pttPressed || m_pendingPttOff || m_txRunning)
         return;
 
     m_audioInput->stop();
@@ -349,7 +413,7 @@ void PttController::scheduleInputIdleStop()
         ensureInputSession();
         return;
     }
-    if (m_rxHoldActive || m_pttPressed || m_pendingPttOff || m_txTimer.isActive())
+    if (m_rxHoldActive || m_pttPressed || m_pendingPttOff || m_txRunning)
     {
         m_inputIdleTimer.stop();
         return;
@@ -358,45 +422,3 @@ void PttController::scheduleInputIdleStop()
         return;
     m_inputIdleTimer.start();
 }
-
-void PttController::sendCodecFrame(const QByteArray& codecFrame)
-{
-    const quint64 nonce = m_cipher->nextNonce();
-
-    QByteArray payload(2 + codecFrame.size(), 0);
-    qToBigEndian(m_audioSeq, reinterpret_cast<uchar*>(payload.data()));
-    if (!codecFrame.isEmpty())
-        std::memcpy(payload.data() + 2, codecFrame.constData(), codecFrame.size());
-
-    const AeadResult enc = m_cipher->encrypt(payload, nonce, QByteArray());
-    const QByteArray packet = m_packetizer->pack(Proto::PKT_AUDIO,
-                                                 enc.ciphertext,
-                                                 enc.tag,
-                                                 nonce);
-
-    if (!m_targetAddress.isNull() && m_targetPort != 0)
-        m_transport->send(packet, m_targetAddress, m_targetPort);
-
-    if (m_fecEnabled)
-    {
-        const QVector<FecParityPacket> parity = m_fec.addFrame(m_audioSeq, codecFrame);
-        for (const FecParityPacket& pkt : parity)
-        {
-            QByteArray fecPayload(4, 0);
-            qToBigEndian(pkt.blockStart, reinterpret_cast<uchar*>(fecPayload.data()));
-            fecPayload[2] = static_cast<char>(pkt.blockSize);
-            fecPayload[3] = static_cast<char>(pkt.parityIndex);
-            fecPayload.append(pkt.data);
-
-            const quint64 fecNonce = m_cipher->nextNonce();
-            const AeadResult fecEnc = m_cipher->encrypt(fecPayload, fecNonce, QByteArray());
-            const QByteArray fecPacket = m_packetizer->pack(Proto::PKT_FEC,
-                                                            fecEnc.ciphertext,
-                                                            fecEnc.tag,
-                                                            fecNonce);
-            if (!m_targetAddress.isNull() && m_targetPort != 0)
-                m_transport->send(fecPacket, m_targetAddress, m_targetPort);
-        }
-    }
-    m_audioSeq++;
-}
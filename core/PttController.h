@@ -4,16 +4,17 @@
 #include <QByteArray>
 #include <QHostAddress>
 #include <QElapsedTimer>
-#include <QQueue>
+#include <QThread>
 #include <QTimer>
 #include <QtGlobal>
 
+#include "audio/SampleRing.h"
 #include "crypto/AeadCipher.h"
-#include "net/Fec.h"
 
 class AudioInput;
 class Codec2Wrapper;
 class Packetizer;
+class TxPipeline;
 class UdpTransport;
 
 class PttController : public QObject
@@ -24,9 +25,16 @@ class PttController : public QObject
                READ pttPressed
                WRITE setPttPressed
                NOTIFY pttPressedChanged)
+    Q_PROPERTY(int txQueueDelayMs
+               READ txQueueDelayMs
+               NOTIFY txQueueDelayMsChanged)
+    Q_PROPERTY(int txDroppedFrames
+               READ txDroppedFrames
+               NOTIFY txDroppedFramesChanged)
 
 public:
     explicit PttController(QObject* parent = nullptr);
+    ~PttController() override;
 
     void setAudioInput(AudioInput* input);
     void setCodec(Codec2Wrapper* codec);
@@ -40,6 +48,10 @@ public:
     void setTarget(const QHostAddress& address, quint16 port);
 
     bool pttPressed() const;
+    // Smoothed time encoded frames wait before they are sent.
+    int txQueueDelayMs() const;
+    // Frames dropped for exceeding the TX latency budget since start.
+    int txDroppedFrames() const;
 
 public slots:
     void setPttPressed(bool pressed);
@@ -49,17 +61,28 @@ signals:
     void pttPressedChanged();
     void txStarted();
     void txStopped();
+    void txQueueDelayMsChanged();
+    void txDroppedFramesChanged();
 
 private slots:
-    void onAudioFrameReady(const QByteArray& pcmFrame);
+    void onAudioFrameReady(const QByteArray& pcmFrame, bool speech);
     void onInputRunningChanged();
-    void onTxTick();
     void onDelayedTxStart();
     void onInputIdleTimeout();
+    void onPipelineFinished(quint32 session);
+    void onPipelineQueueDelayChanged(int delayMs);
+    void onPipelineFramesDropped(int count);
 
 private:
+    template <typename Fn>
+    void runOnPipeline(Fn&& fn);
+
     void tryStartTx();
-    void sendCodecFrame(const QByteArray& codecFrame);
+    void finishTx(bool flush);
+    void abortTx();
+    void pushTxFrame(const QByteArray& pcmFrame, bool speech, bool backlog = false);
+    void storePreRoll(const QByteArray& pcmFrame);
+    void flushPreRoll();
     void ensureInputSession();
     void scheduleInputIdleStop();
 
@@ -69,22 +92,29 @@ private:
     Packetizer* m_packetizer = nullptr;
     UdpTransport* m_transport = nullptr;
 
+    // Encode/FEC/encrypt/send run on m_txThread; this object only keeps
+    // PTT and session state.
+    QThread m_txThread;
+    TxPipeline* m_pipeline = nullptr;
+    bool m_txRunning = false;
+    quint32 m_txSession = 0;
+
     QHostAddress m_targetAddress;
     quint16 m_targetPort = 0;
     bool m_pttPressed = false;
     bool m_talkAllowed = false;
     bool m_pendingPttOff = false;
-    bool m_fecEnabled = false;
     bool m_alwaysKeepInputSession = false;
     bool m_rxHoldActive = false;
-    quint16 m_audioSeq = 0;
-    FecEncoder m_fec;
-    QTimer m_txTimer;
     QTimer m_txStartDelayTimer;
     QTimer m_inputIdleTimer;
     QElapsedTimer m_pttPressedElapsed;
     int m_txStartGuardMs = 0;
     int m_inputIdleTimeoutMs = 60000;
-    QQueue<QByteArray> m_txQueue;
-    int m_txQueueMaxFrames = 12;
+    int m_txQueueDelayMs = 0;
+    int m_txDroppedFrames = 0;
+    // Recent mic audio kept while the input session is up but not sending,
+    // so the first syllable after a PTT press is not clipped.
+    SampleRing m_preRoll;
+    QByteArray m_preRollFrame;
 };
@@ -0,0 +1,299 @@
+#include "TxPipeline.h"
+
+#include "codec/Codec2Wrapper.h"
+#include "crypto/AeadCipher.h"
+#include "net/Packetizer.h"
+#include "net/udptransport.h"
+
+#include <cstring>
+
+// While the VAD reports silence only a payload-less AUDIO packet goes out,
+// repeated so late joiners and the server still see the talker as active.
+static constexpr int kSilenceMarkerIntervalFrames = 25;
+// Frames older than this are dropped rather than sent late; a backlog is
+// drained at up to kCatchUpFramesPerTick frames per codec frame period.
+static constexpr int kTxLatencyBudgetMs = 200;
+static constexpr int kCatchUpFramesPerTick = 2;
+static constexpr int kMaxTxQueueFrames = 64;
+// One AUDIO packet plus the parity packets it may complete.
+static constexpr int kMaxPacketsPerFrame = 1 + FecEncoder::kParityPackets;
+
+TxPipeline::TxPipeline(QObject* parent)
+    : QObject(parent),
+      m_tickTimer(this)
+{
+    m_clock.start();
+    m_tickTimer.setTimerType(Qt::PreciseTimer);
+    m_tickTimer.setInterval(20);
+    connect(&m_tickTimer, &QTimer::timeout,
+            this, &TxPipeline::onTick);
+}
+
+bool TxPipeline::pushFrame(const QByteArray& pcmFrame, bool speech, bool backlog)
+{
+    const int tail = m_inputTail.load(std::memory_order_relaxed);
+    const int next = (tail + 1) % kInputSlots;
+    if (next == m_inputHead.load(std::memory_order_acquire))
+        return false;
+
+    InputSlot& slot = m_input[tail];
+    if (slot.pcmFrame.size() != pcmFrame.size())
+        slot.pcmFrame.resize(pcmFrame.size());
+    std::memcpy(slot.pcmFrame.data(), pcmFrame.constData(), pcmFrame.size());
+    slot.speech = speech;
+    slot.backlog = backlog;
+    m_inputTail.store(next, std::memory_order_release);
+
+    // One wake-up in flight is enough; processInput() drains everything.
+    if (!m_wakePending.exchange(true, std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this, &TxPipeline::processInput, Qt::QueuedConnection);
+    return true;
+}
+
+void TxPipeline::setCodec(Codec2Wrapper* codec)
+{
+    m_codec = codec;
+}
+
+void TxPipeline::setCipher(AeadCipher* cipher)
+{
+    m_cipher = cipher;
+}
+
+void TxPipeline::setPacketizer(Packetizer* packetizer)
+{
+    m_packetizer = packetizer;
+}
+
+void TxPipeline::setTransport(UdpTransport* transport)
+{
+    m_transport = transport;
+}
+
+void TxPipeline::setTarget(const QHostAddress& address, quint16 port)
+{
+    m_targetAddress = address;
+    m_targetPort = port;
+}
+
+void TxPipeline::setFecEnabled(bool enabled)
+{
+    if (m_fecEnabled == enabled)
+        return;
+
+    m_fecEnabled = enabled;
+    m_fec.setEnabled(enabled);
+    m_fec.reset();
+    m_audioSeq = 0;
+}
+
+void TxPipeline::start()
+{
+    resetSession();
+    m_active = true;
+    const int frameMs = (m_codec && m_codec->frameMs() > 0) ? m_codec->frameMs() : 20;
+    m_tickTimer.setInterval(frameMs);
+    m_tickTimer.start();
+    recordQueueDelay(0);
+    processInput();
+}
+
+void TxPipeline::finish(quint32 session, bool flush)
+{
+    m_finishing = true;
+    m_finishSession = session;
+    if (flush)
+        processInput();
+    if (!flush || m_queue.isEmpty() || !canSend())
+        completeFinish();
+}
+
+void TxPipeline::abort()
+{
+    discardInput();
+    resetSession();
+}
+
+void TxPipeline::processInput()
+{
+    m_wakePending.store(false, std::memory_order_release);
+    // Frames pushed before start() is delivered wait in the ring.
+    if (!m_active)
+        return;
+
+    int head = m_inputHead.load(std::memory_order_relaxed);
+    while (head != m_inputTail.load(std::memory_order_acquire))
+    {
+        encodeInput(m_input[head]);
+        head = (head + 1) % kInputSlots;
+        m_inputHead.store(head, std::memory_order_release);
+    }
+    flushPackets();
+}
+
+void TxPipeline::discardInput()
+{
+    m_inputHead.store(m_inputTail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void TxPipeline::encodeInput(const InputSlot& slot)
+{
+    if (!canSend())
+        return;
+
+    if (!slot.speech)
+    {
+        if (m_silentFrames++ % kSilenceMarkerIntervalFrames == 0)
+            enqueueFrame(QByteArray(), slot.backlog);
+        return;
+    }
+    m_silentFrames = 0;
+
+    const QByteArray codecFrame = m_codec->encode(slot.pcmFrame);
+    if (!codecFrame.isEmpty())
+        enqueueFrame(codecFrame, slot.backlog);
+}
+
+bool TxPipeline::canSend() const
+{
+    return m_active && m_codec && m_cipher && m_packetizer && m_transport &&
+           m_cipher->isReady();
+}
+
+void TxPipeline::enqueueFrame(const QByteArray& codecFrame, bool backlog)
+{
+    if (m_codec && m_codec->frameMs() > 0 && m_tickTimer.interval() != m_codec->frameMs())
+        m_tickTimer.setInterval(m_codec->frameMs());
+    if (!m_tickTimer.isActive())
+        m_tickTimer.start();
+
+    // Nothing is waiting, so there is no reason to hold a live frame for a
+    // tick. Anything else goes behind the backlog to keep the order.
+    if (!backlog && m_queue.isEmpty())
+    {
+        recordQueueDelay(0);
+        sendCodecFrame(codecFrame);
+        return;
+    }
+
+    // Back-to-back silence markers carry nothing new; keep the older one.
+    if (codecFrame.isEmpty() && !m_queue.isEmpty() && m_queue.constLast().codecFrame.isEmpty())
+        return;
+
+    m_queue.enqueue(TxFrame{codecFrame, m_clock.elapsed()});
+    enforceLatencyBudget();
+}
+
+void TxPipeline::sendQueuedFrame()
+{
+    const TxFrame frame = m_queue.dequeue();
+    recordQueueDelay(m_clock.elapsed() - frame.enqueuedMs);
+    sendCodecFrame(frame.codecFrame);
+}
+
+void TxPipeline::enforceLatencyBudget()
+{
+    const qint64 now = m_clock.elapsed();
+    int dropped = 0;
+    while (!m_queue.isEmpty() &&
+           (m_queue.size() > kMaxTxQueueFrames ||
+            now - m_queue.head().enqueuedMs > kTxLatencyBudgetMs))
+    {
+        m_queue.dequeue();
+        ++dropped;
+    }
+    if (dropped > 0)
+        emit framesDropped(dropped);
+}
+
+void TxPipeline::recordQueueDelay(qint64 delayMs)
+{
+    m_queueDelayEmaMs += 0.1 * (static_cast<double>(delayMs) - m_queueDelayEmaMs);
+    const int rounded = qRound(m_queueDelayEmaMs);
+    if (rounded == m_queueDelayMs)
+        return;
+    m_queueDelayMs = rounded;
+    emit queueDelayChanged(rounded);
+}
+
+void TxPipeline::onTick()
+{
+    enforceLatencyBudget();
+    if (canSend() && !m_queue.isEmpty())
+    {
+        for (int i = 0; i < kCatchUpFramesPerTick && !m_queue.isEmpty(); ++i)
+            sendQueuedFrame();
+        flushPackets();
+        if (!m_finishing || !m_queue.isEmpty())
+            return;
+    }
+
+    if (m_finishing)
+    {
+        // If the rest can no longer be sent, drop it and finish.
+        completeFinish();
+        return;
+    }
+
+    if (!m_active && m_queue.isEmpty())
+        m_tickTimer.stop();
+}
+
+void TxPipeline::completeFinish()
+{
+    const quint32 session = m_finishSession;
+    // Whatever was built goes out before finished() lets PTT_OFF follow.
+    flushPackets();
+    discardInput();
+    resetSession();
+    emit finished(session);
+}
+
+void TxPipeline::resetSession()
+{
+    m_queue.clear();
+    m_tickTimer.stop();
+    m_fec.reset();
+    m_audioSeq = 0;
+    m_silentFrames = 0;
+    m_active = false;
+    m_finishing = false;
+    m_queueDelayEmaMs = 0.0;
+}
+
+void TxPipeline::sendCodecFrame(const QByteArray& codecFrame)
+{
+    if (m_packetBuilder.remaining() < kMaxPacketsPerFrame)
+        flushPackets();
+
+    const QSpan<const quint8> frame(reinterpret_cast<const quint8*>(codecFrame.constData()),
+                                    codecFrame.size());
+    m_packetBuilder.buildAudio(*m_packetizer, *m_cipher, m_audioSeq, frame);
+
+    // A silence marker carries no frame, so it neither takes a sequence
+    // number nor joins an FEC block.
+    if (codecFrame.isEmpty())
+        return;
+
+    if (m_fecEnabled && m_fec.addFrame(m_audioSeq, frame))
+    {
+        for (int i = 0; i < FecEncoder::kParityPackets; ++i)
+        {
+            m_packetBuilder.buildFec(*m_packetizer,
+                                     *m_cipher,
+                                     m_fec.completedBlockStart(),
+                                     static_cast<quint8>(m_fec.blockSize()),
+                                     static_cast<quint8>(i),
+                                     m_fec.parity(i));
+        }
+    }
+    m_audioSeq++;
+}
+
+void TxPipeline::flushPackets()
+{
+    const QSpan<const QByteArrayView> packets = m_packetBuilder.packets();
+    if (!packets.isEmpty() && m_transport && !m_targetAddress.isNull() && m_targetPort != 0)
+        m_transport->sendBatch(packets, m_targetAddress, m_targetPort);
+    m_packetBuilder.clear();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QQueue>
+#include <QTimer>
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+
+#include "net/Fec.h"
+#include "net/PacketBuilder.h"
+
+class AeadCipher;
+class Codec2Wrapper;
+class Packetizer;
+class UdpTransport;
+
+// TX data plane: encode -> FEC -> encrypt -> pack -> send, run on whatever
+// thread the pipeline is moved to. Captured frames arrive through a
+// single-producer ring filled by pushFrame(); the slots are control calls
+// and are invoked queued from PttController.
+class TxPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TxPipeline(QObject* parent = nullptr);
+
+    // Producer side, capture thread only. Copies the frame into a
+    // preallocated slot; returns false if the ring is full. Backlog frames
+    // (pre-roll) are always queued and paced out at the catch-up rate.
+    bool pushFrame(const QByteArray& pcmFrame, bool speech, bool backlog = false);
+
+public slots:
+    void setCodec(Codec2Wrapper* codec);
+    void setCipher(AeadCipher* cipher);
+    void setPacketizer(Packetizer* packetizer);
+    void setTransport(UdpTransport* transport);
+    void setTarget(const QHostAddress& address, quint16 port);
+    void setFecEnabled(bool enabled);
+
+    void start();
+    // Sends (flush) or drops what is still pending, then emits finished().
+    void finish(quint32 session, bool flush);
+    void abort();
+
+signals:
+    void finished(quint32 session);
+    void queueDelayChanged(int delayMs);
+    void framesDropped(int count);
+
+private slots:
+    void processInput();
+    void onTick();
+
+private:
+    struct InputSlot
+    {
+        QByteArray pcmFrame;
+        bool speech = true;
+        bool backlog = false;
+    };
+
+    struct TxFrame
+    {
+        QByteArray codecFrame;
+        qint64 enqueuedMs = 0;
+    };
+
+    static constexpr int kInputSlots = 32;
+
+    bool canSend() const;
+    void discardInput();
+    void encodeInput(const InputSlot& slot);
+    void enqueueFrame(const QByteArray& codecFrame, bool backlog);
+    void sendQueuedFrame();
+    void enforceLatencyBudget();
+    void recordQueueDelay(qint64 delayMs);
+    void sendCodecFrame(const QByteArray& codecFrame);
+    void flushPackets();
+    void completeFinish();
+    void resetSession();
+
+    std::array<InputSlot, kInputSlots> m_input;
+    std::atomic<int> m_inputHead{0};
+    std::atomic<int> m_inputTail{0};
+    std::atomic<bool> m_wakePending{false};
+
+    Codec2Wrapper* m_codec = nullptr;
+    AeadCipher* m_cipher = nullptr;
+    Packetizer* m_packetizer = nullptr;
+    UdpTransport* m_transport = nullptr;
+    QHostAddress m_targetAddress;
+    quint16 m_targetPort = 0;
+
+    bool m_active = false;
+    bool m_finishing = false;
+    quint32 m_finishSession = 0;
+    bool m_fecEnabled = false;
+    quint16 m_audioSeq = 0;
+    FecEncoder m_fec;
+    PacketBuilder m_packetBuilder;
+    int m_silentFrames = 0;
+
+    QTimer m_tickTimer;
+    QElapsedTimer m_clock;
+    QQueue<TxFrame> m_queue;
+    double m_queueDelayEmaMs = 0.0;
+    int m_queueDelayMs = 0;
+};
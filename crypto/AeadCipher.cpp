@@ -1,6 +1,7 @@
 #include "AeadCipher.h"
 
 #include <QCryptographicHash>
+#include <QMutexLocker>
 #include <cstring>
 
 #ifdef INCOMUDON_USE_OPENSSL
@@ -26,8 +27,16 @@ AeadCipher::AeadCipher(QObject* parent)
 {
 }
 
+AeadCipher::~AeadCipher()
+{
+#ifdef INCOMUDON_USE_OPENSSL
+    EVP_CIPHER_CTX_free(m_encryptCtx);
+#endif
+}
+
 void AeadCipher::setKey(const QByteArray& key, const QByteArray& nonceBase)
 {
+    QMutexLocker<QMutex> locker(&m_mutex);
     if (key.isEmpty())
     {
         if (m_key.isEmpty() && m_nonceBase == 0 && m_nonceCounter == 0)
@@ -35,6 +44,7 @@ void AeadCipher::setKey(const QByteArray& key, const QByteArray& nonceBase)
         m_key.clear();
         m_nonceBase = 0;
         m_nonceCounter = 0;
+        ++m_keyGeneration;
         return;
     }
 
@@ -51,15 +61,18 @@ void AeadCipher::setKey(const QByteArray& key, const QByteArray& nonceBase)
     m_key = normalizedKey;
     m_nonceBase = newNonceBase;
     m_nonceCounter = 0;
+    ++m_keyGeneration;
 }
 
 bool AeadCipher::isReady() const
 {
+    QMutexLocker<QMutex> locker(&m_mutex);
     return !m_key.isEmpty();
 }
 
 void AeadCipher::setMode(Mode mode)
 {
+    QMutexLocker<QMutex> locker(&m_mutex);
 #ifdef INCOMUDON_USE_OPENSSL
     m_mode = mode;
 #else
@@ -70,6 +83,7 @@ void AeadCipher::setMode(Mode mode)
 
 AeadCipher::Mode AeadCipher::mode() const
 {
+    QMutexLocker<QMutex> locker(&m_mutex);
     return m_mode;
 }
 
@@ -89,6 +103,7 @@ void AeadCipher::setKeyId(quint32 id)
 
 quint64 AeadCipher::nextNonce()
 {
+    QMutexLocker<QMutex> locker(&m_mutex);
     return m_nonceBase + (m_nonceCounter++);
 }
 
@@ -100,10 +115,14 @@ AeadResult AeadCipher::encrypt(const QByteArray& plaintext,
     result.ciphertext = plaintext;
     result.tag = QByteArray(kTagSize, 0);
 
+    QByteArray key;
+    Mode mode = Mode::AesGcm;
+    snapshot(&key, &mode, nullptr);
+
 #ifdef INCOMUDON_USE_OPENSSL
-    if (m_mode == Mode::AesGcm)
+    if (mode == Mode::AesGcm)
     {
-    if (m_key.isEmpty())
+    if (key.isEmpty())
         return result;
 
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
@@ -129,7 +148,7 @@ AeadResult AeadCipher::encrypt(const QByteArray& plaintext,
     }
 
     if (EVP_EncryptInit_ex(ctx, nullptr, nullptr,
-                           reinterpret_cast<const unsigned char*>(m_key.constData()),
+                           reinterpret_cast<const unsigned char*>(key.constData()),
                            iv) != 1)
     {
         EVP_CIPHER_CTX_free(ctx);
@@ -181,29 +200,93 @@ AeadResult AeadCipher::encrypt(const QByteArray& plaintext,
     return result;
     }
 #endif
-    if (!m_key.isEmpty())
+    if (!key.isEmpty())
     {
         for (int i = 0; i < result.ciphertext.size(); ++i)
         {
-            const char keyByte = m_key[i % m_key.size()];
+            const char keyByte = key[i % key.size()];
             result.ciphertext[i] = static_cast<char>(result.ciphertext[i] ^ keyByte);
         }
     }
 
-    result.tag = computeTag(result.ciphertext, nonce, aad);
+    result.tag = computeTag(key, result.ciphertext, nonce, aad);
     return result;
 }
 
+bool AeadCipher::encryptInPlace(QSpan<quint8> data, quint64 nonce, QSpan<quint8> tagOut)
+{
+    QByteArray key;
+    Mode mode = Mode::AesGcm;
+    quint32 generation = 0;
+    snapshot(&key, &mode, &generation);
+    if (key.isEmpty() || tagOut.size() < kTagSize)
+        return false;
+
+#ifdef INCOMUDON_USE_OPENSSL
+    if (mode == Mode::AesGcm)
+    {
+        // The key schedule is set up once per key; each packet only loads
+        // a new IV.
+        if (!m_encryptCtxKeyed || m_encryptCtxGeneration != generation)
+        {
+            m_encryptCtxKeyed = false;
+            if (!m_encryptCtx)
+                m_encryptCtx = EVP_CIPHER_CTX_new();
+            if (!m_encryptCtx ||
+                EVP_EncryptInit_ex(m_encryptCtx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1 ||
+                EVP_CIPHER_CTX_ctrl(m_encryptCtx, EVP_CTRL_GCM_SET_IVLEN, kIvSize, nullptr) != 1 ||
+                EVP_EncryptInit_ex(m_encryptCtx, nullptr, nullptr,
+                                   reinterpret_cast<const unsigned char*>(key.constData()),
+                                   nullptr) != 1)
+            {
+                return false;
+            }
+            m_encryptCtxKeyed = true;
+            m_encryptCtxGeneration = generation;
+        }
+
+        unsigned char iv[kIvSize];
+        nonceToIv(nonce, iv);
+        int len = 0;
+        if (EVP_EncryptInit_ex(m_encryptCtx, nullptr, nullptr, nullptr, iv) != 1 ||
+            EVP_EncryptUpdate(m_encryptCtx, data.data(), &len, data.data(), static_cast<int>(data.size())) != 1 ||
+            EVP_EncryptFinal_ex(m_encryptCtx, data.data() + len, &len) != 1 ||
+            EVP_CIPHER_CTX_ctrl(m_encryptCtx, EVP_CTRL_GCM_GET_TAG, kTagSize, tagOut.data()) != 1)
+        {
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    const int keySize = static_cast<int>(key.size());
+    for (qsizetype i = 0; i < data.size(); ++i)
+        data[i] ^= static_cast<quint8>(key.at(static_cast<int>(i % keySize)));
+
+    // Same construction as computeTag() with an empty AAD.
+    m_tagHash.reset();
+    m_tagHash.addData(key);
+    m_tagHash.addData(QByteArrayView(reinterpret_cast<const char*>(data.data()), data.size()));
+    m_tagHash.addData(QByteArrayView(reinterpret_cast<const char*>(&nonce), sizeof(nonce)));
+    const QByteArrayView digest = m_tagHash.resultView();
+    std::memcpy(tagOut.data(), digest.constData(), kTagSize);
+    return true;
+}
+
 bool AeadCipher::decrypt(const QByteArray& ciphertext,
                          const QByteArray& tag,
                          quint64 nonce,
                          const QByteArray& aad,
                          QByteArray& plaintextOut) const
 {
+    QByteArray key;
+    Mode mode = Mode::AesGcm;
+    snapshot(&key, &mode, nullptr);
+
 #ifdef INCOMUDON_USE_OPENSSL
-    if (m_mode == Mode::AesGcm)
+    if (mode == Mode::AesGcm)
     {
-    if (m_key.isEmpty() || tag.size() != kTagSize)
+    if (key.isEmpty() || tag.size() != kTagSize)
         return false;
 
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
@@ -229,7 +312,7 @@ bool AeadCipher::decrypt(const QByteArray& ciphertext,
     }
 
     if (EVP_DecryptInit_ex(ctx, nullptr, nullptr,
-                           reinterpret_cast<const unsigned char*>(m_key.constData()),
+                           reinterpret_cast<const unsigned char*>(key.constData()),
                            iv) != 1)
     {
         EVP_CIPHER_CTX_free(ctx);
@@ -278,16 +361,16 @@ bool AeadCipher::decrypt(const QByteArray& ciphertext,
     return true;
     }
 #endif
-    const QByteArray expected = computeTag(ciphertext, nonce, aad);
+    const QByteArray expected = computeTag(key, ciphertext, nonce, aad);
     if (expected != tag)
         return false;
 
     plaintextOut = ciphertext;
-    if (!m_key.isEmpty())
+    if (!key.isEmpty())
     {
         for (int i = 0; i < plaintextOut.size(); ++i)
         {
-            const char keyByte = m_key[i % m_key.size()];
+            const char keyByte = key[i % key.size()];
             plaintextOut[i] = static_cast<char>(plaintextOut[i] ^ keyByte);
         }
     }
@@ -295,6 +378,15 @@ bool AeadCipher::decrypt(const QByteArray& ciphertext,
     return true;
 }
 
+void AeadCipher::snapshot(QByteArray* key, Mode* mode, quint32* generation) const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    *key = m_key;
+    *mode = m_mode;
+    if (generation)
+        *generation = m_keyGeneration;
+}
+
 quint64 AeadCipher::bytesToU64(const QByteArray& bytes)
 {
     quint64 value = 0;
@@ -306,12 +398,13 @@ quint64 AeadCipher::bytesToU64(const QByteArray& bytes)
     return value;
 }
 
-QByteArray AeadCipher::computeTag(const QByteArray& ciphertext,
+QByteArray AeadCipher::computeTag(const QByteArray& key,
+                                  const QByteArray& ciphertext,
                                   quint64 nonce,
-                                  const QByteArray& aad) const
+                                  const QByteArray& aad)
 {
     QCryptographicHash hash(QCryptographicHash::Sha256);
-    hash.addData(m_key);
+    hash.addData(key);
     hash.addData(aad);
     hash.addData(ciphertext);
     hash.addData(reinterpret_cast<const char*>(&nonce), sizeof(nonce));
@@ -2,8 +2,13 @@
 
 #include <QObject>
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QMutex>
+#include <QSpan>
 #include <QtGlobal>
 
+struct evp_cipher_ctx_st;
+
 struct AeadResult
 {
     QByteArray ciphertext;
@@ -27,6 +32,7 @@ public:
     Q_ENUM(Mode)
 
     explicit AeadCipher(QObject* parent = nullptr);
+    ~AeadCipher() override;
 
     void setKey(const QByteArray& key, const QByteArray& nonceBase);
     bool isReady() const;
@@ -43,6 +49,12 @@ public:
                        quint64 nonce,
                        const QByteArray& aad = QByteArray()) const;
 
+    // Encrypts data in place and writes the 16-byte tag, without an AAD.
+    // Keeps a cipher context across calls, so it allocates nothing after
+    // the first packet; the context is not shared, so call it from one
+    // thread only. Key and mode changes from other threads are safe.
+    bool encryptInPlace(QSpan<quint8> data, quint64 nonce, QSpan<quint8> tagOut);
+
     bool decrypt(const QByteArray& ciphertext,
                  const QByteArray& tag,
                  quint64 nonce,
@@ -53,12 +65,23 @@ signals:
     void keyIdChanged();
 
 private:
+    // The key is implicitly shared, so a copy taken under the lock stays
+    // valid while the caller encrypts without holding it.
+    void snapshot(QByteArray* key, Mode* mode, quint32* generation) const;
     static quint64 bytesToU64(const QByteArray& bytes);
-    QByteArray computeTag(const QByteArray& ciphertext,
-                          quint64 nonce,
-                          const QByteArray& aad) const;
+    static QByteArray computeTag(const QByteArray& key,
+                                 const QByteArray& ciphertext,
+                                 quint64 nonce,
+                                 const QByteArray& aad);
 
+    // Keys are set on the UI thread while the TX thread encrypts.
+    mutable QMutex m_mutex;
     QByteArray m_key;
+    quint32 m_keyGeneration = 0;
+    evp_cipher_ctx_st* m_encryptCtx = nullptr;
+    quint32 m_encryptCtxGeneration = 0;
+    bool m_encryptCtxKeyed = false;
+    QCryptographicHash m_tagHash{QCryptographicHash::Sha256};
     quint64 m_nonceBase = 0;
     quint64 m_nonceCounter = 0;
     quint32 m_keyId = 1;
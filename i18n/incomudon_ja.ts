@@ -106,6 +106,10 @@
       <source>Encryption</source>
       <translation>暗号化</translation>
     </message>
+    <message>
+      <source>Every frame is sent while PTT is held.</source>
+      <translation>PTT 中はすべてのフレームを送信します。</translation>
+    </message>
     <message>
       <source>Higher values suppress ambient noise more strongly.</source>
       <translation>値を上げるほど環境ノイズを強く抑制します。</translation>
@@ -186,6 +190,10 @@
       <source>Opus unavailable: place and link libopus prebuilt library.</source>
       <translation>Opus は利用不可: libopus のプリビルドを配置してリンクしてください。</translation>
     </message>
+    <message>
+      <source>Pauses are not sent while PTT is held; listeners hear comfort noise instead.</source>
+      <translation>PTT 中の無音区間は送信せず、受信側ではコンフォートノイズを再生します。</translation>
+    </message>
     <message>
       <source>PCM</source>
       <translation>PCM</translation>
@@ -270,6 +278,10 @@
       <source>Using linked Opus library.</source>
       <translation>リンク済み Opus ライブラリを使用中。</translation>
     </message>
+    <message>
+      <source>Voice Activity Detection</source>
+      <translation>音声区間検出</translation>
+    </message>
     <message>
       <source>Voice packets request priority with DSCP EF (network may ignore it).</source>
       <translation>音声パケットに DSCP EF を設定します（ネットワーク側で無視される場合があります）。</translation>
@@ -14,7 +14,9 @@
 #include <QtEndian>
 #include <QDebug>
 #include <QStringList>
+#include <QThread>
 #include <functional>
+#include <memory>
 #ifdef Q_OS_ANDROID
 #include <android/log.h>
 #include <QJniObject>
@@ -98,10 +100,11 @@ int main(int argc, char *argv[])
     LicenseProvider licenseProvider;
     AudioInput audioInput;
     AudioOutput audioOutput;
-    Codec2Wrapper codecTx;
+    // Libraries are attached once the startup preload below finishes.
+    Codec2Wrapper codecTx(nullptr, Codec2Wrapper::LibraryLoad::Deferred);
     // TX/RX must use independent codec instances.
     // Sharing one CODEC2 state between encode/decode can corrupt stream state.
-    Codec2Wrapper codecRx;
+    Codec2Wrapper codecRx(nullptr, Codec2Wrapper::LibraryLoad::Deferred);
     KeyExchange keyExchange;
     AeadCipher cipher;
     Packetizer packetizer;
@@ -573,6 +576,10 @@ int main(int argc, char *argv[])
                      &appState, [&audioInput, &appState]() {
         audioInput.setNoiseSuppressionEnabled(appState.noiseSuppressionEnabled());
     });
+    QObject::connect(&appState, &AppState::voiceActivityDetectionEnabledChanged,
+                     &appState, [&audioInput, &appState]() {
+        audioInput.setVoiceActivityDetectionEnabled(appState.voiceActivityDetectionEnabled());
+    });
     QObject::connect(&appState, &AppState::noiseSuppressionLevelChanged,
                      &appState, [&audioInput, &appState]() {
         audioInput.setNoiseSuppressionLevel(appState.noiseSuppressionLevel());
@@ -936,11 +943,7 @@ int main(int argc, char *argv[])
 
     applyCodecSelection();
     applyCodecBitrate();
-    codecTx.setCodec2LibraryPath(appState.codec2LibraryPath());
-    codecRx.setCodec2LibraryPath(appState.codec2LibraryPath());
     syncCodec2LibraryState();
-    codecTx.setOpusLibraryPath(appState.opusLibraryPath());
-    codecRx.setOpusLibraryPath(appState.opusLibraryPath());
     syncOpusLibraryState();
     codecTx.setForcePcm(appState.forcePcm());
     if (appState.codecSelection() == AppState::CodecOpus)
@@ -953,19 +956,57 @@ int main(int argc, char *argv[])
     audioInput.setInputGainPercent(appState.micVolumePercent());
     audioInput.setNoiseSuppressionEnabled(appState.noiseSuppressionEnabled());
     audioInput.setNoiseSuppressionLevel(appState.noiseSuppressionLevel());
+    audioInput.setVoiceActivityDetectionEnabled(appState.voiceActivityDetectionEnabled());
     audioOutput.setOutputGainPercent(appState.speakerVolumePercent());
-    logCodecStatus(QStringLiteral("Initial TX codec mode=%1 type=%2 forcePcm=%3 codec2Active=%4 opusActive=%5")
-                       .arg(codecTx.mode())
-                       .arg(codecTx.codecType())
-                       .arg(codecTx.forcePcm() ? 1 : 0)
-                       .arg(codecTx.codec2Active() ? 1 : 0)
-                       .arg(codecTx.opusActive() ? 1 : 0));
-    logCodecStatus(QStringLiteral("Initial RX codec mode=%1 type=%2 forcePcm=%3 codec2Active=%4 opusActive=%5")
-                       .arg(codecRx.mode())
-                       .arg(codecRx.codecType())
-                       .arg(codecRx.forcePcm() ? 1 : 0)
-                       .arg(codecRx.codec2Active() ? 1 : 0)
-                       .arg(codecRx.opusActive() ? 1 : 0));
+
+    // Loading and probing the codec runtimes can take seconds on Android, so
+    // it runs off the GUI thread while QML loads. The wrappers attach to the
+    // warmed libraries once it finishes and publish the loaded state then.
+    auto codecPreload = std::make_shared<std::shared_ptr<Codec2Wrapper::PreloadedLibraries>>();
+    QThread* codecLoaderThread = QThread::create(
+        [codecPreload,
+         codec2Path = appState.codec2LibraryPath(),
+         opusPath = appState.opusLibraryPath(),
+         codecType = codecTx.codecType(),
+         mode = codecTx.mode()]() {
+            *codecPreload = Codec2Wrapper::preloadLibraries(codec2Path, opusPath, codecType, mode);
+        });
+    QObject::connect(codecLoaderThread, &QThread::finished,
+                     &appState, [&appState, &codecTx, &codecRx, &syncCodec2LibraryState,
+                                 &syncOpusLibraryState, codecPreload]() {
+        if (*codecPreload)
+        {
+            codecTx.attachPreloadedLibraries(**codecPreload);
+            codecRx.attachPreloadedLibraries(**codecPreload);
+        }
+        // Paths changed in the meantime win over the preloaded ones.
+        codecTx.setCodec2LibraryPath(appState.codec2LibraryPath());
+        codecRx.setCodec2LibraryPath(appState.codec2LibraryPath());
+        syncCodec2LibraryState();
+        codecTx.setOpusLibraryPath(appState.opusLibraryPath());
+        codecRx.setOpusLibraryPath(appState.opusLibraryPath());
+        syncOpusLibraryState();
+        codecPreload->reset();
+        logCodecStatus(QStringLiteral("Initial TX codec mode=%1 type=%2 forcePcm=%3 codec2Active=%4 opusActive=%5")
+                           .arg(codecTx.mode())
+                           .arg(codecTx.codecType())
+                           .arg(codecTx.forcePcm() ? 1 : 0)
+                           .arg(codecTx.codec2Active() ? 1 : 0)
+                           .arg(codecTx.opusActive() ? 1 : 0));
+        logCodecStatus(QStringLiteral("Initial RX codec mode=%1 type=%2 forcePcm=%3 codec2Active=%4 opusActive=%5")
+                           .arg(codecRx.mode())
+                           .arg(codecRx.codecType())
+                           .arg(codecRx.forcePcm() ? 1 : 0)
+                           .arg(codecRx.codec2Active() ? 1 : 0)
+                           .arg(codecRx.opusActive() ? 1 : 0));
+    });
+    QObject::connect(codecLoaderThread, &QThread::finished,
+                     codecLoaderThread, &QObject::deleteLater);
+    QObject::connect(&app, &QCoreApplication::aboutToQuit,
+                     codecLoaderThread, [codecLoaderThread]() {
+        codecLoaderThread->wait();
+    });
+    codecLoaderThread->start();
 
     engine.rootContext()->setContextProperty("appState", &appState);
     engine.rootContext()->setContextProperty("cryptoUtils", &cryptoUtils);
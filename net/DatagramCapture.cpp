@@ -0,0 +1,97 @@
+#include "DatagramCapture.h"
+
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+constexpr char kMagic[] = "IUDCAP01";
+constexpr int kMagicBytes = 8;
+constexpr int kRecordHeaderBytes = 8 + 16 + 2 + 2;
+// Bounds what a crash can lose without a write per datagram.
+constexpr qint64 kFlushIntervalUs = 1000000;
+
+static bool fail(QString* error, const QString& message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+}
+
+bool DatagramCaptureWriter::open(const QString& path, QString* error)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return fail(error, QStringLiteral("cannot write %1").arg(path));
+    m_file.write(kMagic, kMagicBytes);
+    m_lastFlushUs = 0;
+    return true;
+}
+
+bool DatagramCaptureWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void DatagramCaptureWriter::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+void DatagramCaptureWriter::write(qint64 timeUs,
+                                  const QHostAddress& sender,
+                                  quint16 senderPort,
+                                  const QByteArray& datagram)
+{
+    if (!m_file.isOpen() || datagram.size() > 0xFFFF)
+        return;
+
+    uchar header[kRecordHeaderBytes];
+    qToLittleEndian<quint64>(static_cast<quint64>(timeUs), header);
+    const Q_IPV6ADDR address = sender.toIPv6Address();
+    std::memcpy(header + 8, address.c, 16);
+    qToLittleEndian<quint16>(senderPort, header + 24);
+    qToLittleEndian<quint16>(static_cast<quint16>(datagram.size()), header + 26);
+    m_file.write(reinterpret_cast<const char*>(header), kRecordHeaderBytes);
+    m_file.write(datagram);
+
+    if (timeUs - m_lastFlushUs >= kFlushIntervalUs)
+    {
+        m_file.flush();
+        m_lastFlushUs = timeUs;
+    }
+}
+
+bool DatagramCaptureReader::open(const QString& path, QString* error)
+{
+    m_file.close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return fail(error, QStringLiteral("cannot open %1").arg(path));
+    if (m_file.read(kMagicBytes) != QByteArray(kMagic, kMagicBytes))
+        return fail(error, QStringLiteral("%1 is not an IncomUdon capture").arg(path));
+    return true;
+}
+
+bool DatagramCaptureReader::next(CapturedDatagram* out)
+{
+    uchar header[kRecordHeaderBytes];
+    if (m_file.read(reinterpret_cast<char*>(header), kRecordHeaderBytes) != kRecordHeaderBytes)
+        return false;
+
+    out->timeUs = static_cast<qint64>(qFromLittleEndian<quint64>(header));
+    Q_IPV6ADDR address;
+    std::memcpy(address.c, header + 8, 16);
+    out->sender.setAddress(address);
+    bool isIpv4 = false;
+    const quint32 ipv4 = out->sender.toIPv4Address(&isIpv4);
+    if (isIpv4)
+        out->sender.setAddress(ipv4);
+    out->senderPort = qFromLittleEndian<quint16>(header + 24);
+
+    const int size = qFromLittleEndian<quint16>(header + 26);
+    out->data = m_file.read(size);
+    return out->data.size() == size;
+}
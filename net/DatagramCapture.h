@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHostAddress>
+#include <QString>
+#include <QtGlobal>
+
+// Compact capture of received datagrams for offline replay. The file starts
+// with the 8-byte magic "IUDCAP01"; each record is a little-endian header
+// (receive time in microseconds since the capture began, u64; sender
+// address as IPv6 or IPv4-mapped, 16 bytes; sender port, u16; datagram
+// length, u16) followed by the datagram bytes.
+struct CapturedDatagram
+{
+    qint64 timeUs = 0;
+    QHostAddress sender;
+    quint16 senderPort = 0;
+    QByteArray data;
+};
+
+class DatagramCaptureWriter
+{
+public:
+    bool open(const QString& path, QString* error);
+    bool isOpen() const;
+    void close();
+
+    void write(qint64 timeUs,
+               const QHostAddress& sender,
+               quint16 senderPort,
+               const QByteArray& datagram);
+
+private:
+    QFile m_file;
+    qint64 m_lastFlushUs = 0;
+};
+
+class DatagramCaptureReader
+{
+public:
+    bool open(const QString& path, QString* error);
+    // False at the end of the file or on a truncated record.
+    bool next(CapturedDatagram* out);
+
+private:
+    QFile m_file;
+};
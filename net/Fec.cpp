@@ -3,29 +3,29 @@
 #include <QtEndian>
 
 namespace {
-static bool gf_ready = false;
 static quint8 gf_exp[512];
 static quint8 gf_log[256];
 
 static void gf_init()
 {
-    if (gf_ready)
-        return;
-
-    int x = 1;
-    for (int i = 0; i < 255; ++i)
-    {
-        gf_exp[i] = static_cast<quint8>(x);
-        gf_log[static_cast<quint8>(x)] = static_cast<quint8>(i);
-        x <<= 1;
-        if (x & 0x100)
-            x ^= 0x11d;
-    }
-    for (int i = 255; i < 512; ++i)
-        gf_exp[i] = gf_exp[i - 255];
+    // Encoder and decoder run on different threads; build the tables once.
+    static const bool ready = [] {
+        int x = 1;
+        for (int i = 0; i < 255; ++i)
+        {
+            gf_exp[i] = static_cast<quint8>(x);
+            gf_log[static_cast<quint8>(x)] = static_cast<quint8>(i);
+            x <<= 1;
+            if (x & 0x100)
+                x ^= 0x11d;
+        }
+        for (int i = 255; i < 512; ++i)
+            gf_exp[i] = gf_exp[i - 255];
 
-    gf_log[0] = 0;
-    gf_ready = true;
+        gf_log[0] = 0;
+        return true;
+    }();
+    Q_UNUSED(ready)
 }
 
 static inline quint8 gf_mul(quint8 a, quint8 b)
@@ -76,6 +76,22 @@ static void xorMulBytes(QByteArray& dst, const QByteArray& src, quint8 factor)
         d[i] = static_cast<char>(static_cast<quint8>(d[i]) ^ v);
     }
 }
+
+static void xorSpan(QByteArray& dst, QSpan<const quint8> src)
+{
+    const int len = qMin(static_cast<int>(dst.size()), static_cast<int>(src.size()));
+    quint8* d = reinterpret_cast<quint8*>(dst.data());
+    for (int i = 0; i < len; ++i)
+        d[i] ^= src[i];
+}
+
+static void xorMulSpan(QByteArray& dst, QSpan<const quint8> src, quint8 factor)
+{
+    const int len = qMin(static_cast<int>(dst.size()), static_cast<int>(src.size()));
+    quint8* d = reinterpret_cast<quint8*>(dst.data());
+    for (int i = 0; i < len; ++i)
+        d[i] ^= gf_mul(src[i], factor);
+}
 } // namespace
 
 void FecEncoder::setEnabled(bool enabled)
@@ -118,51 +134,68 @@ void FecEncoder::beginBlock(quint16 blockStart, int frameSize)
     m_blockStart = blockStart;
     m_inBlock = 0;
     m_frameSize = frameSize;
-    m_parityP = QByteArray(m_frameSize, 0);
-    m_parityQ = QByteArray(m_frameSize, 0);
+    // resize() keeps the capacity, so same-sized blocks reuse the buffers.
+    m_parityP.resize(m_frameSize);
+    m_parityP.fill(0);
+    m_parityQ.resize(m_frameSize);
+    m_parityQ.fill(0);
 }
 
-QVector<FecParityPacket> FecEncoder::addFrame(quint16 audioSeq,
-                                             const QByteArray& frame)
+bool FecEncoder::addFrame(quint16 audioSeq, QSpan<const quint8> frame)
 {
-    QVector<FecParityPacket> out;
     if (!m_enabled || frame.isEmpty() || m_blockSize <= 0)
-        return out;
+        return false;
 
     gf_init();
 
-    const int frameSize = frame.size();
-    const int index = m_blockSize > 0 ? (audioSeq % m_blockSize) : 0;
+    const int frameSize = static_cast<int>(frame.size());
+    const int index = audioSeq % m_blockSize;
     const quint16 blockStart = static_cast<quint16>(audioSeq - index);
 
     if (m_inBlock == 0 || frameSize != m_frameSize || blockStart != m_blockStart)
         beginBlock(blockStart, frameSize);
 
-    xorBytes(m_parityP, frame);
-    xorMulBytes(m_parityQ, frame, gf_pow2(index));
+    xorSpan(m_parityP, frame);
+    xorMulSpan(m_parityQ, frame, gf_pow2(index));
 
     m_inBlock++;
-    if (m_inBlock >= m_blockSize)
+    if (m_inBlock < m_blockSize)
+        return false;
+
+    // The parity rows stay readable until the next frame starts a block.
+    m_inBlock = 0;
+    return true;
+}
+
+quint16 FecEncoder::completedBlockStart() const
+{
+    return m_blockStart;
+}
+
+QSpan<const quint8> FecEncoder::parity(int index) const
+{
+    const QByteArray& row = index == 0 ? m_parityP : m_parityQ;
+    return QSpan<const quint8>(reinterpret_cast<const quint8*>(row.constData()), row.size());
+}
+
+QVector<FecParityPacket> FecEncoder::addFrame(quint16 audioSeq,
+                                             const QByteArray& frame)
+{
+    QVector<FecParityPacket> out;
+    if (!addFrame(audioSeq, QSpan<const quint8>(reinterpret_cast<const quint8*>(frame.constData()),
+                                                frame.size())))
+        return out;
+
+    for (int i = 0; i < kParityPackets; ++i)
     {
-        FecParityPacket p;
-        p.blockStart = m_blockStart;
-        p.blockSize = static_cast<quint8>(m_blockSize);
-        p.parityIndex = 0;
-        p.data = m_parityP;
-        out.append(p);
-
-        FecParityPacket q;
-        q.blockStart = m_blockStart;
-        q.blockSize = static_cast<quint8>(m_blockSize);
-        q.parityIndex = 1;
-        q.data = m_parityQ;
-        out.append(q);
-
-        m_inBlock = 0;
-        m_parityP.clear();
-        m_parityQ.clear();
+        FecParityPacket packet;
+        packet.blockStart = m_blockStart;
+        packet.blockSize = static_cast<quint8>(m_blockSize);
+        packet.parityIndex = static_cast<quint8>(i);
+        const QSpan<const quint8> row = parity(i);
+        packet.data = QByteArray(reinterpret_cast<const char*>(row.data()), row.size());
+        out.append(packet);
     }
-
     return out;
 }
 
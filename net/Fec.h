@@ -3,6 +3,7 @@
 #include <QByteArray>
 #include <QVector>
 #include <QMap>
+#include <QSpan>
 #include <QtGlobal>
 
 struct FecParityPacket
@@ -22,6 +23,8 @@ struct FecDecodedFrame
 class FecEncoder
 {
 public:
+    static constexpr int kParityPackets = 2;
+
     void setEnabled(bool enabled);
     bool enabled() const;
 
@@ -31,6 +34,12 @@ public:
 
     QVector<FecParityPacket> addFrame(quint16 audioSeq,
                                       const QByteArray& frame);
+    // Allocation-free variant: returns true when the frame completes a
+    // block; completedBlockStart() and parity(0..1) then describe it until
+    // the next call.
+    bool addFrame(quint16 audioSeq, QSpan<const quint8> frame);
+    quint16 completedBlockStart() const;
+    QSpan<const quint8> parity(int index) const;
 
 private:
     void beginBlock(quint16 blockStart, int frameSize);
@@ -0,0 +1,270 @@
+#include "NetworkImpairment.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <QtMath>
+
+namespace {
+constexpr double kParetoShape = 3.0;
+constexpr int kMaxJitterFactor = 20;
+
+static bool parseProbability(const QString& text, double* out)
+{
+    bool ok = false;
+    double value = 0.0;
+    if (text.endsWith(QLatin1Char('%')))
+        value = text.chopped(1).toDouble(&ok) / 100.0;
+    else
+        value = text.toDouble(&ok);
+    if (!ok || value < 0.0 || value > 1.0)
+        return false;
+    *out = value;
+    return true;
+}
+
+static bool parseMs(const QString& text, int* out)
+{
+    QString number = text;
+    if (number.endsWith(QStringLiteral("ms")))
+        number.chop(2);
+    bool ok = false;
+    const int value = number.toInt(&ok);
+    if (!ok || value < 0)
+        return false;
+    *out = value;
+    return true;
+}
+
+static bool applyKey(NetworkImpairmentConfig& config, const QString& key, const QString& value)
+{
+    if (key == QStringLiteral("seed"))
+    {
+        bool ok = false;
+        config.seed = value.toUInt(&ok);
+        return ok;
+    }
+    if (key == QStringLiteral("loss"))
+        return parseProbability(value, &config.lossRate);
+    if (key == QStringLiteral("burst"))
+    {
+        const QStringList parts = value.split(QLatin1Char('/'));
+        if (parts.size() < 2 || parts.size() > 3)
+            return false;
+        if (!parseProbability(parts.at(0), &config.burstEnterRate) ||
+            !parseProbability(parts.at(1), &config.burstExitRate))
+        {
+            return false;
+        }
+        config.burstLossRate = 1.0;
+        return parts.size() == 2 || parseProbability(parts.at(2), &config.burstLossRate);
+    }
+    if (key == QStringLiteral("delay"))
+        return parseMs(value, &config.delayMs);
+    if (key == QStringLiteral("jitter"))
+        return parseMs(value, &config.jitterMs);
+    if (key == QStringLiteral("dist"))
+    {
+        if (value == QStringLiteral("uniform"))
+            config.jitterDistribution = NetworkImpairmentConfig::Uniform;
+        else if (value == QStringLiteral("normal"))
+            config.jitterDistribution = NetworkImpairmentConfig::Normal;
+        else if (value == QStringLiteral("pareto"))
+            config.jitterDistribution = NetworkImpairmentConfig::Pareto;
+        else
+            return false;
+        return true;
+    }
+    if (key == QStringLiteral("reorder"))
+        return parseProbability(value, &config.reorderRate);
+    if (key == QStringLiteral("reorder-gap"))
+        return parseMs(value, &config.reorderGapMs);
+    if (key == QStringLiteral("dup"))
+        return parseProbability(value, &config.duplicateRate);
+    if (key == QStringLiteral("rate"))
+    {
+        bool ok = false;
+        config.rateKbps = value.toInt(&ok);
+        return ok && config.rateKbps >= 0;
+    }
+    if (key == QStringLiteral("queue"))
+        return parseMs(value, &config.queueLimitMs);
+    return false;
+}
+}
+
+bool NetworkImpairmentConfig::isActive() const
+{
+    return lossRate > 0.0 || burstEnterRate > 0.0 || delayMs > 0 || jitterMs > 0 ||
+           reorderRate > 0.0 || duplicateRate > 0.0 || rateKbps > 0;
+}
+
+bool NetworkImpairmentConfig::parse(const QString& spec,
+                                    NetworkImpairmentConfig* tx,
+                                    NetworkImpairmentConfig* rx,
+                                    QString* error)
+{
+    NetworkImpairmentConfig txConfig;
+    NetworkImpairmentConfig rxConfig;
+    bool rxSeedSet = false;
+
+    static const QRegularExpression separators(QStringLiteral("[,;\\s]+"));
+    const QStringList items = spec.split(separators, Qt::SkipEmptyParts);
+    for (const QString& item : items)
+    {
+        const qsizetype eq = item.indexOf(QLatin1Char('='));
+        QString key = eq > 0 ? item.left(eq).trimmed().toLower() : QString();
+        const QString value = eq > 0 ? item.mid(eq + 1).trimmed().toLower() : QString();
+
+        bool toTx = true;
+        bool toRx = true;
+        if (key.startsWith(QStringLiteral("tx.")))
+        {
+            toRx = false;
+            key.remove(0, 3);
+        }
+        else if (key.startsWith(QStringLiteral("rx.")))
+        {
+            toTx = false;
+            key.remove(0, 3);
+        }
+
+        bool ok = !key.isEmpty() && !value.isEmpty();
+        if (ok && toTx)
+            ok = applyKey(txConfig, key, value);
+        if (ok && toRx)
+            ok = applyKey(rxConfig, key, value);
+        if (!ok)
+        {
+            if (error)
+                *error = QStringLiteral("Invalid impairment setting: %1").arg(item);
+            return false;
+        }
+        if (key == QStringLiteral("seed") && !toTx)
+            rxSeedSet = true;
+    }
+
+    // Decorrelate the two directions so a symmetric spec does not drop
+    // the same positions both ways.
+    if (!rxSeedSet)
+        rxConfig.seed = txConfig.seed + 1;
+    if (tx)
+        *tx = txConfig;
+    if (rx)
+        *rx = rxConfig;
+    return true;
+}
+
+NetworkImpairment::NetworkImpairment(const NetworkImpairmentConfig& config)
+    : m_config(config),
+      m_random(config.seed)
+{
+}
+
+const NetworkImpairmentConfig& NetworkImpairment::config() const
+{
+    return m_config;
+}
+
+NetworkImpairmentStats NetworkImpairment::stats() const
+{
+    return m_stats;
+}
+
+int NetworkImpairment::offer(qint64 nowUs, int bytes, qint64 releaseUs[kMaxCopies])
+{
+    ++m_stats.offered;
+    if (drawLoss())
+    {
+        ++m_stats.lost;
+        return 0;
+    }
+
+    qint64 departUs = nowUs;
+    if (m_config.rateKbps > 0)
+    {
+        const qint64 startUs = qMax(nowUs, m_linkFreeUs);
+        if (startUs - nowUs > static_cast<qint64>(m_config.queueLimitMs) * 1000)
+        {
+            ++m_stats.queueDrops;
+            return 0;
+        }
+        m_linkFreeUs = startUs + static_cast<qint64>(bytes) * 8 * 1000 / m_config.rateKbps;
+        departUs = m_linkFreeUs;
+    }
+
+    const int copies = chance(m_config.duplicateRate) ? 2 : 1;
+    if (copies > 1)
+        ++m_stats.duplicated;
+    for (int i = 0; i < copies; ++i)
+    {
+        qint64 release = departUs + drawDelayUs();
+        if (i == 0 && chance(m_config.reorderRate))
+        {
+            // Not recorded in m_lastReleaseUs, so later datagrams pass it.
+            release += static_cast<qint64>(m_config.reorderGapMs) * 1000;
+            ++m_stats.reordered;
+        }
+        else
+        {
+            release = qMax(release, m_lastReleaseUs);
+            m_lastReleaseUs = release;
+        }
+        releaseUs[i] = release;
+    }
+    return copies;
+}
+
+bool NetworkImpairment::drawLoss()
+{
+    if (m_config.burstEnterRate <= 0.0)
+        return chance(m_config.lossRate);
+
+    if (m_burst)
+        m_burst = !chance(m_config.burstExitRate);
+    else
+        m_burst = chance(m_config.burstEnterRate);
+    return chance(m_burst ? m_config.burstLossRate : m_config.lossRate);
+}
+
+qint64 NetworkImpairment::drawDelayUs()
+{
+    const double baseUs = m_config.delayMs * 1000.0;
+    const double jitterUs = m_config.jitterMs * 1000.0;
+    if (jitterUs <= 0.0)
+        return static_cast<qint64>(baseUs);
+
+    double offsetUs = 0.0;
+    switch (m_config.jitterDistribution)
+    {
+    case NetworkImpairmentConfig::Uniform:
+        offsetUs = (m_random.generateDouble() * 2.0 - 1.0) * jitterUs;
+        break;
+    case NetworkImpairmentConfig::Normal:
+    {
+        // Box-Muller; jitter is the standard deviation.
+        const double u1 = 1.0 - m_random.generateDouble();
+        const double u2 = m_random.generateDouble();
+        offsetUs = qSqrt(-2.0 * qLn(u1)) * qCos(2.0 * M_PI * u2) * jitterUs;
+        break;
+    }
+    case NetworkImpairmentConfig::Pareto:
+    {
+        // Lomax tail with jitter as its mean: only ever adds delay, with
+        // the occasional late spike a congested hop produces.
+        const double u = 1.0 - m_random.generateDouble();
+        offsetUs = (kParetoShape - 1.0) * jitterUs * (qPow(u, -1.0 / kParetoShape) - 1.0);
+        offsetUs = qMin(offsetUs, kMaxJitterFactor * jitterUs);
+        break;
+    }
+    }
+    return qMax<qint64>(0, static_cast<qint64>(baseUs + offsetUs));
+}
+
+bool NetworkImpairment::chance(double probability)
+{
+    if (probability <= 0.0)
+        return false;
+    if (probability >= 1.0)
+        return true;
+    return m_random.generateDouble() < probability;
+}
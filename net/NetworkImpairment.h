@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QRandomGenerator>
+#include <QString>
+#include <QtGlobal>
+
+struct NetworkImpairmentConfig
+{
+    enum JitterDistribution {
+        Uniform = 0,
+        Normal = 1,
+        Pareto = 2
+    };
+
+    quint32 seed = 1;
+    // Independent loss, and the loss while in the Gilbert-Elliott good
+    // state when bursts are configured.
+    double lossRate = 0.0;
+    // Gilbert-Elliott: probability per datagram of entering and of leaving
+    // the bad state, and the loss rate inside it.
+    double burstEnterRate = 0.0;
+    double burstExitRate = 1.0;
+    double burstLossRate = 1.0;
+    int delayMs = 0;
+    int jitterMs = 0;
+    JitterDistribution jitterDistribution = Uniform;
+    // Reordered datagrams are held back by reorderGapMs so later ones
+    // overtake them; everything else keeps its order despite jitter.
+    double reorderRate = 0.0;
+    int reorderGapMs = 40;
+    double duplicateRate = 0.0;
+    // Bottleneck rate in kbit/s (0 = unlimited) and the queueing delay
+    // beyond which it tail-drops.
+    int rateKbps = 0;
+    int queueLimitMs = 200;
+
+    bool isActive() const;
+
+    // Parses a spec such as "loss=2%,burst=0.05/0.5,delay=60,jitter=20,
+    // dist=normal,reorder=1%,dup=0.5%,rate=32,seed=7". A "tx." or "rx."
+    // prefix limits a key to one direction. The receive side draws from
+    // seed + 1 unless rx.seed is given.
+    static bool parse(const QString& spec,
+                      NetworkImpairmentConfig* tx,
+                      NetworkImpairmentConfig* rx,
+                      QString* error);
+};
+
+struct NetworkImpairmentStats
+{
+    quint64 offered = 0;
+    quint64 lost = 0;
+    quint64 queueDrops = 0;
+    quint64 duplicated = 0;
+    quint64 reordered = 0;
+};
+
+// Decides the fate of each datagram on an emulated link: whether it is
+// lost, how many copies arrive and after how long. Holds no payloads, so
+// callers keep their own release queue. Every decision comes from one
+// seeded generator; the same config and offer sequence replays exactly.
+class NetworkImpairment
+{
+public:
+    static constexpr int kMaxCopies = 2;
+
+    explicit NetworkImpairment(const NetworkImpairmentConfig& config);
+
+    const NetworkImpairmentConfig& config() const;
+    NetworkImpairmentStats stats() const;
+
+    // Fills releaseUs with the absolute release times of the copies to
+    // deliver, in microseconds on the caller's clock, and returns their
+    // count (0 when the datagram is lost).
+    int offer(qint64 nowUs, int bytes, qint64 releaseUs[kMaxCopies]);
+
+private:
+    bool drawLoss();
+    qint64 drawDelayUs();
+    bool chance(double probability);
+
+    NetworkImpairmentConfig m_config;
+    QRandomGenerator m_random;
+    NetworkImpairmentStats m_stats;
+    bool m_burst = false;
+    qint64 m_linkFreeUs = 0;
+    qint64 m_lastReleaseUs = 0;
+};
@@ -0,0 +1,102 @@
+#include "PacketBuilder.h"
+
+#include "Packetizer.h"
+#include "crypto/AeadCipher.h"
+
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+constexpr int kAudioSeqBytes = 2;
+constexpr int kFecHeaderBytes = 4;
+}
+
+PacketBuilder::PacketBuilder()
+{
+    for (QByteArray& buffer : m_buffers)
+        buffer = QByteArray(kMaxDatagramBytes, Qt::Uninitialized);
+}
+
+QSpan<const QByteArrayView> PacketBuilder::packets() const
+{
+    return QSpan<const QByteArrayView>(m_packets.data(), m_count);
+}
+
+int PacketBuilder::remaining() const
+{
+    return kMaxBatchPackets - m_count;
+}
+
+void PacketBuilder::clear()
+{
+    m_count = 0;
+}
+
+uchar* PacketBuilder::payloadArea(const Packetizer& packetizer, int payloadBytes)
+{
+    const int headerBytes = packetizer.dataHeaderSize();
+    if (m_count >= kMaxBatchPackets ||
+        headerBytes + payloadBytes + Proto::AUTH_TAG_SIZE > kMaxDatagramBytes)
+        return nullptr;
+    m_headerBytes = headerBytes;
+    return reinterpret_cast<uchar*>(m_buffers[m_count].data()) + headerBytes;
+}
+
+QByteArrayView PacketBuilder::buildAudio(Packetizer& packetizer,
+                                         AeadCipher& cipher,
+                                         quint16 audioSeq,
+                                         QSpan<const quint8> codecFrame)
+{
+    const int payloadBytes = kAudioSeqBytes + static_cast<int>(codecFrame.size());
+    uchar* payload = payloadArea(packetizer, payloadBytes);
+    if (!payload)
+        return {};
+
+    qToBigEndian<quint16>(audioSeq, payload);
+    if (!codecFrame.isEmpty())
+        std::memcpy(payload + kAudioSeqBytes, codecFrame.data(), codecFrame.size());
+    return seal(packetizer, cipher, Proto::PKT_AUDIO, payloadBytes);
+}
+
+QByteArrayView PacketBuilder::buildFec(Packetizer& packetizer,
+                                       AeadCipher& cipher,
+                                       quint16 blockStart,
+                                       quint8 blockSize,
+                                       quint8 parityIndex,
+                                       QSpan<const quint8> parity)
+{
+    const int payloadBytes = kFecHeaderBytes + static_cast<int>(parity.size());
+    uchar* payload = payloadArea(packetizer, payloadBytes);
+    if (!payload)
+        return {};
+
+    qToBigEndian<quint16>(blockStart, payload);
+    payload[2] = blockSize;
+    payload[3] = parityIndex;
+    if (!parity.isEmpty())
+        std::memcpy(payload + kFecHeaderBytes, parity.data(), parity.size());
+    return seal(packetizer, cipher, Proto::PKT_FEC, payloadBytes);
+}
+
+QByteArrayView PacketBuilder::seal(Packetizer& packetizer,
+                                   AeadCipher& cipher,
+                                   Proto::PacketType type,
+                                   int payloadBytes)
+{
+    QByteArray& buffer = m_buffers[m_count];
+    uchar* base = reinterpret_cast<uchar*>(buffer.data());
+    const quint64 nonce = cipher.nextNonce();
+    const int headerBytes = packetizer.writeDataHeader(type, nonce, base);
+    // The header layout switched (legacy server detected) on another
+    // thread after the payload was placed; drop this one packet.
+    if (headerBytes != m_headerBytes)
+        return {};
+    uchar* payload = base + headerBytes;
+    if (!cipher.encryptInPlace(QSpan<quint8>(payload, payloadBytes),
+                               nonce,
+                               QSpan<quint8>(payload + payloadBytes, Proto::AUTH_TAG_SIZE)))
+        return {};
+    const QByteArrayView packet(buffer.constData(), headerBytes + payloadBytes + Proto::AUTH_TAG_SIZE);
+    m_packets[m_count++] = packet;
+    return packet;
+}
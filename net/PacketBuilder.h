@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QSpan>
+#include <QtGlobal>
+#include <array>
+
+#include "packet.h"
+
+class AeadCipher;
+class Packetizer;
+
+// Builds encrypted AUDIO and FEC packets into a small set of reusable
+// MTU-sized buffers: the header is stored at fixed offsets, the payload is
+// written behind it and encrypted in place, and the tag lands at the end.
+// Built packets accumulate until clear(), so a burst can be sent at once.
+class PacketBuilder
+{
+public:
+    static constexpr int kMaxDatagramBytes = 1472;
+    static constexpr int kMaxBatchPackets = 16;
+
+    PacketBuilder();
+
+    // Packets built since the last clear(); views stay valid until then.
+    QSpan<const QByteArrayView> packets() const;
+    int remaining() const;
+    void clear();
+
+    // Empty on failure, if the packet would not fit, or if the batch is
+    // full.
+    QByteArrayView buildAudio(Packetizer& packetizer,
+                              AeadCipher& cipher,
+                              quint16 audioSeq,
+                              QSpan<const quint8> codecFrame);
+    QByteArrayView buildFec(Packetizer& packetizer,
+                            AeadCipher& cipher,
+                            quint16 blockStart,
+                            quint8 blockSize,
+                            quint8 parityIndex,
+                            QSpan<const quint8> parity);
+
+private:
+    uchar* payloadArea(const Packetizer& packetizer, int payloadBytes);
+    QByteArrayView seal(Packetizer& packetizer,
+                        AeadCipher& cipher,
+                        Proto::PacketType type,
+                        int payloadBytes);
+
+    std::array<QByteArray, kMaxBatchPackets> m_buffers;
+    std::array<QByteArrayView, kMaxBatchPackets> m_packets;
+    int m_count = 0;
+    int m_headerBytes = 0;
+};
@@ -154,6 +154,35 @@ QByteArray Packetizer::packPlainLegacy(Proto::PacketType type, const QByteArray&
     return buffer;
 }
 
+int Packetizer::dataHeaderSize() const
+{
+    return (m_useLegacy ? Proto::LEGACY_FIXED_HEADER_SIZE : Proto::FIXED_HEADER_SIZE) +
+           Proto::SECURITY_HEADER_SIZE;
+}
+
+int Packetizer::writeDataHeader(Proto::PacketType type, quint64 nonce, uchar* out)
+{
+    // Same layout as serializePacket()/packLegacy(), as direct stores.
+    const bool legacy = m_useLegacy;
+    const int headerSize = (legacy ? Proto::LEGACY_FIXED_HEADER_SIZE : Proto::FIXED_HEADER_SIZE) +
+                           Proto::SECURITY_HEADER_SIZE;
+    out[0] = Proto::PROTOCOL_VERSION;
+    out[1] = static_cast<uchar>(type);
+    qToBigEndian<quint16>(static_cast<quint16>(headerSize), out + 2);
+    qToBigEndian<quint32>(m_channelId, out + 4);
+    qToBigEndian<quint32>(m_senderId, out + 8);
+    qToBigEndian<quint16>(m_seq++, out + 12);
+    int offset = 14;
+    if (!legacy)
+    {
+        qToBigEndian<quint16>(0, out + 14);
+        offset = Proto::FIXED_HEADER_SIZE;
+    }
+    qToBigEndian<quint64>(nonce, out + offset);
+    qToBigEndian<quint32>(m_keyId, out + offset + 8);
+    return headerSize;
+}
+
 bool Packetizer::unpack(const QByteArray& datagram, ParsedPacket& out) const
 {
     return Proto::deserializePacket(datagram,
@@ -165,5 +194,5 @@ bool Packetizer::unpack(const QByteArray& datagram, ParsedPacket& out) const
 
 quint16 Packetizer::nextSeq() const
 {
-    return m_seq;
+    return m_seq.load();
 }
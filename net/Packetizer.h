@@ -2,6 +2,7 @@
 
 #include <QObject>
 #include <QByteArray>
+#include <atomic>
 
 #include "packet.h"
 
@@ -46,14 +47,23 @@ public:
     QByteArray packPlainLegacy(Proto::PacketType type,
                                const QByteArray& payload);
 
+    // Size of the fixed plus security header for encrypted packets in the
+    // current wire format.
+    int dataHeaderSize() const;
+    // Stores that header at out[0, dataHeaderSize()) and consumes a
+    // sequence number, like pack() does.
+    int writeDataHeader(Proto::PacketType type, quint64 nonce, uchar* out);
+
     bool unpack(const QByteArray& datagram, ParsedPacket& out) const;
 
     quint16 nextSeq() const;
 
 private:
-    quint32 m_channelId = 0;
-    quint32 m_senderId = 0;
-    quint32 m_keyId = 0;
-    quint16 m_seq = 0;
-    bool m_useLegacy = false;
+    // Audio is packed on the TX thread while joins and rekeys set these on
+    // the UI thread, which also packs control packets.
+    std::atomic<quint32> m_channelId{0};
+    std::atomic<quint32> m_senderId{0};
+    std::atomic<quint32> m_keyId{0};
+    std::atomic<quint16> m_seq{0};
+    std::atomic<bool> m_useLegacy{false};
 };
@@ -54,11 +54,6 @@ QByteArray serializePacket(const PacketHeader& header,
     return buffer;
 }
 
-static quint16 readUint16(const char* data)
-{
-    return qFromBigEndian<quint16>(reinterpret_cast<const uchar*>(data));
-}
-
 static quint32 readUint32(const char* data)
 {
     return qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data));
@@ -69,42 +64,47 @@ static quint64 readUint64(const char* data)
     return qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(data));
 }
 
+int readHeader(const uchar* data, qsizetype size, PacketHeader& header)
+{
+    if (size < LEGACY_FIXED_HEADER_SIZE)
+        return -1;
+
+    header.version   = data[0];
+    header.type      = data[1];
+    header.headerLen = qFromBigEndian<quint16>(data + 2);
+    header.channelId = qFromBigEndian<quint32>(data + 4);
+    header.senderId  = qFromBigEndian<quint32>(data + 8);
+    header.seq       = qFromBigEndian<quint16>(data + 12);
+
+    if (header.headerLen == FIXED_HEADER_SIZE ||
+        header.headerLen == FIXED_HEADER_SIZE + SECURITY_HEADER_SIZE)
+    {
+        if (size < FIXED_HEADER_SIZE)
+            return -1;
+
+        header.flags = qFromBigEndian<quint16>(data + 14);
+        return FIXED_HEADER_SIZE;
+    }
+
+    header.flags = 0;
+    return LEGACY_FIXED_HEADER_SIZE;
+}
+
 bool deserializePacket(const QByteArray& datagram,
                        PacketHeader& header,
                        SecurityHeader& sec,
                        QByteArray& encryptedPayload,
                        QByteArray& authTag)
 {
-    if (datagram.size() < LEGACY_FIXED_HEADER_SIZE)
-        return false;
-
     const char* ptr = datagram.constData();
-    int offset = 0;
-
-    header.version   = static_cast<quint8>(ptr[offset++]);
-    header.type      = static_cast<quint8>(ptr[offset++]);
-    header.headerLen = readUint16(ptr + offset); offset += 2;
-    header.channelId = readUint32(ptr + offset); offset += 4;
-    header.senderId  = readUint32(ptr + offset); offset += 4;
-    header.seq       = readUint16(ptr + offset); offset += 2;
+    const int fixedHeaderSizeUsed = readHeader(reinterpret_cast<const uchar*>(ptr),
+                                               datagram.size(),
+                                               header);
+    if (fixedHeaderSizeUsed < 0)
+        return false;
 
+    int offset = fixedHeaderSizeUsed;
     const int tagSize = AUTH_TAG_SIZE;
-    int fixedHeaderSizeUsed = LEGACY_FIXED_HEADER_SIZE;
-
-    if (header.headerLen == FIXED_HEADER_SIZE ||
-        header.headerLen == FIXED_HEADER_SIZE + SECURITY_HEADER_SIZE)
-    {
-        if (datagram.size() < FIXED_HEADER_SIZE)
-            return false;
-
-        header.flags = readUint16(ptr + offset); offset += 2;
-        fixedHeaderSizeUsed = FIXED_HEADER_SIZE;
-    }
-    else
-    {
-        header.flags = 0;
-        fixedHeaderSizeUsed = LEGACY_FIXED_HEADER_SIZE;
-    }
 
     if (header.headerLen >= fixedHeaderSizeUsed + SECURITY_HEADER_SIZE &&
         datagram.size() >= fixedHeaderSizeUsed + SECURITY_HEADER_SIZE + tagSize)
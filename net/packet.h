@@ -48,6 +48,11 @@ struct SecurityHeader {
     quint32 keyId;
 };
 
+// Reads the fixed header only, without copying the payload. Returns the
+// size of the fixed header that was found, or -1 if the datagram is too
+// short.
+int readHeader(const uchar* data, qsizetype size, PacketHeader& header);
+
 QByteArray serializePacket(const PacketHeader& header,
                            const SecurityHeader& sec,
                            const QByteArray& encryptedPayload,
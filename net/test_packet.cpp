@@ -1,5 +1,9 @@
 #include "packet.h"
+#include "PacketBuilder.h"
+#include "Packetizer.h"
+#include "crypto/AeadCipher.h"
 #include <QDebug>
+#include <QtEndian>
 
 using namespace Proto;
 
@@ -44,3 +48,123 @@ void testPacket()
     qDebug() << payload2;
     qDebug() << tag2.size();
 }
+
+static void setupSender(Packetizer& packetizer, AeadCipher& cipher,
+                        AeadCipher::Mode mode, bool legacy)
+{
+    packetizer.setChannelId(1234);
+    packetizer.setSenderId(5678);
+    packetizer.setKeyId(7);
+    packetizer.setUseLegacy(legacy);
+    cipher.setMode(mode);
+    cipher.setKey(QByteArray(32, 0x5A), QByteArray::fromHex("0102030405060708"));
+}
+
+// PacketBuilder must put the same bytes on the wire as encrypt() + pack().
+static bool builderMatchesPack(AeadCipher::Mode mode, bool legacy)
+{
+    Packetizer builtPacketizer;
+    Packetizer packedPacketizer;
+    AeadCipher builtCipher;
+    AeadCipher packedCipher;
+    setupSender(builtPacketizer, builtCipher, mode, legacy);
+    setupSender(packedPacketizer, packedCipher, mode, legacy);
+
+    const QByteArray frame("HELLO_CODEC2");
+    const QSpan<const quint8> frameSpan(reinterpret_cast<const quint8*>(frame.constData()),
+                                        frame.size());
+    PacketBuilder builder;
+    bool ok = true;
+
+    const quint16 audioSeq = 321;
+    const QByteArrayView builtAudio = builder.buildAudio(builtPacketizer,
+                                                         builtCipher,
+                                                         audioSeq,
+                                                         frameSpan);
+    QByteArray audioPayload(2, 0);
+    qToBigEndian(audioSeq, reinterpret_cast<uchar*>(audioPayload.data()));
+    audioPayload.append(frame);
+    const quint64 audioNonce = packedCipher.nextNonce();
+    const AeadResult audioEnc = packedCipher.encrypt(audioPayload, audioNonce);
+    const QByteArray packedAudio = legacy
+        ? packedPacketizer.packLegacy(Proto::PKT_AUDIO, audioEnc.ciphertext, audioEnc.tag, audioNonce)
+        : packedPacketizer.pack(Proto::PKT_AUDIO, audioEnc.ciphertext, audioEnc.tag, audioNonce);
+    ok = ok && !builtAudio.isEmpty() && builtAudio == QByteArrayView(packedAudio);
+
+    const quint16 blockStart = 320;
+    const quint8 blockSize = 4;
+    const quint8 parityIndex = 1;
+    const QByteArrayView builtFec = builder.buildFec(builtPacketizer,
+                                                     builtCipher,
+                                                     blockStart,
+                                                     blockSize,
+                                                     parityIndex,
+                                                     frameSpan);
+    QByteArray fecPayload(4, 0);
+    qToBigEndian(blockStart, reinterpret_cast<uchar*>(fecPayload.data()));
+    fecPayload[2] = static_cast<char>(blockSize);
+    fecPayload[3] = static_cast<char>(parityIndex);
+    fecPayload.append(frame);
+    const quint64 fecNonce = packedCipher.nextNonce();
+    const AeadResult fecEnc = packedCipher.encrypt(fecPayload, fecNonce);
+    const QByteArray packedFec = legacy
+        ? packedPacketizer.packLegacy(Proto::PKT_FEC, fecEnc.ciphertext, fecEnc.tag, fecNonce)
+        : packedPacketizer.pack(Proto::PKT_FEC, fecEnc.ciphertext, fecEnc.tag, fecNonce);
+    ok = ok && !builtFec.isEmpty() && builtFec == QByteArrayView(packedFec);
+
+    return ok && builder.packets().size() == 2;
+}
+
+bool testPacketBuilder()
+{
+    bool ok = true;
+    const bool legacyModes[] = { false, true };
+    for (bool legacy : legacyModes)
+    {
+#ifdef INCOMUDON_USE_OPENSSL
+        const bool aesOk = builderMatchesPack(AeadCipher::AesGcm, legacy);
+        qDebug() << "AesGcm builder matches pack, legacy" << legacy << ":" << aesOk;
+        ok = ok && aesOk;
+#endif
+        const bool xorOk = builderMatchesPack(AeadCipher::LegacyXor, legacy);
+        qDebug() << "LegacyXor builder matches pack, legacy" << legacy << ":" << xorOk;
+        ok = ok && xorOk;
+    }
+    return ok;
+}
+
+bool testReadHeader()
+{
+    Packetizer packetizer;
+    packetizer.setChannelId(1234);
+    packetizer.setSenderId(5678);
+    const QByteArray payload("HELLO_CODEC2");
+    const QByteArray tag(AUTH_TAG_SIZE, 0xAA);
+
+    const QByteArray current = packetizer.pack(PKT_AUDIO, payload, tag, 999999);
+    PacketHeader header {};
+    const int currentSize = readHeader(reinterpret_cast<const uchar*>(current.constData()),
+                                       current.size(),
+                                       header);
+    const bool currentOk = currentSize == FIXED_HEADER_SIZE &&
+                           header.type == PKT_AUDIO &&
+                           header.channelId == 1234 &&
+                           header.senderId == 5678 &&
+                           header.seq == 0;
+    qDebug() << "Current header:" << currentOk;
+
+    const QByteArray legacy = packetizer.packLegacy(PKT_AUDIO, payload, tag, 999999);
+    const int legacySize = readHeader(reinterpret_cast<const uchar*>(legacy.constData()),
+                                      legacy.size(),
+                                      header);
+    const bool legacyOk = legacySize == LEGACY_FIXED_HEADER_SIZE &&
+                          header.flags == 0 &&
+                          header.seq == 1;
+    qDebug() << "Legacy header:" << legacyOk;
+
+    const bool truncatedOk = readHeader(reinterpret_cast<const uchar*>(current.constData()),
+                                        LEGACY_FIXED_HEADER_SIZE - 1,
+                                        header) == -1;
+    qDebug() << "Truncated header rejected:" << truncatedOk;
+    return currentOk && legacyOk && truncatedOk;
+}
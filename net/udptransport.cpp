@@ -1,11 +1,49 @@
 #include "udptransport.h"
+#include <QThread>
 #include <QVariant>
 
+#ifdef Q_OS_UNIX
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+static bool toSockaddr(const QHostAddress& addr, quint16 port, sockaddr_in* out)
+{
+    bool isIpv4 = false;
+    const quint32 ipv4 = addr.toIPv4Address(&isIpv4);
+    if (!isIpv4)
+        return false;
+    *out = sockaddr_in {};
+    out->sin_family = AF_INET;
+    out->sin_port = htons(port);
+    out->sin_addr.s_addr = htonl(ipv4);
+    return true;
+}
+#endif
+
+#ifdef Q_OS_LINUX
+static constexpr int kMaxSendBatch = 16;
+#endif
+
 UdpTransport::UdpTransport(QObject* parent)
     : QObject(parent)
 {
     connect(&m_socket, &QUdpSocket::readyRead,
             this, &UdpTransport::onReadyRead);
+
+    m_releaseTimer.setSingleShot(true);
+    m_releaseTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_releaseTimer, &QTimer::timeout,
+            this, &UdpTransport::releaseDelayed);
+
+    const QString netem = qEnvironmentVariable("INCOMUDON_NETEM");
+    if (!netem.isEmpty())
+        setImpairment(netem);
+    const QString capture = qEnvironmentVariable("INCOMUDON_CAPTURE");
+    if (!capture.isEmpty())
+        setCapturePath(capture);
 }
 
 bool UdpTransport::bind(quint16 port)
@@ -17,6 +55,7 @@ bool UdpTransport::bind(quint16 port)
     }
 
     applyQosOption();
+    m_nativeSocket.store(m_socket.socketDescriptor(), std::memory_order_release);
     emit bound(m_socket.localPort());
     return true;
 }
@@ -39,14 +78,161 @@ void UdpTransport::send(const QByteArray& data,
                         const QHostAddress& addr,
                         quint16 port)
 {
+    if (m_txImpairment)
+    {
+        impair(*m_txImpairment, {true, data, addr, port});
+        return;
+    }
     m_socket.writeDatagram(data, addr, port);
 }
 
+void UdpTransport::sendDirect(QByteArrayView data,
+                              const QHostAddress& addr,
+                              quint16 port)
+{
+#ifdef Q_OS_UNIX
+    const qintptr fd = m_nativeSocket.load(std::memory_order_acquire);
+    sockaddr_in to;
+    if (fd >= 0 && !m_impaired.load(std::memory_order_acquire) && toSockaddr(addr, port, &to))
+    {
+        // The socket is non-blocking; a full send buffer just drops the
+        // datagram, same as writeDatagram().
+        ::sendto(static_cast<int>(fd), data.constData(), static_cast<size_t>(data.size()), 0,
+                 reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+        return;
+    }
+#endif
+
+    // The view may point into a buffer the caller reuses, so the queued
+    // path takes a copy.
+    const QByteArray datagram = data.toByteArray();
+    if (QThread::currentThread() == thread())
+    {
+        send(datagram, addr, port);
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this, datagram, addr, port]() {
+        send(datagram, addr, port);
+    }, Qt::QueuedConnection);
+}
+
+void UdpTransport::sendBatch(QSpan<const QByteArrayView> datagrams,
+                             const QHostAddress& addr,
+                             quint16 port)
+{
+#ifdef Q_OS_LINUX
+    const qintptr fd = m_nativeSocket.load(std::memory_order_acquire);
+    sockaddr_in to;
+    if (fd >= 0 && !m_impaired.load(std::memory_order_acquire) && toSockaddr(addr, port, &to))
+    {
+        iovec iov[kMaxSendBatch];
+        mmsghdr messages[kMaxSendBatch];
+        qsizetype offset = 0;
+        while (offset < datagrams.size())
+        {
+            const int count = static_cast<int>(qMin<qsizetype>(kMaxSendBatch, datagrams.size() - offset));
+            for (int i = 0; i < count; ++i)
+            {
+                const QByteArrayView datagram = datagrams[offset + i];
+                iov[i].iov_base = const_cast<char*>(datagram.data());
+                iov[i].iov_len = static_cast<size_t>(datagram.size());
+                messages[i] = mmsghdr {};
+                messages[i].msg_hdr.msg_name = &to;
+                messages[i].msg_hdr.msg_namelen = sizeof(to);
+                messages[i].msg_hdr.msg_iov = &iov[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            const int sent = ::sendmmsg(static_cast<int>(fd), messages, static_cast<unsigned int>(count), 0);
+            if (sent < 0 && errno == EINTR)
+                continue;
+            // A full send buffer drops the rest of the burst, as single
+            // sends would.
+            if (sent <= 0)
+                return;
+            offset += sent;
+        }
+        return;
+    }
+#endif
+
+    for (const QByteArrayView& datagram : datagrams)
+        sendDirect(datagram, addr, port);
+}
+
 quint16 UdpTransport::localPort() const
 {
     return m_socket.localPort();
 }
 
+QString UdpTransport::impairment() const
+{
+    return m_impairmentSpec;
+}
+
+bool UdpTransport::setImpairment(const QString& spec)
+{
+    NetworkImpairmentConfig tx;
+    NetworkImpairmentConfig rx;
+    QString error;
+    if (!NetworkImpairmentConfig::parse(spec, &tx, &rx, &error))
+    {
+        qWarning("%s", qPrintable(error));
+        return false;
+    }
+
+    // Datagrams already held back keep their release times.
+    m_txImpairment.reset(tx.isActive() ? new NetworkImpairment(tx) : nullptr);
+    m_rxImpairment.reset(rx.isActive() ? new NetworkImpairment(rx) : nullptr);
+    m_impaired.store(m_txImpairment != nullptr, std::memory_order_release);
+    if (!m_impairmentClock.isValid())
+        m_impairmentClock.start();
+    if (m_impairmentSpec != spec)
+    {
+        m_impairmentSpec = spec;
+        emit impairmentChanged();
+    }
+    if (m_txImpairment || m_rxImpairment)
+        qWarning("UdpTransport: network impairment active: %s", qPrintable(spec));
+    return true;
+}
+
+QString UdpTransport::capturePath() const
+{
+    return m_capturePath;
+}
+
+bool UdpTransport::setCapturePath(const QString& path)
+{
+    if (m_capturePath == path && m_capture.isOpen() == !path.isEmpty())
+        return true;
+
+    m_capture.close();
+    bool ok = true;
+    if (!path.isEmpty())
+    {
+        QString error;
+        ok = m_capture.open(path, &error);
+        if (ok)
+            m_captureClock.start();
+        else
+            qWarning("UdpTransport: %s", qPrintable(error));
+    }
+    if (m_capturePath != path)
+    {
+        m_capturePath = path;
+        emit capturePathChanged();
+    }
+    return ok;
+}
+
+void UdpTransport::injectDatagram(const QByteArray& data,
+                                  const QHostAddress& sender,
+                                  quint16 senderPort)
+{
+    emit datagramReceived(data, sender, senderPort);
+}
+
 void UdpTransport::onReadyRead()
 {
     while (m_socket.hasPendingDatagrams())
@@ -59,10 +245,46 @@ void UdpTransport::onReadyRead()
         m_socket.readDatagram(datagram.data(), datagram.size(),
                               &sender, &senderPort);
 
+        if (m_capture.isOpen())
+            m_capture.write(m_captureClock.nsecsElapsed() / 1000, sender, senderPort, datagram);
+        if (m_rxImpairment)
+        {
+            impair(*m_rxImpairment, {false, datagram, sender, senderPort});
+            continue;
+        }
         emit datagramReceived(datagram, sender, senderPort);
     }
 }
 
+void UdpTransport::impair(NetworkImpairment& link, DelayedDatagram datagram)
+{
+    const qint64 nowUs = m_impairmentClock.nsecsElapsed() / 1000;
+    qint64 releaseUs[NetworkImpairment::kMaxCopies];
+    const int copies = link.offer(nowUs, static_cast<int>(datagram.data.size()), releaseUs);
+    for (int i = 0; i < copies; ++i)
+        m_delayed.emplace(releaseUs[i], datagram);
+    releaseDelayed();
+}
+
+void UdpTransport::releaseDelayed()
+{
+    const qint64 nowUs = m_impairmentClock.nsecsElapsed() / 1000;
+    while (!m_delayed.empty() && m_delayed.begin()->first <= nowUs)
+    {
+        const DelayedDatagram datagram = std::move(m_delayed.begin()->second);
+        m_delayed.erase(m_delayed.begin());
+        if (datagram.outgoing)
+            m_socket.writeDatagram(datagram.data, datagram.address, datagram.port);
+        else
+            emit datagramReceived(datagram.data, datagram.address, datagram.port);
+    }
+
+    if (m_delayed.empty())
+        return;
+    const qint64 waitUs = m_delayed.begin()->first - nowUs;
+    m_releaseTimer.start(static_cast<int>((waitUs + 999) / 1000));
+}
+
 void UdpTransport::applyQosOption()
 {
     // DSCP EF (46) for voice; lower 2 bits are ECN.
@@ -2,14 +2,36 @@
 
 #include <QObject>
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QUdpSocket>
 #include <QHostAddress>
+#include <QSpan>
+#include <QTimer>
 #include <QtGlobal>
+#include <atomic>
+#include <map>
+#include <memory>
+
+#include "DatagramCapture.h"
+#include "NetworkImpairment.h"
 
 class UdpTransport : public QObject
 {
     Q_OBJECT
 
+    // Debug only: emulated link conditions for both directions, in the
+    // NetworkImpairmentConfig::parse() format. Defaults to INCOMUDON_NETEM.
+    Q_PROPERTY(QString impairment
+               READ impairment
+               WRITE setImpairment
+               NOTIFY impairmentChanged)
+    // Debug only: records every received datagram to this file for
+    // offline replay. Defaults to INCOMUDON_CAPTURE.
+    Q_PROPERTY(QString capturePath
+               READ capturePath
+               WRITE setCapturePath
+               NOTIFY capturePathChanged)
+
 public:
     explicit UdpTransport(QObject* parent = nullptr);
 
@@ -19,21 +41,70 @@ public:
     void send(const QByteArray& data,
               const QHostAddress& addr,
               quint16 port);
+    // Thread-safe send for the TX pipeline. Writes straight to the bound
+    // socket where the platform allows it, otherwise hands the datagram to
+    // the socket's thread.
+    void sendDirect(QByteArrayView data,
+                    const QHostAddress& addr,
+                    quint16 port);
+    // Same contract as sendDirect() for several datagrams to one peer.
+    // Linux hands the whole burst to the kernel with one sendmmsg().
+    void sendBatch(QSpan<const QByteArrayView> datagrams,
+                   const QHostAddress& addr,
+                   quint16 port);
     quint16 localPort() const;
 
+    QString impairment() const;
+    bool setImpairment(const QString& spec);
+    QString capturePath() const;
+    bool setCapturePath(const QString& path);
+
+    // Hands a datagram to listeners as if the socket had received it,
+    // bypassing capture and impairment. Used to replay captures.
+    void injectDatagram(const QByteArray& data,
+                        const QHostAddress& sender,
+                        quint16 senderPort);
+
 signals:
     void datagramReceived(const QByteArray& data,
                           const QHostAddress& sender,
                           quint16 senderPort);
     void bound(quint16 port);
     void bindFailed(const QString& errorString);
+    void impairmentChanged();
+    void capturePathChanged();
 
 private slots:
     void onReadyRead();
 
 private:
+    struct DelayedDatagram
+    {
+        bool outgoing = false;
+        QByteArray data;
+        QHostAddress address;
+        quint16 port = 0;
+    };
+
     void applyQosOption();
+    void impair(NetworkImpairment& link, DelayedDatagram datagram);
+    void releaseDelayed();
 
     QUdpSocket m_socket;
+    std::atomic<qintptr> m_nativeSocket{-1};
     bool m_qosEnabled = true;
+
+    // Owner thread only; m_impaired lets other threads route around the
+    // direct socket writes while an impairment is set.
+    QString m_impairmentSpec;
+    std::unique_ptr<NetworkImpairment> m_txImpairment;
+    std::unique_ptr<NetworkImpairment> m_rxImpairment;
+    std::atomic<bool> m_impaired{false};
+    QElapsedTimer m_impairmentClock;
+    QTimer m_releaseTimer;
+    std::multimap<qint64, DelayedDatagram> m_delayed;
+
+    QString m_capturePath;
+    DatagramCaptureWriter m_capture;
+    QElapsedTimer m_captureClock;
 };
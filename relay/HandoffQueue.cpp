@@ -0,0 +1,68 @@
+#include "HandoffQueue.h"
+
+#include <cstring>
+
+HandoffQueue::HandoffQueue(int capacity)
+{
+    quint64 size = 2;
+    while (size < static_cast<quint64>(qMax(2, capacity)))
+        size <<= 1;
+
+    m_cells.reset(new Cell[size]);
+    m_mask = size - 1;
+    for (quint64 i = 0; i < size; ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool HandoffQueue::push(const uchar* data, int size, const sockaddr_in& from)
+{
+    if (size < 0 || size > kMaxDatagramBytes)
+        return false;
+
+    quint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    for (;;)
+    {
+        cell = &m_cells[pos & m_mask];
+        const quint64 sequence = cell->sequence.load(std::memory_order_acquire);
+        const qint64 diff = static_cast<qint64>(sequence - pos);
+        if (diff == 0)
+        {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->datagram.from = from;
+    cell->datagram.size = size;
+    std::memcpy(cell->datagram.data, data, static_cast<size_t>(size));
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+const HandoffQueue::Datagram* HandoffQueue::peek(int offset) const
+{
+    const quint64 pos = m_dequeuePos + static_cast<quint64>(offset);
+    const Cell& cell = m_cells[pos & m_mask];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+        return nullptr;
+    return &cell.datagram;
+}
+
+void HandoffQueue::release(int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        m_cells[m_dequeuePos & m_mask].sequence.store(m_dequeuePos + m_mask + 1,
+                                                      std::memory_order_release);
+        ++m_dequeuePos;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <netinet/in.h>
+
+// Bounded lock-free queue carrying datagrams from any relay shard to the
+// shard that owns their channel. Producers claim cells with a CAS on the
+// enqueue position; the single consumer reads cells in place and releases
+// them once the fan-out that points into them has been sent.
+class HandoffQueue
+{
+public:
+    static constexpr int kMaxDatagramBytes = 1500;
+
+    struct Datagram
+    {
+        sockaddr_in from;
+        int size = 0;
+        uchar data[kMaxDatagramBytes];
+    };
+
+    // Capacity is rounded up to a power of two.
+    explicit HandoffQueue(int capacity);
+
+    // Any thread. Returns false if the queue is full.
+    bool push(const uchar* data, int size, const sockaddr_in& from);
+
+    // Consumer only: the offset-th unreleased datagram, or nullptr.
+    const Datagram* peek(int offset) const;
+    void release(int count);
+
+private:
+    struct Cell
+    {
+        std::atomic<quint64> sequence{0};
+        Datagram datagram;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    quint64 m_mask = 0;
+    alignas(64) std::atomic<quint64> m_enqueuePos{0};
+    alignas(64) quint64 m_dequeuePos = 0;
+};
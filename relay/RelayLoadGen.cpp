@@ -0,0 +1,282 @@
+#include "RelayLoadGen.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QList>
+#include <QThread>
+#include <arpa/inet.h>
+#include <array>
+#include <atomic>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/Packetizer.h"
+
+namespace {
+constexpr int kKeepaliveIntervalMs = 5000;
+constexpr int kSettleMs = 300;
+constexpr int kRecvBatch = 32;
+
+struct SimMember
+{
+    int fd = -1;
+    bool talker = false;
+    QByteArray keepalive;
+    QByteArray pttOn;
+    QByteArray audio;
+};
+
+static int openClientSocket()
+{
+    const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static sockaddr_in relayAddress(const RelayConfig& config)
+{
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config.port);
+    if (::inet_pton(AF_INET, config.bindAddress.toLatin1().constData(), &addr.sin_addr) != 1 ||
+        addr.sin_addr.s_addr == htonl(INADDR_ANY))
+    {
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+    return addr;
+}
+
+static bool sendPacket(int fd, const QByteArray& packet, const sockaddr_in& to)
+{
+    return ::sendto(fd, packet.constData(), static_cast<size_t>(packet.size()), 0,
+                    reinterpret_cast<const sockaddr*>(&to), sizeof(to)) == packet.size();
+}
+
+static double perSecond(quint64 count, double seconds)
+{
+    return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+}
+}
+
+QJsonObject runRelayLoadGen(RelayServer& server,
+                            const RelayConfig& relayConfig,
+                            const RelayLoadGenConfig& config)
+{
+    const sockaddr_in relay = relayAddress(relayConfig);
+    const QByteArray payload(config.payloadBytes, '\x55');
+    const QByteArray tag(Proto::AUTH_TAG_SIZE, '\0');
+
+    // One talker plus listeners per channel, each on its own port as a
+    // real client would be.
+    QList<SimMember> members;
+    Packetizer packetizer;
+    for (int channel = 0; channel < config.channels; ++channel)
+    {
+        packetizer.setChannelId(static_cast<quint32>(channel + 1));
+        for (int slot = 0; slot <= config.listenersPerChannel; ++slot)
+        {
+            SimMember member;
+            member.fd = openClientSocket();
+            if (member.fd < 0)
+                continue;
+            member.talker = slot == 0;
+            // Dense ids, so no listener count makes channels share a member.
+            packetizer.setSenderId(static_cast<quint32>(channel) * static_cast<quint32>(config.listenersPerChannel + 1) +
+                                   static_cast<quint32>(slot + 1));
+            sendPacket(member.fd, packetizer.packPlain(Proto::PKT_JOIN, QByteArray()), relay);
+            member.keepalive = packetizer.packPlain(Proto::PKT_KEEPALIVE, QByteArray());
+            if (member.talker)
+            {
+                member.pttOn = packetizer.packPlain(Proto::PKT_PTT_ON, QByteArray());
+                // The relay never decrypts, so a fixed payload and tag will do.
+                member.audio = packetizer.pack(Proto::PKT_AUDIO, payload, tag, 1);
+            }
+            members.append(member);
+        }
+    }
+    QThread::msleep(kSettleMs / 2);
+    for (const SimMember& member : std::as_const(members))
+    {
+        if (member.talker)
+            sendPacket(member.fd, member.pttOn, relay);
+    }
+    QThread::msleep(kSettleMs / 2);
+
+    std::atomic<bool> running{true};
+    std::atomic<quint64> clientSent{0};
+    std::atomic<quint64> clientReceived{0};
+
+    // Listeners: count what the relay delivers and keep every member (and
+    // its talk grant) alive for long runs.
+    QThread* receiver = QThread::create([&]() {
+        const int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        for (const SimMember& member : std::as_const(members))
+        {
+            epoll_event event {};
+            event.events = EPOLLIN;
+            event.data.fd = member.fd;
+            ::epoll_ctl(epollFd, EPOLL_CTL_ADD, member.fd, &event);
+        }
+
+        std::array<std::array<char, HandoffQueue::kMaxDatagramBytes>, kRecvBatch> buffers;
+        std::array<iovec, kRecvBatch> iov;
+        std::array<mmsghdr, kRecvBatch> messages;
+        std::array<epoll_event, 64> events;
+        QElapsedTimer keepaliveClock;
+        keepaliveClock.start();
+        while (running.load(std::memory_order_relaxed))
+        {
+            const int ready = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 100);
+            for (int e = 0; e < ready; ++e)
+            {
+                for (;;)
+                {
+                    for (int i = 0; i < kRecvBatch; ++i)
+                    {
+                        iov[i].iov_base = buffers[i].data();
+                        iov[i].iov_len = buffers[i].size();
+                        messages[i] = mmsghdr {};
+                        messages[i].msg_hdr.msg_iov = &iov[i];
+                        messages[i].msg_hdr.msg_iovlen = 1;
+                    }
+                    const int received = ::recvmmsg(events[e].data.fd, messages.data(), kRecvBatch, MSG_DONTWAIT, nullptr);
+                    if (received <= 0)
+                        break;
+                    quint64 audio = 0;
+                    for (int i = 0; i < received; ++i)
+                    {
+                        if (messages[i].msg_len > 1 && static_cast<quint8>(buffers[i][1]) == Proto::PKT_AUDIO)
+                            ++audio;
+                    }
+                    clientReceived.fetch_add(audio, std::memory_order_relaxed);
+                    if (received < kRecvBatch)
+                        break;
+                }
+            }
+
+            if (keepaliveClock.elapsed() >= kKeepaliveIntervalMs)
+            {
+                keepaliveClock.restart();
+                for (const SimMember& member : std::as_const(members))
+                {
+                    sendPacket(member.fd, member.keepalive, relay);
+                    if (member.talker)
+                        sendPacket(member.fd, member.pttOn, relay);
+                }
+            }
+        }
+        ::close(epollFd);
+    });
+
+    QList<const SimMember*> talkers;
+    for (const SimMember& member : std::as_const(members))
+    {
+        if (member.talker)
+            talkers.append(&member);
+    }
+
+    const int senderCount = qBound(1, config.senderThreads, qMax(1, static_cast<int>(talkers.size())));
+    const qint64 intervalNs = config.talkerRate > 0 ? 1000000000LL / config.talkerRate : 0;
+    QList<QThread*> senders;
+    for (int s = 0; s < senderCount; ++s)
+    {
+        senders.append(QThread::create([&, s]() {
+            QElapsedTimer clock;
+            clock.start();
+            qint64 nextNs = 0;
+            quint64 sent = 0;
+            while (running.load(std::memory_order_relaxed))
+            {
+                for (qsizetype t = s; t < talkers.size(); t += senderCount)
+                {
+                    if (sendPacket(talkers.at(t)->fd, talkers.at(t)->audio, relay))
+                        ++sent;
+                }
+                if (intervalNs <= 0)
+                    continue;
+                nextNs += intervalNs;
+                const qint64 waitNs = nextNs - clock.nsecsElapsed();
+                if (waitNs > 0)
+                    QThread::usleep(static_cast<unsigned long>(waitNs / 1000));
+            }
+            clientSent.fetch_add(sent, std::memory_order_relaxed);
+        }));
+    }
+
+    QList<RelayStats> before;
+    for (int i = 0; i < server.shardCount(); ++i)
+        before.append(server.shardStats(i));
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    receiver->start();
+    for (QThread* sender : std::as_const(senders))
+        sender->start();
+    QThread::msleep(static_cast<unsigned long>(qMax(1, config.durationSec)) * 1000);
+
+    QList<RelayStats> after;
+    for (int i = 0; i < server.shardCount(); ++i)
+        after.append(server.shardStats(i));
+    const double seconds = elapsed.nsecsElapsed() / 1e9;
+
+    running.store(false, std::memory_order_relaxed);
+    for (QThread* sender : std::as_const(senders))
+        sender->wait();
+    receiver->wait();
+    qDeleteAll(senders);
+    delete receiver;
+    for (const SimMember& member : std::as_const(members))
+        ::close(member.fd);
+
+    QJsonArray results;
+    quint64 totalReceived = 0;
+    quint64 totalForwarded = 0;
+    for (int i = 0; i < server.shardCount(); ++i)
+    {
+        const quint64 received = after.at(i).datagramsReceived - before.at(i).datagramsReceived;
+        const quint64 forwarded = after.at(i).datagramsForwarded - before.at(i).datagramsForwarded;
+        const quint64 handedOff = after.at(i).datagramsHandedOff - before.at(i).datagramsHandedOff;
+        totalReceived += received;
+        totalForwarded += forwarded;
+
+        QJsonObject shard;
+        shard.insert(QStringLiteral("shard"), i);
+        shard.insert(QStringLiteral("receivedPps"), perSecond(received, seconds));
+        shard.insert(QStringLiteral("forwardedPps"), perSecond(forwarded, seconds));
+        shard.insert(QStringLiteral("handedOffPps"), perSecond(handedOff, seconds));
+        shard.insert(QStringLiteral("handoffDrops"),
+                     static_cast<qint64>(after.at(i).handoffDrops - before.at(i).handoffDrops));
+        results.append(shard);
+    }
+
+    const quint64 sent = clientSent.load();
+    const quint64 delivered = clientReceived.load();
+    const quint64 expected = sent * static_cast<quint64>(config.listenersPerChannel);
+
+    QJsonObject report;
+    report.insert(QStringLiteral("shards"), server.shardCount());
+    report.insert(QStringLiteral("channelSteering"), server.channelSteeringActive());
+    report.insert(QStringLiteral("channels"), config.channels);
+    report.insert(QStringLiteral("listenersPerChannel"), config.listenersPerChannel);
+    report.insert(QStringLiteral("talkerRate"), config.talkerRate);
+    report.insert(QStringLiteral("payloadBytes"), config.payloadBytes);
+    report.insert(QStringLiteral("durationSec"), seconds);
+    report.insert(QStringLiteral("clientSentPps"), perSecond(sent, seconds));
+    report.insert(QStringLiteral("clientReceivedPps"), perSecond(delivered, seconds));
+    report.insert(QStringLiteral("deliveryRatio"), expected > 0 ? static_cast<double>(delivered) / expected : 0.0);
+    report.insert(QStringLiteral("totalReceivedPps"), perSecond(totalReceived, seconds));
+    report.insert(QStringLiteral("totalForwardedPps"), perSecond(totalForwarded, seconds));
+    report.insert(QStringLiteral("forwardedPpsPerShard"), perSecond(totalForwarded, seconds) / qMax(1, server.shardCount()));
+    report.insert(QStringLiteral("results"), results);
+    return report;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QJsonObject>
+
+#include "RelayServer.h"
+
+struct RelayLoadGenConfig
+{
+    int channels = 64;
+    int listenersPerChannel = 4;
+    int durationSec = 5;
+    // AUDIO datagrams per second per talker; 0 sends as fast as possible.
+    int talkerRate = 50;
+    int payloadBytes = 8;
+    int senderThreads = 2;
+};
+
+// Drives a started RelayServer from loopback sockets with one talker and
+// listenersPerChannel listeners per channel, and reports the packet rates
+// each shard sustained.
+QJsonObject runRelayLoadGen(RelayServer& server,
+                            const RelayConfig& relayConfig,
+                            const RelayLoadGenConfig& config);
@@ -0,0 +1,125 @@
+#include "RelayServer.h"
+
+#include <QThread>
+#include <linux/filter.h>
+#include <sys/socket.h>
+
+RelayServer::RelayServer(const RelayConfig& config)
+    : m_config(config)
+{
+    m_config.shards = qBound(1, m_config.shards, kMaxShards);
+    sigemptyset(&m_stopSignals);
+    sigaddset(&m_stopSignals, SIGINT);
+    sigaddset(&m_stopSignals, SIGTERM);
+}
+
+RelayServer::~RelayServer()
+{
+    stop();
+    qDeleteAll(m_shards);
+}
+
+bool RelayServer::open(QString* error)
+{
+    for (int i = 0; i < m_config.shards; ++i)
+    {
+        auto* shard = new RelayShard(i, m_config);
+        m_shards.append(shard);
+        if (!shard->open(error))
+            return false;
+    }
+    for (RelayShard* shard : std::as_const(m_shards))
+        shard->setPeers(m_shards);
+
+    if (m_shards.size() > 1 && m_config.channelSteering)
+        m_channelSteeringActive = attachChannelSteering();
+    return true;
+}
+
+bool RelayServer::attachChannelSteering()
+{
+    // A reuseport program sees the UDP payload; the channel id is the
+    // big-endian word at offset 4. Same hash as RelayShard::ownerOf(), and
+    // socket indices follow bind order, which is shard order.
+    sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 4),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, RelayShard::kChannelHashMultiplier),
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<quint32>(m_shards.size())),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    sock_fprog program {};
+    program.len = static_cast<unsigned short>(sizeof(code) / sizeof(code[0]));
+    program.filter = code;
+    return ::setsockopt(m_shards.constFirst()->socketFd(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                        &program, sizeof(program)) == 0;
+}
+
+void RelayServer::start()
+{
+    if (!m_threads.isEmpty())
+        return;
+
+    for (RelayShard* shard : std::as_const(m_shards))
+    {
+        QThread* thread = QThread::create([shard]() { shard->run(); });
+        thread->setObjectName(QStringLiteral("IncomUdonRelay%1").arg(m_threads.size()));
+        m_threads.append(thread);
+        thread->start();
+    }
+}
+
+void RelayServer::stop()
+{
+    if (m_threads.isEmpty())
+        return;
+
+    for (RelayShard* shard : std::as_const(m_shards))
+        shard->stop();
+    for (QThread* thread : std::as_const(m_threads))
+        thread->wait();
+    qDeleteAll(m_threads);
+    m_threads.clear();
+}
+
+int RelayServer::run()
+{
+    // Blocked before the shard threads exist so only sigwait() sees them.
+    // Callers that use start()/stop() directly keep the default handlers.
+    ::pthread_sigmask(SIG_BLOCK, &m_stopSignals, nullptr);
+    start();
+    int received = 0;
+    ::sigwait(&m_stopSignals, &received);
+    stop();
+    return 0;
+}
+
+int RelayServer::shardCount() const
+{
+    return static_cast<int>(m_shards.size());
+}
+
+bool RelayServer::channelSteeringActive() const
+{
+    return m_channelSteeringActive;
+}
+
+RelayStats RelayServer::shardStats(int index) const
+{
+    return m_shards.at(index)->stats();
+}
+
+RelayStats RelayServer::stats() const
+{
+    RelayStats total;
+    for (const RelayShard* shard : m_shards)
+    {
+        const RelayStats stats = shard->stats();
+        total.datagramsReceived += stats.datagramsReceived;
+        total.datagramsForwarded += stats.datagramsForwarded;
+        total.controlPacketsSent += stats.controlPacketsSent;
+        total.datagramsHandedOff += stats.datagramsHandedOff;
+        total.handoffDrops += stats.handoffDrops;
+    }
+    return total;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <csignal>
+
+#include "RelayShard.h"
+
+class QThread;
+
+// Runs RelayConfig::shards workers on one port. Each shard binds its own
+// SO_REUSEPORT socket and owns the channels that hash to it.
+class RelayServer
+{
+public:
+    static constexpr int kMaxShards = 64;
+
+    explicit RelayServer(const RelayConfig& config);
+    ~RelayServer();
+
+    bool open(QString* error);
+    void start();
+    void stop();
+    // Starts the shards and blocks until SIGINT or SIGTERM.
+    int run();
+
+    int shardCount() const;
+    bool channelSteeringActive() const;
+    RelayStats shardStats(int index) const;
+    RelayStats stats() const;
+
+private:
+    bool attachChannelSteering();
+
+    RelayConfig m_config;
+    QList<RelayShard*> m_shards;
+    QList<QThread*> m_threads;
+    sigset_t m_stopSignals;
+    bool m_channelSteeringActive = false;
+};
@@ -0,0 +1,555 @@
+#include "RelayShard.h"
+
+#include <QtEndian>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static constexpr int kHousekeepingIntervalMs = 1000;
+static constexpr int kSocketBufferBytes = 4 * 1024 * 1024;
+static constexpr int kHandoffCapacity = 1024;
+
+static bool sameAddress(const sockaddr_in& a, const sockaddr_in& b)
+{
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+static QByteArray u32Payload(quint32 value)
+{
+    QByteArray payload(4, Qt::Uninitialized);
+    qToBigEndian(value, reinterpret_cast<uchar*>(payload.data()));
+    return payload;
+}
+
+RelayShard::RelayShard(int index, const RelayConfig& config)
+    : m_index(index),
+      m_config(config),
+      m_handoff(kHandoffCapacity)
+{
+    m_packetizer.setSenderId(0);
+}
+
+RelayShard::~RelayShard()
+{
+    if (m_wakeFd >= 0)
+        ::close(m_wakeFd);
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+    if (m_socketFd >= 0)
+        ::close(m_socketFd);
+}
+
+int RelayShard::ownerOf(quint32 channelId, int shardCount)
+{
+    return static_cast<int>(((channelId * kChannelHashMultiplier) >> 16) % static_cast<quint32>(shardCount));
+}
+
+bool RelayShard::open(QString* error)
+{
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_config.port);
+    if (::inet_pton(AF_INET, m_config.bindAddress.toLatin1().constData(), &addr.sin_addr) != 1)
+    {
+        *error = QStringLiteral("Invalid bind address: %1").arg(m_config.bindAddress);
+        return false;
+    }
+
+    m_socketFd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_socketFd < 0)
+    {
+        *error = QStringLiteral("socket: %1").arg(QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+    const int reusePort = 1;
+    ::setsockopt(m_socketFd, SOL_SOCKET, SO_REUSEPORT, &reusePort, sizeof(reusePort));
+    // Fan-out turns one datagram into one per member; give bursts room.
+    const int bufferBytes = kSocketBufferBytes;
+    ::setsockopt(m_socketFd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+    ::setsockopt(m_socketFd, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+    if (::bind(m_socketFd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        *error = QStringLiteral("bind %1:%2: %3")
+                     .arg(m_config.bindAddress)
+                     .arg(m_config.port)
+                     .arg(QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+
+    m_wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0 || m_wakeFd < 0)
+    {
+        *error = QStringLiteral("epoll/eventfd: %1").arg(QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = m_socketFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_socketFd, &event);
+    event.data.fd = m_wakeFd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+    for (int i = 0; i < kRecvBatch; ++i)
+    {
+        m_recvIov[i].iov_base = m_recvBuffers[i].data();
+        m_recvIov[i].iov_len = kMaxDatagramBytes;
+    }
+    m_clock.start();
+    return true;
+}
+
+int RelayShard::socketFd() const
+{
+    return m_socketFd;
+}
+
+void RelayShard::setPeers(const QList<RelayShard*>& peers)
+{
+    m_peers = peers;
+}
+
+void RelayShard::run()
+{
+    epoll_event events[4];
+    while (!m_stopRequested.load(std::memory_order_acquire))
+    {
+        const int ready = ::epoll_wait(m_epollFd, events, 4, kHousekeepingIntervalMs);
+        if (ready < 0 && errno != EINTR)
+            return;
+
+        m_nowMs = m_clock.elapsed();
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[i].data.fd == m_wakeFd)
+            {
+                quint64 value = 0;
+                if (::read(m_wakeFd, &value, sizeof(value)) < 0)
+                    value = 0;
+                // Cleared before draining so a push racing with us re-arms it.
+                // The fence pairs with the one in wakePeers(): either the
+                // producer sees the cleared flag or we see its cell.
+                m_wakePending.store(false, std::memory_order_release);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            else if (events[i].data.fd == m_socketFd)
+            {
+                drainSocket();
+            }
+        }
+        // Every pass, including the housekeeping timeout, so a missed
+        // wakeup only delays a handed-off datagram by one interval.
+        drainHandoff();
+
+        if (m_nowMs - m_lastHousekeepingMs >= kHousekeepingIntervalMs)
+        {
+            m_lastHousekeepingMs = m_nowMs;
+            expireIdle();
+        }
+    }
+}
+
+void RelayShard::stop()
+{
+    m_stopRequested.store(true, std::memory_order_release);
+    const quint64 one = 1;
+    if (::write(m_wakeFd, &one, sizeof(one)) < 0)
+        return;
+}
+
+RelayStats RelayShard::stats() const
+{
+    RelayStats stats;
+    stats.datagramsReceived = m_datagramsReceived.load(std::memory_order_relaxed);
+    stats.datagramsForwarded = m_datagramsForwarded.load(std::memory_order_relaxed);
+    stats.controlPacketsSent = m_controlPacketsSent.load(std::memory_order_relaxed);
+    stats.datagramsHandedOff = m_datagramsHandedOff.load(std::memory_order_relaxed);
+    stats.handoffDrops = m_handoffDrops.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void RelayShard::drainSocket()
+{
+    for (;;)
+    {
+        for (int i = 0; i < kRecvBatch; ++i)
+        {
+            m_recvMessages[i] = mmsghdr {};
+            m_recvMessages[i].msg_hdr.msg_name = &m_recvAddrs[i];
+            m_recvMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            m_recvMessages[i].msg_hdr.msg_iov = &m_recvIov[i];
+            m_recvMessages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const int received = ::recvmmsg(m_socketFd, m_recvMessages.data(), kRecvBatch, MSG_DONTWAIT, nullptr);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return;
+
+        m_datagramsReceived.fetch_add(static_cast<quint64>(received), std::memory_order_relaxed);
+        for (int i = 0; i < received; ++i)
+        {
+            const msghdr& message = m_recvMessages[i].msg_hdr;
+            if (message.msg_namelen != sizeof(sockaddr_in) || (message.msg_flags & MSG_TRUNC))
+                continue;
+            handleDatagram(m_recvBuffers[i].data(),
+                           static_cast<int>(m_recvMessages[i].msg_len),
+                           m_recvAddrs[i]);
+        }
+        flushSends();
+        wakePeers();
+
+        if (received < kRecvBatch)
+            return;
+    }
+}
+
+void RelayShard::drainHandoff()
+{
+    for (;;)
+    {
+        int count = 0;
+        while (count < kRecvBatch)
+        {
+            const HandoffQueue::Datagram* datagram = m_handoff.peek(count);
+            if (!datagram)
+                break;
+            handleDatagram(datagram->data, datagram->size, datagram->from);
+            ++count;
+        }
+        flushSends();
+        m_handoff.release(count);
+        if (count < kRecvBatch)
+            return;
+    }
+}
+
+void RelayShard::wakePeers()
+{
+    if (m_peersToWake == 0)
+        return;
+    // Orders the handoff pushes before the flag exchange below.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (int i = 0; m_peersToWake != 0; ++i, m_peersToWake >>= 1)
+    {
+        if (!(m_peersToWake & 1))
+            continue;
+        RelayShard* peer = m_peers.at(i);
+        if (!peer->m_wakePending.exchange(true, std::memory_order_acq_rel))
+        {
+            const quint64 one = 1;
+            if (::write(peer->m_wakeFd, &one, sizeof(one)) < 0)
+                peer->m_wakePending.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void RelayShard::handleDatagram(const uchar* data, int size, const sockaddr_in& from)
+{
+    Proto::PacketHeader header;
+    if (Proto::readHeader(data, size, header) < 0 ||
+        header.version != Proto::PROTOCOL_VERSION ||
+        header.senderId == 0)
+    {
+        return;
+    }
+
+    const int owner = m_peers.size() > 1 ? ownerOf(header.channelId, static_cast<int>(m_peers.size())) : m_index;
+    if (owner != m_index)
+    {
+        if (m_peers.at(owner)->m_handoff.push(data, size, from))
+        {
+            m_peersToWake |= quint64(1) << owner;
+            m_datagramsHandedOff.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            m_handoffDrops.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    routeDatagram(header, data, size, from);
+}
+
+void RelayShard::routeDatagram(const Proto::PacketHeader& header,
+                               const uchar* data,
+                               int size,
+                               const sockaddr_in& from)
+{
+    if (header.type == Proto::PKT_JOIN)
+    {
+        const bool legacy = header.headerLen == Proto::LEGACY_FIXED_HEADER_SIZE ||
+                            header.headerLen == Proto::LEGACY_FIXED_HEADER_SIZE + Proto::SECURITY_HEADER_SIZE;
+        handleJoin(header, from, legacy);
+        return;
+    }
+
+    const auto channelIt = m_channels.find(header.channelId);
+    if (channelIt == m_channels.end())
+        return;
+    Channel& channel = channelIt.value();
+    Member* member = findMember(channel, header.senderId, from);
+    if (!member)
+        return;
+    member->lastSeenMs = m_nowMs;
+
+    switch (header.type)
+    {
+    case Proto::PKT_AUDIO:
+    case Proto::PKT_FEC:
+        if (talkerIndex(channel, header.senderId) >= 0)
+            queueFanOut(channel, header.senderId, data, size);
+        break;
+    case Proto::PKT_CODEC_CONFIG:
+    case Proto::PKT_KEY_EXCHANGE:
+        queueFanOut(channel, header.senderId, data, size);
+        break;
+    case Proto::PKT_PTT_ON:
+        handleTalkRequest(channel, *member);
+        break;
+    case Proto::PKT_PTT_OFF:
+        releaseTalker(channel, header.senderId);
+        break;
+    case Proto::PKT_KEEPALIVE:
+        // Echoed so the client sees server activity while the channel is quiet.
+        sendControl(channel, *member, Proto::PKT_KEEPALIVE, QByteArray());
+        break;
+    case Proto::PKT_LEAVE:
+        handleLeave(channel, header.senderId);
+        if (channel.members.isEmpty())
+            m_channels.erase(channelIt);
+        break;
+    default:
+        break;
+    }
+}
+
+void RelayShard::handleJoin(const Proto::PacketHeader& header, const sockaddr_in& from, bool legacy)
+{
+    Channel& channel = m_channels[header.channelId];
+    channel.id = header.channelId;
+
+    Member* member = nullptr;
+    for (Member& candidate : channel.members)
+    {
+        if (candidate.senderId == header.senderId)
+        {
+            member = &candidate;
+            break;
+        }
+    }
+
+    if (!member)
+    {
+        Member joined;
+        joined.addr = from;
+        joined.senderId = header.senderId;
+        joined.legacy = legacy;
+        channel.members.append(joined);
+        member = &channel.members.last();
+    }
+    else
+    {
+        // Clients send a legacy JOIN right behind every modern one; only a
+        // client that moved or speaks legacy alone is answered in legacy.
+        const bool moved = !sameAddress(member->addr, from);
+        if (legacy && !moved && !member->legacy)
+        {
+            member->lastSeenMs = m_nowMs;
+            return;
+        }
+        member->addr = from;
+        member->legacy = legacy;
+    }
+    member->lastSeenMs = m_nowMs;
+
+    sendServerConfig(channel, *member);
+    for (const Talker& talker : std::as_const(channel.talkers))
+        sendControl(channel, *member, Proto::PKT_TALK_GRANT, u32Payload(talker.senderId));
+}
+
+void RelayShard::handleLeave(Channel& channel, quint32 senderId)
+{
+    releaseTalker(channel, senderId);
+    for (qsizetype i = 0; i < channel.members.size(); ++i)
+    {
+        if (channel.members.at(i).senderId == senderId)
+        {
+            channel.members.removeAt(i);
+            return;
+        }
+    }
+}
+
+void RelayShard::handleTalkRequest(Channel& channel, const Member& member)
+{
+    if (talkerIndex(channel, member.senderId) >= 0)
+    {
+        sendControl(channel, member, Proto::PKT_TALK_GRANT, u32Payload(member.senderId));
+        return;
+    }
+
+    if (channel.talkers.size() >= qMax(1, m_config.maxActiveTalkers))
+    {
+        sendControl(channel, member, Proto::PKT_TALK_DENY, u32Payload(channel.talkers.constFirst().senderId));
+        return;
+    }
+
+    channel.talkers.append(Talker{member.senderId, m_nowMs});
+    broadcastControl(channel, Proto::PKT_TALK_GRANT, u32Payload(member.senderId));
+}
+
+void RelayShard::releaseTalker(Channel& channel, quint32 senderId)
+{
+    const int index = talkerIndex(channel, senderId);
+    if (index < 0)
+        return;
+
+    channel.talkers.removeAt(index);
+    broadcastControl(channel, Proto::PKT_TALK_RELEASE, u32Payload(senderId));
+}
+
+void RelayShard::expireIdle()
+{
+    const qint64 memberTimeoutMs = static_cast<qint64>(m_config.memberTimeoutSec) * 1000;
+    const qint64 talkTimeoutMs = static_cast<qint64>(m_config.talkTimeoutSec) * 1000;
+    for (auto it = m_channels.begin(); it != m_channels.end();)
+    {
+        Channel& channel = it.value();
+        if (talkTimeoutMs > 0)
+        {
+            for (qsizetype i = channel.talkers.size() - 1; i >= 0; --i)
+            {
+                if (m_nowMs - channel.talkers.at(i).grantedMs > talkTimeoutMs)
+                    releaseTalker(channel, channel.talkers.at(i).senderId);
+            }
+        }
+        for (qsizetype i = channel.members.size() - 1; i >= 0; --i)
+        {
+            if (m_nowMs - channel.members.at(i).lastSeenMs > memberTimeoutMs)
+                handleLeave(channel, channel.members.at(i).senderId);
+        }
+
+        if (channel.members.isEmpty())
+            it = m_channels.erase(it);
+        else
+            ++it;
+    }
+}
+
+RelayShard::Member* RelayShard::findMember(Channel& channel, quint32 senderId, const sockaddr_in& from)
+{
+    for (Member& member : channel.members)
+    {
+        if (member.senderId == senderId)
+            return sameAddress(member.addr, from) ? &member : nullptr;
+    }
+    return nullptr;
+}
+
+int RelayShard::talkerIndex(const Channel& channel, quint32 senderId)
+{
+    for (qsizetype i = 0; i < channel.talkers.size(); ++i)
+    {
+        if (channel.talkers.at(i).senderId == senderId)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void RelayShard::queueFanOut(const Channel& channel, quint32 senderId, const uchar* data, int size)
+{
+    for (const Member& member : channel.members)
+    {
+        if (member.senderId == senderId)
+            continue;
+        if (m_sendCount == kSendBatch)
+            flushSends();
+
+        const int slot = m_sendCount++;
+        m_sendAddrs[slot] = member.addr;
+        m_sendIov[slot].iov_base = const_cast<uchar*>(data);
+        m_sendIov[slot].iov_len = static_cast<size_t>(size);
+        m_sendMessages[slot] = mmsghdr {};
+        m_sendMessages[slot].msg_hdr.msg_name = &m_sendAddrs[slot];
+        m_sendMessages[slot].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        m_sendMessages[slot].msg_hdr.msg_iov = &m_sendIov[slot];
+        m_sendMessages[slot].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+void RelayShard::flushSends()
+{
+    int offset = 0;
+    while (offset < m_sendCount)
+    {
+        const int sent = ::sendmmsg(m_socketFd,
+                                    m_sendMessages.data() + offset,
+                                    static_cast<unsigned int>(m_sendCount - offset),
+                                    0);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        // A full socket buffer drops the rest, as a congested link would.
+        if (sent <= 0)
+            break;
+        offset += sent;
+        m_datagramsForwarded.fetch_add(static_cast<quint64>(sent), std::memory_order_relaxed);
+    }
+    m_sendCount = 0;
+}
+
+QByteArray RelayShard::controlPacket(quint32 channelId,
+                                      Proto::PacketType type,
+                                      const QByteArray& payload,
+                                      bool legacy)
+{
+    m_packetizer.setChannelId(channelId);
+    return legacy ? m_packetizer.packPlainLegacy(type, payload)
+                  : m_packetizer.packPlain(type, payload);
+}
+
+void RelayShard::sendControl(const QByteArray& packet, const sockaddr_in& to)
+{
+    // Keep control packets ordered behind audio already queued.
+    flushSends();
+    ::sendto(m_socketFd, packet.constData(), static_cast<size_t>(packet.size()), 0,
+             reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+    m_controlPacketsSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RelayShard::sendControl(const Channel& channel,
+                              const Member& member,
+                              Proto::PacketType type,
+                              const QByteArray& payload)
+{
+    sendControl(controlPacket(channel.id, type, payload, member.legacy), member.addr);
+}
+
+void RelayShard::broadcastControl(const Channel& channel, Proto::PacketType type, const QByteArray& payload)
+{
+    QByteArray packet;
+    QByteArray legacyPacket;
+    for (const Member& member : channel.members)
+    {
+        QByteArray& encoded = member.legacy ? legacyPacket : packet;
+        if (encoded.isEmpty())
+            encoded = controlPacket(channel.id, type, payload, member.legacy);
+        sendControl(encoded, member.addr);
+    }
+}
+
+void RelayShard::sendServerConfig(const Channel& channel, const Member& member)
+{
+    const int maxTalkers = qBound(1, m_config.maxActiveTalkers, 255);
+    QByteArray payload(4, Qt::Uninitialized);
+    qToBigEndian(static_cast<quint16>(qBound(0, m_config.talkTimeoutSec, 0xffff)),
+                 reinterpret_cast<uchar*>(payload.data()));
+    payload[2] = static_cast<char>(maxTalkers > 1 ? 0x01 : 0x00);
+    payload[3] = static_cast<char>(maxTalkers);
+    sendControl(channel, member, Proto::PKT_SERVER_CONFIG, payload);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "HandoffQueue.h"
+#include "net/Packetizer.h"
+#include "net/packet.h"
+
+struct RelayConfig
+{
+    QString bindAddress = QStringLiteral("127.0.0.1");
+    quint16 port = 50000;
+    // Same meaning as the client's server multi-talk settings: more than
+    // one concurrent talker turns multi-talk on.
+    int maxActiveTalkers = 1;
+    int talkTimeoutSec = 60;
+    int memberTimeoutSec = 30;
+    int shards = 1;
+    // Lets the kernel deliver each datagram to the socket of the shard
+    // owning its channel; the handoff queues only catch the rest.
+    bool channelSteering = true;
+};
+
+struct RelayStats
+{
+    quint64 datagramsReceived = 0;
+    quint64 datagramsForwarded = 0;
+    quint64 controlPacketsSent = 0;
+    quint64 datagramsHandedOff = 0;
+    quint64 handoffDrops = 0;
+};
+
+// One relay worker: a SO_REUSEPORT socket, its own epoll loop and the
+// channels hashed to it. Channel state is only touched by the owning
+// shard; datagrams that arrive elsewhere are handed over. AUDIO/FEC/
+// CODEC_CONFIG datagrams are forwarded byte for byte; the relay never
+// holds the room key.
+class RelayShard
+{
+public:
+    // Shared with the kernel steering program in RelayServer.
+    static constexpr quint32 kChannelHashMultiplier = 0x9e3779b1u;
+
+    RelayShard(int index, const RelayConfig& config);
+    ~RelayShard();
+
+    static int ownerOf(quint32 channelId, int shardCount);
+
+    bool open(QString* error);
+    int socketFd() const;
+    void setPeers(const QList<RelayShard*>& peers);
+
+    // Shard thread.
+    void run();
+    // Any thread.
+    void stop();
+    RelayStats stats() const;
+
+private:
+    struct Member
+    {
+        sockaddr_in addr;
+        quint32 senderId = 0;
+        qint64 lastSeenMs = 0;
+        bool legacy = false;
+    };
+
+    struct Talker
+    {
+        quint32 senderId = 0;
+        qint64 grantedMs = 0;
+    };
+
+    struct Channel
+    {
+        quint32 id = 0;
+        QList<Member> members;
+        QList<Talker> talkers;
+    };
+
+    static constexpr int kRecvBatch = 32;
+    static constexpr int kSendBatch = 256;
+    static constexpr int kMaxDatagramBytes = HandoffQueue::kMaxDatagramBytes;
+
+    void drainSocket();
+    void drainHandoff();
+    void wakePeers();
+    void handleDatagram(const uchar* data, int size, const sockaddr_in& from);
+    void routeDatagram(const Proto::PacketHeader& header,
+                       const uchar* data,
+                       int size,
+                       const sockaddr_in& from);
+    void handleJoin(const Proto::PacketHeader& header, const sockaddr_in& from, bool legacy);
+    void handleLeave(Channel& channel, quint32 senderId);
+    void handleTalkRequest(Channel& channel, const Member& member);
+    void releaseTalker(Channel& channel, quint32 senderId);
+    void expireIdle();
+
+    Member* findMember(Channel& channel, quint32 senderId, const sockaddr_in& from);
+    static int talkerIndex(const Channel& channel, quint32 senderId);
+
+    void queueFanOut(const Channel& channel, quint32 senderId, const uchar* data, int size);
+    void flushSends();
+    QByteArray controlPacket(quint32 channelId,
+                             Proto::PacketType type,
+                             const QByteArray& payload,
+                             bool legacy);
+    void sendControl(const QByteArray& packet, const sockaddr_in& to);
+    void sendControl(const Channel& channel,
+                     const Member& member,
+                     Proto::PacketType type,
+                     const QByteArray& payload);
+    void broadcastControl(const Channel& channel, Proto::PacketType type, const QByteArray& payload);
+    void sendServerConfig(const Channel& channel, const Member& member);
+
+    const int m_index;
+    RelayConfig m_config;
+    int m_socketFd = -1;
+    int m_epollFd = -1;
+    int m_wakeFd = -1;
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<bool> m_wakePending{false};
+
+    QList<RelayShard*> m_peers;
+    HandoffQueue m_handoff;
+    quint64 m_peersToWake = 0;
+
+    // Written by the shard thread only; read by stats().
+    std::atomic<quint64> m_datagramsReceived{0};
+    std::atomic<quint64> m_datagramsForwarded{0};
+    std::atomic<quint64> m_controlPacketsSent{0};
+    std::atomic<quint64> m_datagramsHandedOff{0};
+    std::atomic<quint64> m_handoffDrops{0};
+
+    QElapsedTimer m_clock;
+    qint64 m_nowMs = 0;
+    qint64 m_lastHousekeepingMs = 0;
+
+    QHash<quint32, Channel> m_channels;
+    // Builds the relay's own control packets; sender id 0 marks the server.
+    Packetizer m_packetizer;
+
+    std::array<std::array<uchar, kMaxDatagramBytes>, kRecvBatch> m_recvBuffers;
+    std::array<sockaddr_in, kRecvBatch> m_recvAddrs;
+    std::array<iovec, kRecvBatch> m_recvIov;
+    std::array<mmsghdr, kRecvBatch> m_recvMessages;
+
+    // Fan-out entries point into m_recvBuffers or handoff cells, so they
+    // are flushed before either is reused.
+    std::array<sockaddr_in, kSendBatch> m_sendAddrs;
+    std::array<iovec, kSendBatch> m_sendIov;
+    std::array<mmsghdr, kSendBatch> m_sendMessages;
+    int m_sendCount = 0;
+};
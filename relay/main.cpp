@@ -0,0 +1,143 @@
+// Headless reference relay. Speaks the client protocol on one UDP port so
+// the app, benchmarks and load tests can run against localhost. With
+// --loadgen it instead drives itself from loopback clients for a while and
+// prints the packet rates each shard sustained as JSON.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonObject>
+#include <QThread>
+#include <cstdio>
+#include <memory>
+
+#include "RelayLoadGen.h"
+#include "RelayServer.h"
+#include "tools/ToolReport.h"
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("IncomUdonRelay"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("IncomUdon reference relay server"));
+    parser.addHelpOption();
+    const QCommandLineOption bindOption(QStringLiteral("bind"),
+                                        QStringLiteral("IPv4 address to listen on (default 127.0.0.1)."),
+                                        QStringLiteral("address"),
+                                        QStringLiteral("127.0.0.1"));
+    const QCommandLineOption portOption(QStringLiteral("port"),
+                                        QStringLiteral("UDP port (default 50000)."),
+                                        QStringLiteral("port"),
+                                        QStringLiteral("50000"));
+    const QCommandLineOption talkersOption(QStringLiteral("max-talkers"),
+                                           QStringLiteral("Concurrent talkers per channel, 1-255 (default 1)."),
+                                           QStringLiteral("count"),
+                                           QStringLiteral("1"));
+    const QCommandLineOption talkTimeoutOption(QStringLiteral("talk-timeout"),
+                                               QStringLiteral("Seconds before a talker is released, 0 = never (default 60)."),
+                                               QStringLiteral("seconds"),
+                                               QStringLiteral("60"));
+    const QCommandLineOption memberTimeoutOption(QStringLiteral("member-timeout"),
+                                                 QStringLiteral("Seconds of silence before a member is dropped (default 30)."),
+                                                 QStringLiteral("seconds"),
+                                                 QStringLiteral("30"));
+    const QCommandLineOption shardsOption(QStringLiteral("shards"),
+                                          QStringLiteral("Worker threads, each with its own socket (default: CPU count)."),
+                                          QStringLiteral("count"),
+                                          QString::number(QThread::idealThreadCount()));
+    const QCommandLineOption noSteeringOption(QStringLiteral("no-steering"),
+                                              QStringLiteral("Let the kernel spread datagrams and hand them to the owning shard."));
+    const QCommandLineOption loadGenOption(QStringLiteral("loadgen"),
+                                           QStringLiteral("Run the built-in load generator against this relay and exit."));
+    const QCommandLineOption channelsOption(QStringLiteral("loadgen-channels"),
+                                            QStringLiteral("Load generator channels (default 64)."),
+                                            QStringLiteral("count"),
+                                            QStringLiteral("64"));
+    const QCommandLineOption listenersOption(QStringLiteral("loadgen-listeners"),
+                                             QStringLiteral("Listeners per channel besides the talker (default 4)."),
+                                             QStringLiteral("count"),
+                                             QStringLiteral("4"));
+    const QCommandLineOption rateOption(QStringLiteral("loadgen-rate"),
+                                        QStringLiteral("AUDIO datagrams per second per talker, 0 = flood (default 50)."),
+                                        QStringLiteral("pps"),
+                                        QStringLiteral("50"));
+    const QCommandLineOption sendersOption(QStringLiteral("loadgen-senders"),
+                                           QStringLiteral("Load generator sender threads (default 2)."),
+                                           QStringLiteral("count"),
+                                           QStringLiteral("2"));
+    const QCommandLineOption durationOption(QStringLiteral("loadgen-duration"),
+                                            QStringLiteral("Measured seconds (default 5)."),
+                                            QStringLiteral("seconds"),
+                                            QStringLiteral("5"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("Load generator JSON file (default stdout)."),
+                                          QStringLiteral("file"));
+    parser.addOption(bindOption);
+    parser.addOption(portOption);
+    parser.addOption(talkersOption);
+    parser.addOption(talkTimeoutOption);
+    parser.addOption(memberTimeoutOption);
+    parser.addOption(shardsOption);
+    parser.addOption(noSteeringOption);
+    parser.addOption(loadGenOption);
+    parser.addOption(channelsOption);
+    parser.addOption(listenersOption);
+    parser.addOption(rateOption);
+    parser.addOption(sendersOption);
+    parser.addOption(durationOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    RelayConfig config;
+    config.bindAddress = parser.value(bindOption);
+    config.port = static_cast<quint16>(parser.value(portOption).toUInt());
+    config.maxActiveTalkers = qBound(1, parser.value(talkersOption).toInt(), 255);
+    config.talkTimeoutSec = qMax(0, parser.value(talkTimeoutOption).toInt());
+    config.memberTimeoutSec = qMax(1, parser.value(memberTimeoutOption).toInt());
+    config.shards = qBound(1, parser.value(shardsOption).toInt(), RelayServer::kMaxShards);
+    config.channelSteering = !parser.isSet(noSteeringOption);
+
+    auto server = std::make_unique<RelayServer>(config);
+    QString error;
+    if (!server->open(&error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
+    if (parser.isSet(loadGenOption))
+    {
+        RelayLoadGenConfig loadGen;
+        loadGen.channels = qMax(1, parser.value(channelsOption).toInt());
+        loadGen.listenersPerChannel = qMax(1, parser.value(listenersOption).toInt());
+        loadGen.talkerRate = qMax(0, parser.value(rateOption).toInt());
+        loadGen.senderThreads = qMax(1, parser.value(sendersOption).toInt());
+        loadGen.durationSec = qMax(1, parser.value(durationOption).toInt());
+
+        QJsonObject root = ToolReport::header(QStringLiteral("incomudon_relay"));
+        server->start();
+        const QJsonObject results = runRelayLoadGen(*server, config, loadGen);
+        server->stop();
+        for (auto it = results.begin(); it != results.end(); ++it)
+            root.insert(it.key(), it.value());
+
+        return ToolReport::write(root, parser.value(outputOption));
+    }
+
+    std::fprintf(stderr, "Relay listening on %s:%u with %d shard(s)%s\n",
+                 qPrintable(config.bindAddress),
+                 config.port,
+                 server->shardCount(),
+                 server->channelSteeringActive() ? ", kernel channel steering" : "");
+    const int result = server->run();
+
+    const RelayStats stats = server->stats();
+    std::fprintf(stderr, "received=%llu forwarded=%llu control=%llu handedOff=%llu handoffDrops=%llu\n",
+                 static_cast<unsigned long long>(stats.datagramsReceived),
+                 static_cast<unsigned long long>(stats.datagramsForwarded),
+                 static_cast<unsigned long long>(stats.controlPacketsSent),
+                 static_cast<unsigned long long>(stats.datagramsHandedOff),
+                 static_cast<unsigned long long>(stats.handoffDrops));
+    return result;
+}
@@ -0,0 +1,293 @@
+// Replays a datagram capture (INCOMUDON_CAPTURE) through the client's RX
+// path: ChannelManager parses, decrypts, FEC-repairs, buffers, decodes and
+// mixes exactly as it would live, while this tool plays the audio sink and
+// pulls one playout frame per frame period on the capture's own clock. By
+// default it runs as fast as possible; --realtime paces it to the wall
+// clock. The mixed output goes to a WAV file and the RX-path cost to JSON.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonObject>
+#include <QList>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+#include "codec/Codec2Wrapper.h"
+#include "core/ChannelManager.h"
+#include "crypto/AeadCipher.h"
+#include "crypto/KeyExchange.h"
+#include "net/DatagramCapture.h"
+#include "net/JitterBuffer.h"
+#include "net/NetworkImpairment.h"
+#include "net/Packetizer.h"
+#include "net/udptransport.h"
+#include "tools/ToolReport.h"
+#include "tools/WavFile.h"
+
+namespace {
+constexpr int kKeyTimeoutMs = 2000;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName(QStringLiteral("FriedOudon"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("friedoudon.com"));
+    QCoreApplication::setApplicationName(QStringLiteral("IncomUdonCaptureReplay"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("IncomUdon capture replayer"));
+    parser.addHelpOption();
+    const QCommandLineOption inputOption(QStringLiteral("input"),
+                                         QStringLiteral("Capture file written by INCOMUDON_CAPTURE."),
+                                         QStringLiteral("file"));
+    const QCommandLineOption wavOption(QStringLiteral("wav"),
+                                       QStringLiteral("Mixed playout WAV to write."),
+                                       QStringLiteral("file"));
+    const QCommandLineOption passwordOption(QStringLiteral("password"),
+                                            QStringLiteral("Channel password used when capturing."),
+                                            QStringLiteral("password"));
+    const QCommandLineOption channelOption(QStringLiteral("channel"),
+                                           QStringLiteral("Channel id (default: from the first datagram)."),
+                                           QStringLiteral("id"));
+    const QCommandLineOption legacyCryptoOption(QStringLiteral("legacy-crypto"),
+                                                QStringLiteral("The capture used the legacy cipher."));
+    const QCommandLineOption noFecOption(QStringLiteral("no-fec"),
+                                         QStringLiteral("Ignore FEC parity, unlike the app."));
+    const QCommandLineOption realtimeOption(QStringLiteral("realtime"),
+                                            QStringLiteral("Pace the replay to the wall clock."));
+    const QCommandLineOption netemOption(QStringLiteral("netem"),
+                                         QStringLiteral("Impair the captured traffic (INCOMUDON_NETEM format, rx side)."),
+                                         QStringLiteral("spec"));
+    const QCommandLineOption tailOption(QStringLiteral("tail-ms"),
+                                        QStringLiteral("Playout after the last datagram (default 1000)."),
+                                        QStringLiteral("ms"),
+                                        QStringLiteral("1000"));
+    const QCommandLineOption codec2Option(QStringLiteral("codec2-lib"),
+                                          QStringLiteral("Path to the codec2 runtime library."),
+                                          QStringLiteral("path"));
+    const QCommandLineOption opusOption(QStringLiteral("opus-lib"),
+                                        QStringLiteral("Path to the opus runtime library."),
+                                        QStringLiteral("path"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("JSON report file (default stdout)."),
+                                          QStringLiteral("file"));
+    parser.addOption(inputOption);
+    parser.addOption(wavOption);
+    parser.addOption(passwordOption);
+    parser.addOption(channelOption);
+    parser.addOption(legacyCryptoOption);
+    parser.addOption(noFecOption);
+    parser.addOption(realtimeOption);
+    parser.addOption(netemOption);
+    parser.addOption(tailOption);
+    parser.addOption(codec2Option);
+    parser.addOption(opusOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    if (!parser.isSet(inputOption) || !parser.isSet(wavOption))
+    {
+        std::fprintf(stderr, "--input and --wav are required\n");
+        return 1;
+    }
+
+    QString error;
+    DatagramCaptureReader reader;
+    if (!reader.open(parser.value(inputOption), &error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    QList<CapturedDatagram> datagrams;
+    CapturedDatagram datagram;
+    while (reader.next(&datagram))
+        datagrams.append(datagram);
+    if (datagrams.isEmpty())
+    {
+        std::fprintf(stderr, "The capture holds no datagrams\n");
+        return 1;
+    }
+
+    Packetizer packetizer;
+    quint32 channelId = parser.value(channelOption).toUInt();
+    if (channelId == 0)
+    {
+        ParsedPacket parsed;
+        for (const CapturedDatagram& captured : std::as_const(datagrams))
+        {
+            if (packetizer.unpack(captured.data, parsed) && parsed.header.channelId != 0)
+            {
+                channelId = parsed.header.channelId;
+                break;
+            }
+        }
+    }
+
+    // Release times on the capture clock; impairment is decided up front
+    // from its seed, so the same spec always replays the same traffic.
+    std::multimap<qint64, int> timeline;
+    NetworkImpairmentStats impairmentStats;
+    const bool impaired = parser.isSet(netemOption);
+    if (impaired)
+    {
+        NetworkImpairmentConfig config;
+        if (!NetworkImpairmentConfig::parse(parser.value(netemOption), nullptr, &config, &error))
+        {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 1;
+        }
+        NetworkImpairment link(config);
+        qint64 releaseUs[NetworkImpairment::kMaxCopies];
+        for (int i = 0; i < datagrams.size(); ++i)
+        {
+            const int copies = link.offer(datagrams.at(i).timeUs, static_cast<int>(datagrams.at(i).data.size()), releaseUs);
+            for (int c = 0; c < copies; ++c)
+                timeline.emplace(releaseUs[c], i);
+        }
+        impairmentStats = link.stats();
+    }
+    else
+    {
+        for (int i = 0; i < datagrams.size(); ++i)
+            timeline.emplace(datagrams.at(i).timeUs, i);
+    }
+
+    // The transport is never bound; it only hands injected datagrams to
+    // ChannelManager, and its JOIN/LEAVE sends go nowhere.
+    UdpTransport transport;
+    AeadCipher cipher;
+    KeyExchange keyExchange;
+    JitterBuffer jitter;
+    Codec2Wrapper codec;
+    codec.setCodec2LibraryPath(parser.value(codec2Option));
+    codec.setOpusLibraryPath(parser.value(opusOption));
+
+    QObject::connect(&keyExchange, &KeyExchange::sessionKeyReady,
+                     &cipher, [&cipher](const QByteArray& key,
+                                        const QByteArray& nonceBase,
+                                        KeyExchange::CryptoMode mode) {
+        cipher.setKey(key, nonceBase);
+        const bool legacy = (mode == KeyExchange::CryptoMode::LegacyXor);
+        cipher.setMode(legacy ? AeadCipher::Mode::LegacyXor
+                              : AeadCipher::Mode::AesGcm);
+    });
+    if (parser.isSet(legacyCryptoOption))
+        keyExchange.setPreferredMode(KeyExchange::CryptoMode::LegacyXor);
+    keyExchange.setChannelId(channelId);
+    keyExchange.setPassword(parser.value(passwordOption));
+    keyExchange.startHandshake();
+    QElapsedTimer keyTimer;
+    keyTimer.start();
+    while (!cipher.isReady() && keyTimer.elapsed() < kKeyTimeoutMs)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    if (!cipher.isReady())
+    {
+        std::fprintf(stderr, "No session key for channel %u\n", channelId);
+        return 1;
+    }
+
+    ChannelManager manager;
+    manager.setTransport(&transport);
+    manager.setPacketizer(&packetizer);
+    manager.setCipher(&cipher);
+    manager.setJitterBuffer(&jitter);
+    manager.setCodec(&codec);
+    manager.setFecEnabled(!parser.isSet(noFecOption));
+    ChannelConfig channel;
+    channel.channelId = channelId;
+    channel.password = parser.value(passwordOption);
+    manager.joinChannel(channel);
+
+    const int frameMs = codec.frameMs() > 0 ? codec.frameMs() : 20;
+    const int frameSamples = manager.playoutFrameSamples();
+    const int sampleRate = frameSamples * 1000 / frameMs;
+    const qint64 frameUs = static_cast<qint64>(frameMs) * 1000;
+    const qint64 startUs = timeline.begin()->first;
+    const qint64 endUs = timeline.rbegin()->first + static_cast<qint64>(qMax(0, parser.value(tailOption).toInt())) * 1000;
+    const bool realtime = parser.isSet(realtimeOption);
+
+    // The event loop never runs from here on, so ChannelManager's fallback
+    // playout timer stays idle and this loop is the only consumer.
+    QVector<qint16> frame(frameSamples);
+    QVector<qint16> output;
+    output.reserve(static_cast<qsizetype>((endUs - startUs) / frameUs + 1) * frameSamples);
+    QVector<qint64> rxNanos;
+    QVector<qint64> renderNanos;
+    rxNanos.reserve(static_cast<qsizetype>(timeline.size()));
+    int audibleFrames = 0;
+
+    QElapsedTimer wall;
+    wall.start();
+    QElapsedTimer stage;
+    auto next = timeline.begin();
+    for (qint64 tickUs = startUs; tickUs < endUs; tickUs += frameUs)
+    {
+        for (; next != timeline.end() && next->first <= tickUs; ++next)
+        {
+            const CapturedDatagram& captured = datagrams.at(next->second);
+            stage.start();
+            transport.injectDatagram(captured.data, captured.sender, captured.senderPort);
+            rxNanos.append(stage.nsecsElapsed());
+        }
+
+        if (realtime)
+        {
+            const qint64 aheadUs = (tickUs - startUs) - wall.nsecsElapsed() / 1000;
+            if (aheadUs > 0)
+                QThread::usleep(static_cast<unsigned long>(aheadUs));
+        }
+
+        stage.start();
+        if (manager.renderPlayout(frame))
+            ++audibleFrames;
+        renderNanos.append(stage.nsecsElapsed());
+        output.append(frame);
+    }
+    const double wallSec = wall.nsecsElapsed() / 1e9;
+
+    if (!WavFile::writeMono(parser.value(wavOption), output, sampleRate, &error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
+    const double replaySec = static_cast<double>(output.size()) / sampleRate;
+    QJsonObject root = ToolReport::header(QStringLiteral("incomudon_replay"));
+    root.insert(QStringLiteral("channelId"), static_cast<qint64>(channelId));
+    root.insert(QStringLiteral("datagrams"), static_cast<int>(datagrams.size()));
+    root.insert(QStringLiteral("delivered"), static_cast<int>(timeline.size()));
+    if (impaired)
+    {
+        QJsonObject impairment;
+        impairment.insert(QStringLiteral("spec"), parser.value(netemOption));
+        impairment.insert(QStringLiteral("lost"), static_cast<qint64>(impairmentStats.lost));
+        impairment.insert(QStringLiteral("queueDrops"), static_cast<qint64>(impairmentStats.queueDrops));
+        impairment.insert(QStringLiteral("duplicated"), static_cast<qint64>(impairmentStats.duplicated));
+        impairment.insert(QStringLiteral("reordered"), static_cast<qint64>(impairmentStats.reordered));
+        root.insert(QStringLiteral("impairment"), impairment);
+    }
+    root.insert(QStringLiteral("realtime"), realtime);
+    root.insert(QStringLiteral("sampleRate"), sampleRate);
+    root.insert(QStringLiteral("frameMs"), frameMs);
+    root.insert(QStringLiteral("replaySec"), replaySec);
+    root.insert(QStringLiteral("wallSec"), wallSec);
+    root.insert(QStringLiteral("speedup"), wallSec > 0.0 ? replaySec / wallSec : 0.0);
+    root.insert(QStringLiteral("audibleFrames"), audibleFrames);
+    root.insert(QStringLiteral("frames"), static_cast<int>(renderNanos.size()));
+    const PlayoutStats playout = manager.playoutStats();
+    const quint64 playoutTicks = playout.playedFrames + playout.concealedFrames;
+    root.insert(QStringLiteral("concealedFrames"), static_cast<qint64>(playout.concealedFrames));
+    root.insert(QStringLiteral("fecRecoveredFrames"), static_cast<qint64>(playout.fecRecoveredFrames));
+    root.insert(QStringLiteral("concealedRatio"),
+                playoutTicks > 0 ? static_cast<double>(playout.concealedFrames) / playoutTicks : 0.0);
+    root.insert(QStringLiteral("rxPerDatagram"), ToolReport::timingSummary(rxNanos));
+    root.insert(QStringLiteral("renderPerFrame"), ToolReport::timingSummary(renderNanos));
+
+    return ToolReport::write(root, parser.value(outputOption));
+}
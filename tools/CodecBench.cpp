@@ -0,0 +1,206 @@
+// Headless codec benchmark. Loads codec2/Opus through Codec2Wrapper and
+// reports per-frame encode/decode cost for every supported mode as JSON.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QVector>
+#include <QtMath>
+#include <algorithm>
+
+#include "codec/Codec2Wrapper.h"
+#include "tools/ToolReport.h"
+
+namespace {
+struct BenchCase
+{
+    int codecType = Codec2Wrapper::CodecTypeCodec2;
+    int mode = 1600;
+};
+
+static QVector<qint16> makeSpeechLikeSignal(int sampleRate, int totalSamples)
+{
+    // Glottal-ish harmonic series with a slow pitch glide, syllable envelope
+    // and a little noise, so codecs see voiced and unvoiced segments.
+    QVector<qint16> out(totalSamples);
+    quint32 prng = 0x12345678u;
+    double phase = 0.0;
+    for (int i = 0; i < totalSamples; ++i)
+    {
+        const double t = static_cast<double>(i) / sampleRate;
+        const double pitch = 120.0 + 30.0 * qSin(2.0 * M_PI * 0.7 * t);
+        phase += 2.0 * M_PI * pitch / sampleRate;
+        double voiced = 0.0;
+        for (int h = 1; h <= 12; ++h)
+            voiced += qSin(phase * h) / h;
+        prng = prng * 1664525u + 1013904223u;
+        const double noise = (static_cast<int>((prng >> 16) & 0xffff) - 32768) / 32768.0;
+        const double envelope = 0.5 + 0.5 * qSin(2.0 * M_PI * 3.0 * t);
+        const double sample = envelope * (0.45 * voiced + 0.08 * noise);
+        out[i] = static_cast<qint16>(qBound(-32768, qRound(sample * 12000.0), 32767));
+    }
+    return out;
+}
+
+static QJsonObject summarize(QVector<qint64> nanos)
+{
+    QJsonObject result;
+    if (nanos.isEmpty())
+        return result;
+
+    std::sort(nanos.begin(), nanos.end());
+    const auto percentile = [&](double p) {
+        const int idx = qBound(0, static_cast<int>(qCeil(p * nanos.size())) - 1, nanos.size() - 1);
+        return nanos.at(idx) / 1000.0;
+    };
+    qint64 total = 0;
+    for (qint64 value : std::as_const(nanos))
+        total += value;
+
+    result.insert(QStringLiteral("p50Us"), percentile(0.50));
+    result.insert(QStringLiteral("p99Us"), percentile(0.99));
+    result.insert(QStringLiteral("maxUs"), nanos.constLast() / 1000.0);
+    result.insert(QStringLiteral("meanUs"), (static_cast<double>(total) / nanos.size()) / 1000.0);
+    return result;
+}
+
+static QJsonObject runCase(const BenchCase& benchCase,
+                           const QString& codec2Path,
+                           const QString& opusPath,
+                           int frames,
+                           int warmupFrames)
+{
+    Codec2Wrapper codec;
+    codec.setCodec2LibraryPath(codec2Path);
+    codec.setOpusLibraryPath(opusPath);
+    codec.setCodecType(benchCase.codecType);
+    codec.setMode(benchCase.mode);
+
+    const bool opus = benchCase.codecType == Codec2Wrapper::CodecTypeOpus;
+    QJsonObject result;
+    result.insert(QStringLiteral("codec"), opus ? QStringLiteral("opus") : QStringLiteral("codec2"));
+    result.insert(QStringLiteral("mode"), opus ? codec.mode() : benchCase.mode);
+    if (!opus && benchCase.mode == 700)
+        result.insert(QStringLiteral("label"), QStringLiteral("700C"));
+
+    const bool active = opus ? codec.opusActive() : codec.codec2Active();
+    result.insert(QStringLiteral("active"), active);
+    if (!active)
+    {
+        const QString error = opus ? codec.opusLibraryError() : codec.codec2LibraryError();
+        result.insert(QStringLiteral("error"), error.isEmpty()
+                                                   ? QStringLiteral("codec not available")
+                                                   : error);
+        return result;
+    }
+
+    const int frameSamples = codec.pcmFrameBytes() / static_cast<int>(sizeof(qint16));
+    const int frameMs = codec.frameMs();
+    result.insert(QStringLiteral("sampleRate"), codec.sampleRate());
+    result.insert(QStringLiteral("frameMs"), frameMs);
+    result.insert(QStringLiteral("frameSamples"), frameSamples);
+
+    const int totalFrames = frames + warmupFrames;
+    const QVector<qint16> signal = makeSpeechLikeSignal(codec.sampleRate(), frameSamples * totalFrames);
+    QVector<quint8> encoded(codec.maxEncodedFrameBytes());
+    QVector<qint16> decoded(frameSamples);
+    QVector<qint64> encodeNanos;
+    QVector<qint64> decodeNanos;
+    encodeNanos.reserve(frames);
+    decodeNanos.reserve(frames);
+    qint64 encodedBytes = 0;
+
+    QElapsedTimer timer;
+    for (int frame = 0; frame < totalFrames; ++frame)
+    {
+        const QSpan<const qint16> pcm(signal.constData() + frame * frameSamples, frameSamples);
+
+        timer.start();
+        const int bytes = codec.encode(pcm, QSpan<quint8>(encoded));
+        const qint64 encodeTime = timer.nsecsElapsed();
+
+        timer.start();
+        codec.decode(QSpan<const quint8>(encoded.constData(), qMax(0, bytes)), QSpan<qint16>(decoded));
+        const qint64 decodeTime = timer.nsecsElapsed();
+
+        if (frame < warmupFrames)
+            continue;
+        encodeNanos.append(encodeTime);
+        decodeNanos.append(decodeTime);
+        encodedBytes += bytes;
+    }
+
+    const QJsonObject encodeStats = summarize(encodeNanos);
+    const QJsonObject decodeStats = summarize(decodeNanos);
+    const double frameUs = frameMs * 1000.0;
+    const double encodeMean = encodeStats.value(QStringLiteral("meanUs")).toDouble();
+    const double decodeMean = decodeStats.value(QStringLiteral("meanUs")).toDouble();
+    result.insert(QStringLiteral("encode"), encodeStats);
+    result.insert(QStringLiteral("decode"), decodeStats);
+    result.insert(QStringLiteral("avgEncodedBytes"), static_cast<double>(encodedBytes) / qMax(1, frames));
+    // Fraction of real time spent in the codec; 0.01 means 1% of one core.
+    result.insert(QStringLiteral("encodeRealTimeFactor"), encodeMean / frameUs);
+    result.insert(QStringLiteral("decodeRealTimeFactor"), decodeMean / frameUs);
+    result.insert(QStringLiteral("realTimeFactor"), (encodeMean + decodeMean) / frameUs);
+    return result;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName(QStringLiteral("FriedOudon"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("friedoudon.com"));
+    QCoreApplication::setApplicationName(QStringLiteral("IncomUdonCodecBench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("IncomUdon codec benchmark"));
+    parser.addHelpOption();
+    const QCommandLineOption codec2Option(QStringLiteral("codec2-lib"),
+                                          QStringLiteral("Path to the codec2 runtime library."),
+                                          QStringLiteral("path"));
+    const QCommandLineOption opusOption(QStringLiteral("opus-lib"),
+                                        QStringLiteral("Path to the opus runtime library."),
+                                        QStringLiteral("path"));
+    const QCommandLineOption framesOption(QStringLiteral("frames"),
+                                          QStringLiteral("Measured frames per mode (default 1000)."),
+                                          QStringLiteral("count"),
+                                          QStringLiteral("1000"));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+                                          QStringLiteral("Unmeasured warm-up frames per mode (default 50)."),
+                                          QStringLiteral("count"),
+                                          QStringLiteral("50"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("Write JSON to file instead of stdout."),
+                                          QStringLiteral("file"));
+    parser.addOption(codec2Option);
+    parser.addOption(opusOption);
+    parser.addOption(framesOption);
+    parser.addOption(warmupOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const int frames = qMax(1, parser.value(framesOption).toInt());
+    const int warmupFrames = qMax(0, parser.value(warmupOption).toInt());
+    const QString codec2Path = parser.value(codec2Option);
+    const QString opusPath = parser.value(opusOption);
+
+    QVector<BenchCase> cases;
+    for (int mode : {450, 700, 1600, 2400, 3200})
+        cases.append(BenchCase{Codec2Wrapper::CodecTypeCodec2, mode});
+    for (int bitrate : {6000, 8000, 12000, 16000, 20000, 64000, 96000, 128000})
+        cases.append(BenchCase{Codec2Wrapper::CodecTypeOpus, bitrate});
+
+    QJsonArray results;
+    for (const BenchCase& benchCase : std::as_const(cases))
+        results.append(runCase(benchCase, codec2Path, opusPath, frames, warmupFrames));
+
+    QJsonObject root = ToolReport::header(QStringLiteral("incomudon_codec_bench"));
+    root.insert(QStringLiteral("frames"), frames);
+    root.insert(QStringLiteral("warmupFrames"), warmupFrames);
+    root.insert(QStringLiteral("results"), results);
+
+    return ToolReport::write(root, parser.value(outputOption));
+}
@@ -0,0 +1,681 @@
+// Protocol-level soak load generator. Simulates --channels x
+// --clients-per-channel clients against a relay, each with the client's own
+// UdpTransport, Packetizer, KeyExchange, AeadCipher, FecEncoder and
+// PacketBuilder: JOIN, keepalive every 5 s, rotating PTT_ON/OFF talk spurts
+// and encrypted audio at the codec frame rate. Reports achieved packet
+// rates, audio loss and latency through the relay, keepalive RTT and the
+// per-packet TX/RX CPU cost as JSON.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QList>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QtEndian>
+#include <QtMath>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "crypto/AeadCipher.h"
+#include "crypto/KeyExchange.h"
+#include "net/Fec.h"
+#include "net/PacketBuilder.h"
+#include "net/Packetizer.h"
+#include "net/udptransport.h"
+#include "tools/ToolReport.h"
+
+namespace {
+constexpr int kKeepaliveIntervalMs = 5000;
+constexpr int kGrantTimeoutMs = 1000;
+constexpr int kTimestampBytes = 8;
+
+struct LoadConfig
+{
+    QHostAddress relayAddress;
+    quint16 relayPort = 50000;
+    QString password;
+    quint32 channelBase = 1000;
+    int clientsPerChannel = 10;
+    int frameMs = 20;
+    int frameBytes = 8;
+    bool fec = false;
+    int talkMs = 4000;
+    int idleMs = 1000;
+};
+
+struct LoadStats
+{
+    quint64 datagramsSent = 0;
+    quint64 datagramsReceived = 0;
+    quint64 audioFramesSent = 0;
+    quint64 fecPacketsSent = 0;
+    quint64 expectedDeliveries = 0;
+    quint64 deliveries = 0;
+    quint64 decryptFailures = 0;
+    quint64 talkGrants = 0;
+    quint64 talkDenies = 0;
+    quint64 grantTimeouts = 0;
+    quint64 txPackets = 0;
+    qint64 txBuildNs = 0;
+    quint64 rxPackets = 0;
+    qint64 rxNs = 0;
+    int joinedClients = 0;
+    QVector<qint32> latencyUs;
+    QVector<qint32> keepaliveRttUs;
+
+    void merge(const LoadStats& other)
+    {
+        datagramsSent += other.datagramsSent;
+        datagramsReceived += other.datagramsReceived;
+        audioFramesSent += other.audioFramesSent;
+        fecPacketsSent += other.fecPacketsSent;
+        expectedDeliveries += other.expectedDeliveries;
+        deliveries += other.deliveries;
+        decryptFailures += other.decryptFailures;
+        talkGrants += other.talkGrants;
+        talkDenies += other.talkDenies;
+        grantTimeouts += other.grantTimeouts;
+        txPackets += other.txPackets;
+        txBuildNs += other.txBuildNs;
+        rxPackets += other.rxPackets;
+        rxNs += other.rxNs;
+        joinedClients += other.joinedClients;
+        latencyUs += other.latencyUs;
+        keepaliveRttUs += other.keepaliveRttUs;
+    }
+};
+
+struct SimClient
+{
+    quint32 senderId = 0;
+    int channel = 0;
+    UdpTransport* transport = nullptr;
+    Packetizer* packetizer = nullptr;
+    AeadCipher* cipher = nullptr;
+    KeyExchange* keyExchange = nullptr;
+    FecEncoder fec;
+    quint16 audioSeq = 0;
+    qint64 keepaliveSentNs = -1;
+    bool joined = false;
+};
+
+struct SimChannel
+{
+    enum Phase { Idle, Requesting, Talking };
+
+    quint32 id = 0;
+    QList<int> members;
+    int nextTalker = 0;
+    int talker = -1;
+    Phase phase = Idle;
+    qint64 phaseEndsMs = 0;
+};
+
+// Owns a slice of the channels and all of their clients; lives on its own
+// thread so several cores share the client-side work.
+class LoadWorker : public QObject
+{
+public:
+    LoadWorker(const LoadConfig& config, const QElapsedTimer& clock, const QList<quint32>& channelIds)
+        : m_config(config),
+          m_clock(clock),
+          m_channelIds(channelIds)
+    {
+    }
+
+    // Worker thread.
+    void start()
+    {
+        for (quint32 channelId : std::as_const(m_channelIds))
+        {
+            SimChannel channel;
+            channel.id = channelId;
+            // Spread the first talk spurts so channels do not key up in step.
+            channel.phaseEndsMs = QRandomGenerator::global()->bounded(m_config.talkMs + m_config.idleMs);
+            for (int slot = 0; slot < m_config.clientsPerChannel; ++slot)
+            {
+                channel.members.append(static_cast<int>(m_clients.size()));
+                m_clients.append(createClient(static_cast<int>(m_channels.size()), channelId, slot));
+            }
+            m_channels.append(channel);
+        }
+
+        m_startMs = m_clock.elapsed();
+        m_frameTimer = new QTimer(this);
+        m_frameTimer->setTimerType(Qt::PreciseTimer);
+        m_frameTimer->setInterval(m_config.frameMs);
+        connect(m_frameTimer, &QTimer::timeout, this, [this]() { onFrameTick(); });
+        m_frameTimer->start();
+
+        m_keepaliveTimer = new QTimer(this);
+        m_keepaliveTimer->setInterval(kKeepaliveIntervalMs);
+        connect(m_keepaliveTimer, &QTimer::timeout, this, [this]() { sendKeepalives(); });
+        m_keepaliveTimer->start();
+    }
+
+    void beginMeasurement()
+    {
+        m_stats = LoadStats();
+        m_windowStartNs = m_clock.nsecsElapsed();
+        m_measuring = true;
+    }
+
+    void endMeasurement()
+    {
+        m_windowEndNs = m_clock.nsecsElapsed();
+        m_measuring = false;
+    }
+
+    void stopTraffic()
+    {
+        m_frameTimer->stop();
+        m_keepaliveTimer->stop();
+        for (const SimChannel& channel : std::as_const(m_channels))
+        {
+            if (channel.phase != SimChannel::Idle)
+                sendControl(m_clients[channel.talker], Proto::PKT_PTT_OFF);
+        }
+        for (SimClient& client : m_clients)
+            sendControl(client, Proto::PKT_LEAVE);
+    }
+
+    LoadStats stats() const
+    {
+        LoadStats stats = m_stats;
+        for (const SimClient& client : m_clients)
+        {
+            if (client.joined)
+                ++stats.joinedClients;
+        }
+        return stats;
+    }
+
+private:
+    SimClient createClient(int channelIndex, quint32 channelId, int slot)
+    {
+        SimClient client;
+        client.channel = channelIndex;
+        client.senderId = 0x40000000u | (channelId << 8) | static_cast<quint32>(slot + 1);
+        client.transport = new UdpTransport(this);
+        client.transport->bind(0);
+        client.packetizer = new Packetizer(this);
+        client.packetizer->setChannelId(channelId);
+        client.packetizer->setSenderId(client.senderId);
+        client.cipher = new AeadCipher(this);
+        client.packetizer->setKeyId(client.cipher->keyId());
+        client.keyExchange = new KeyExchange(this);
+        client.fec.setEnabled(m_config.fec);
+
+        AeadCipher* cipher = client.cipher;
+        connect(client.keyExchange, &KeyExchange::sessionKeyReady,
+                this, [cipher](const QByteArray& key, const QByteArray& nonceBase, KeyExchange::CryptoMode mode) {
+            cipher->setKey(key, nonceBase);
+            cipher->setMode(mode == KeyExchange::CryptoMode::LegacyXor ? AeadCipher::Mode::LegacyXor
+                                                                        : AeadCipher::Mode::AesGcm);
+        });
+        const int index = static_cast<int>(m_clients.size());
+        connect(client.transport, &UdpTransport::datagramReceived,
+                this, [this, index](const QByteArray& datagram, const QHostAddress&, quint16) {
+            onDatagram(m_clients[index], datagram);
+        });
+
+        client.keyExchange->setChannelId(channelId);
+        client.keyExchange->setPassword(m_config.password);
+        client.keyExchange->startHandshake();
+        sendControl(client, Proto::PKT_JOIN);
+        return client;
+    }
+
+    void sendControl(SimClient& client, Proto::PacketType type)
+    {
+        client.transport->send(client.packetizer->packPlain(type, QByteArray()),
+                               m_config.relayAddress,
+                               m_config.relayPort);
+        if (m_measuring)
+            ++m_stats.datagramsSent;
+    }
+
+    void sendKeepalives()
+    {
+        const qint64 now = m_clock.nsecsElapsed();
+        for (SimClient& client : m_clients)
+        {
+            client.keepaliveSentNs = now;
+            sendControl(client, Proto::PKT_KEEPALIVE);
+        }
+    }
+
+    void onFrameTick()
+    {
+        const qint64 nowMs = m_clock.elapsed() - m_startMs;
+        for (SimChannel& channel : m_channels)
+        {
+            switch (channel.phase)
+            {
+            case SimChannel::Idle:
+                if (nowMs < channel.phaseEndsMs)
+                    break;
+                channel.talker = channel.members.at(channel.nextTalker);
+                channel.nextTalker = (channel.nextTalker + 1) % channel.members.size();
+                channel.phase = SimChannel::Requesting;
+                channel.phaseEndsMs = nowMs + kGrantTimeoutMs;
+                sendControl(m_clients[channel.talker], Proto::PKT_PTT_ON);
+                break;
+            case SimChannel::Requesting:
+                if (nowMs < channel.phaseEndsMs)
+                    break;
+                if (m_measuring)
+                    ++m_stats.grantTimeouts;
+                enterIdle(channel, nowMs);
+                break;
+            case SimChannel::Talking:
+                if (nowMs >= channel.phaseEndsMs)
+                {
+                    sendControl(m_clients[channel.talker], Proto::PKT_PTT_OFF);
+                    enterIdle(channel, nowMs);
+                    break;
+                }
+                sendFrame(channel, m_clients[channel.talker]);
+                break;
+            }
+        }
+    }
+
+    void enterIdle(SimChannel& channel, qint64 nowMs)
+    {
+        channel.phase = SimChannel::Idle;
+        channel.phaseEndsMs = nowMs + m_config.idleMs;
+    }
+
+    void sendFrame(const SimChannel& channel, SimClient& client)
+    {
+        if (!client.cipher->isReady())
+            return;
+
+        // The frame carries its send time so listeners can measure the
+        // path through the relay.
+        const qint64 sentNs = m_clock.nsecsElapsed();
+        std::memcpy(m_frame.data(), &sentNs, kTimestampBytes);
+        const QSpan<const quint8> frame(reinterpret_cast<const quint8*>(m_frame.constData()), m_frame.size());
+
+        QElapsedTimer build;
+        build.start();
+        m_builder.buildAudio(*client.packetizer, *client.cipher, client.audioSeq, frame);
+        int fecPackets = 0;
+        if (m_config.fec && client.fec.addFrame(client.audioSeq, frame))
+        {
+            for (int i = 0; i < FecEncoder::kParityPackets; ++i)
+            {
+                m_builder.buildFec(*client.packetizer,
+                                   *client.cipher,
+                                   client.fec.completedBlockStart(),
+                                   static_cast<quint8>(client.fec.blockSize()),
+                                   static_cast<quint8>(i),
+                                   client.fec.parity(i));
+                ++fecPackets;
+            }
+        }
+        const qint64 buildNs = build.nsecsElapsed();
+        client.audioSeq++;
+
+        const QSpan<const QByteArrayView> packets = m_builder.packets();
+        client.transport->sendBatch(packets, m_config.relayAddress, m_config.relayPort);
+        if (m_measuring)
+        {
+            m_stats.datagramsSent += static_cast<quint64>(packets.size());
+            m_stats.txPackets += static_cast<quint64>(packets.size());
+            m_stats.txBuildNs += buildNs;
+            ++m_stats.audioFramesSent;
+            m_stats.fecPacketsSent += static_cast<quint64>(fecPackets);
+        }
+        if (inWindow(sentNs))
+            m_stats.expectedDeliveries += static_cast<quint64>(channel.members.size() - 1);
+        m_builder.clear();
+    }
+
+    bool inWindow(qint64 ns) const
+    {
+        return m_windowStartNs >= 0 && ns >= m_windowStartNs && (m_windowEndNs < 0 || ns < m_windowEndNs);
+    }
+
+    void onDatagram(SimClient& client, const QByteArray& datagram)
+    {
+        const qint64 receivedNs = m_clock.nsecsElapsed();
+        if (m_measuring)
+            ++m_stats.datagramsReceived;
+
+        ParsedPacket parsed;
+        if (!client.packetizer->unpack(datagram, parsed))
+            return;
+        client.joined = true;
+
+        switch (parsed.header.type)
+        {
+        case Proto::PKT_KEEPALIVE:
+            if (client.keepaliveSentNs >= 0)
+            {
+                if (m_measuring)
+                    m_stats.keepaliveRttUs.append(static_cast<qint32>((receivedNs - client.keepaliveSentNs) / 1000));
+                client.keepaliveSentNs = -1;
+            }
+            break;
+        case Proto::PKT_TALK_GRANT:
+        case Proto::PKT_TALK_DENY:
+            onTalkResponse(client, parsed);
+            break;
+        case Proto::PKT_AUDIO:
+        {
+            QByteArray plaintext;
+            const bool ok = client.cipher->decrypt(parsed.encryptedPayload,
+                                                   parsed.authTag,
+                                                   parsed.sec.nonce,
+                                                   QByteArray(),
+                                                   plaintext);
+            const qint64 rxNs = m_clock.nsecsElapsed() - receivedNs;
+            if (m_measuring)
+            {
+                ++m_stats.rxPackets;
+                m_stats.rxNs += rxNs;
+            }
+            if (!ok)
+            {
+                if (m_measuring)
+                    ++m_stats.decryptFailures;
+                break;
+            }
+            if (plaintext.size() < 2 + kTimestampBytes)
+                break;
+            qint64 sentNs = 0;
+            std::memcpy(&sentNs, plaintext.constData() + 2, kTimestampBytes);
+            if (!inWindow(sentNs))
+                break;
+            ++m_stats.deliveries;
+            m_stats.latencyUs.append(static_cast<qint32>((receivedNs - sentNs) / 1000));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void onTalkResponse(const SimClient& client, const ParsedPacket& parsed)
+    {
+        SimChannel& channel = m_channels[client.channel];
+        if (channel.phase != SimChannel::Requesting || m_clients.at(channel.talker).senderId != client.senderId)
+            return;
+
+        const qint64 nowMs = m_clock.elapsed() - m_startMs;
+        if (parsed.header.type == Proto::PKT_TALK_DENY)
+        {
+            if (m_measuring)
+                ++m_stats.talkDenies;
+            enterIdle(channel, nowMs);
+            return;
+        }
+
+        if (parsed.encryptedPayload.size() < 4 ||
+            qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(parsed.encryptedPayload.constData())) != client.senderId)
+        {
+            return;
+        }
+        if (m_measuring)
+            ++m_stats.talkGrants;
+        SimClient& talker = m_clients[channel.talker];
+        talker.audioSeq = 0;
+        talker.fec.reset();
+        channel.phase = SimChannel::Talking;
+        channel.phaseEndsMs = nowMs + m_config.talkMs;
+    }
+
+    const LoadConfig m_config;
+    const QElapsedTimer& m_clock;
+    const QList<quint32> m_channelIds;
+    QList<SimClient> m_clients;
+    QList<SimChannel> m_channels;
+    PacketBuilder m_builder;
+    QByteArray m_frame = QByteArray(qMax(kTimestampBytes, m_config.frameBytes), '\x2a');
+    QTimer* m_frameTimer = nullptr;
+    QTimer* m_keepaliveTimer = nullptr;
+    qint64 m_startMs = 0;
+    bool m_measuring = false;
+    qint64 m_windowStartNs = -1;
+    qint64 m_windowEndNs = -1;
+    LoadStats m_stats;
+};
+
+static double perSecond(quint64 count, double seconds)
+{
+    return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+}
+
+static QJsonObject percentiles(QVector<qint32> samplesUs)
+{
+    QJsonObject out;
+    out.insert(QStringLiteral("samples"), static_cast<int>(samplesUs.size()));
+    if (samplesUs.isEmpty())
+        return out;
+    std::sort(samplesUs.begin(), samplesUs.end());
+    const auto percentile = [&](double p) {
+        const int idx = qBound(0, static_cast<int>(qCeil(p * samplesUs.size())) - 1, static_cast<int>(samplesUs.size()) - 1);
+        return samplesUs.at(idx) / 1000.0;
+    };
+    out.insert(QStringLiteral("p50Ms"), percentile(0.50));
+    out.insert(QStringLiteral("p99Ms"), percentile(0.99));
+    out.insert(QStringLiteral("maxMs"), samplesUs.constLast() / 1000.0);
+    return out;
+}
+
+static void raiseFileLimit()
+{
+#ifdef Q_OS_UNIX
+    // One socket per simulated client quickly passes the default 1024.
+    rlimit limit {};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("IncomUdonLoadGenerator"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("IncomUdon synthetic client load generator"));
+    parser.addHelpOption();
+    const QCommandLineOption relayOption(QStringLiteral("relay"),
+                                         QStringLiteral("Relay address (default 127.0.0.1)."),
+                                         QStringLiteral("address"),
+                                         QStringLiteral("127.0.0.1"));
+    const QCommandLineOption portOption(QStringLiteral("port"),
+                                        QStringLiteral("Relay UDP port (default 50000)."),
+                                        QStringLiteral("port"),
+                                        QStringLiteral("50000"));
+    const QCommandLineOption passwordOption(QStringLiteral("password"),
+                                            QStringLiteral("Channel password (default loadgen)."),
+                                            QStringLiteral("password"),
+                                            QStringLiteral("loadgen"));
+    const QCommandLineOption channelsOption(QStringLiteral("channels"),
+                                            QStringLiteral("Simulated channels (default 100)."),
+                                            QStringLiteral("count"),
+                                            QStringLiteral("100"));
+    const QCommandLineOption clientsOption(QStringLiteral("clients-per-channel"),
+                                           QStringLiteral("Clients per channel, 2-255 (default 10)."),
+                                           QStringLiteral("count"),
+                                           QStringLiteral("10"));
+    const QCommandLineOption channelBaseOption(QStringLiteral("channel-base"),
+                                               QStringLiteral("First channel id (default 1000)."),
+                                               QStringLiteral("id"),
+                                               QStringLiteral("1000"));
+    const QCommandLineOption frameMsOption(QStringLiteral("frame-ms"),
+                                           QStringLiteral("Codec frame period (default 20)."),
+                                           QStringLiteral("ms"),
+                                           QStringLiteral("20"));
+    const QCommandLineOption frameBytesOption(QStringLiteral("frame-bytes"),
+                                              QStringLiteral("Codec frame size, at least 8 (default 8)."),
+                                              QStringLiteral("bytes"),
+                                              QStringLiteral("8"));
+    const QCommandLineOption fecOption(QStringLiteral("fec"),
+                                       QStringLiteral("Send FEC parity packets."));
+    const QCommandLineOption talkOption(QStringLiteral("talk-ms"),
+                                        QStringLiteral("Length of each talk spurt (default 4000)."),
+                                        QStringLiteral("ms"),
+                                        QStringLiteral("4000"));
+    const QCommandLineOption idleOption(QStringLiteral("idle-ms"),
+                                        QStringLiteral("Gap between talk spurts (default 1000)."),
+                                        QStringLiteral("ms"),
+                                        QStringLiteral("1000"));
+    const QCommandLineOption threadsOption(QStringLiteral("threads"),
+                                           QStringLiteral("Worker threads (default: CPU count)."),
+                                           QStringLiteral("count"),
+                                           QString::number(QThread::idealThreadCount()));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+                                          QStringLiteral("Unmeasured seconds after joining (default 2)."),
+                                          QStringLiteral("seconds"),
+                                          QStringLiteral("2"));
+    const QCommandLineOption durationOption(QStringLiteral("duration"),
+                                            QStringLiteral("Measured seconds (default 10)."),
+                                            QStringLiteral("seconds"),
+                                            QStringLiteral("10"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("JSON report file (default stdout)."),
+                                          QStringLiteral("file"));
+    parser.addOption(relayOption);
+    parser.addOption(portOption);
+    parser.addOption(passwordOption);
+    parser.addOption(channelsOption);
+    parser.addOption(clientsOption);
+    parser.addOption(channelBaseOption);
+    parser.addOption(frameMsOption);
+    parser.addOption(frameBytesOption);
+    parser.addOption(fecOption);
+    parser.addOption(talkOption);
+    parser.addOption(idleOption);
+    parser.addOption(threadsOption);
+    parser.addOption(warmupOption);
+    parser.addOption(durationOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    LoadConfig config;
+    config.relayAddress = QHostAddress(parser.value(relayOption));
+    config.relayPort = static_cast<quint16>(parser.value(portOption).toUInt());
+    config.password = parser.value(passwordOption);
+    config.channelBase = parser.value(channelBaseOption).toUInt();
+    config.clientsPerChannel = qBound(2, parser.value(clientsOption).toInt(), 255);
+    config.frameMs = qBound(5, parser.value(frameMsOption).toInt(), 120);
+    config.frameBytes = qBound(kTimestampBytes, parser.value(frameBytesOption).toInt(), 1200);
+    config.fec = parser.isSet(fecOption);
+    config.talkMs = qMax(config.frameMs, parser.value(talkOption).toInt());
+    config.idleMs = qMax(0, parser.value(idleOption).toInt());
+    if (config.relayAddress.isNull())
+    {
+        std::fprintf(stderr, "Invalid relay address\n");
+        return 1;
+    }
+
+    const int channels = qMax(1, parser.value(channelsOption).toInt());
+    const int threads = qBound(1, parser.value(threadsOption).toInt(), channels);
+    const int warmupSec = qMax(0, parser.value(warmupOption).toInt());
+    const int durationSec = qMax(1, parser.value(durationOption).toInt());
+    raiseFileLimit();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    QList<QList<quint32>> slices(threads);
+    for (int i = 0; i < channels; ++i)
+        slices[i % threads].append(config.channelBase + static_cast<quint32>(i));
+
+    QList<QThread*> workerThreads;
+    QList<LoadWorker*> workers;
+    for (int i = 0; i < threads; ++i)
+    {
+        auto* thread = new QThread();
+        thread->setObjectName(QStringLiteral("IncomUdonLoad%1").arg(i));
+        auto* worker = new LoadWorker(config, clock, slices.at(i));
+        worker->moveToThread(thread);
+        QObject::connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+        QMetaObject::invokeMethod(worker, [worker]() { worker->start(); }, Qt::QueuedConnection);
+        workerThreads.append(thread);
+        workers.append(worker);
+    }
+
+    const auto onWorkers = [&workers](void (LoadWorker::*method)()) {
+        for (LoadWorker* worker : std::as_const(workers))
+            QMetaObject::invokeMethod(worker, [worker, method]() { (worker->*method)(); }, Qt::BlockingQueuedConnection);
+    };
+
+    QThread::sleep(static_cast<unsigned long>(warmupSec));
+    onWorkers(&LoadWorker::beginMeasurement);
+    QElapsedTimer window;
+    window.start();
+    QThread::sleep(static_cast<unsigned long>(durationSec));
+    onWorkers(&LoadWorker::endMeasurement);
+    const double seconds = window.nsecsElapsed() / 1e9;
+    // Let frames sent inside the window arrive before counting them lost.
+    QThread::msleep(500);
+    onWorkers(&LoadWorker::stopTraffic);
+
+    LoadStats total;
+    for (int i = 0; i < threads; ++i)
+    {
+        LoadStats stats;
+        LoadWorker* worker = workers.at(i);
+        QMetaObject::invokeMethod(worker, [worker, &stats]() { stats = worker->stats(); }, Qt::BlockingQueuedConnection);
+        total.merge(stats);
+        workerThreads.at(i)->quit();
+        workerThreads.at(i)->wait();
+        delete workerThreads.at(i);
+    }
+
+    QJsonObject results;
+    results.insert(QStringLiteral("joinedClients"), total.joinedClients);
+    results.insert(QStringLiteral("sentPps"), perSecond(total.datagramsSent, seconds));
+    results.insert(QStringLiteral("receivedPps"), perSecond(total.datagramsReceived, seconds));
+    results.insert(QStringLiteral("audioFramesPerSec"), perSecond(total.audioFramesSent, seconds));
+    results.insert(QStringLiteral("fecPacketsPerSec"), perSecond(total.fecPacketsSent, seconds));
+    results.insert(QStringLiteral("expectedDeliveries"), static_cast<qint64>(total.expectedDeliveries));
+    results.insert(QStringLiteral("deliveries"), static_cast<qint64>(total.deliveries));
+    results.insert(QStringLiteral("lossRatio"),
+                   total.expectedDeliveries > 0
+                       ? 1.0 - static_cast<double>(total.deliveries) / total.expectedDeliveries
+                       : 0.0);
+    results.insert(QStringLiteral("decryptFailures"), static_cast<qint64>(total.decryptFailures));
+    results.insert(QStringLiteral("talkGrants"), static_cast<qint64>(total.talkGrants));
+    results.insert(QStringLiteral("talkDenies"), static_cast<qint64>(total.talkDenies));
+    results.insert(QStringLiteral("grantTimeouts"), static_cast<qint64>(total.grantTimeouts));
+    results.insert(QStringLiteral("audioLatency"), percentiles(total.latencyUs));
+    results.insert(QStringLiteral("relayRtt"), percentiles(total.keepaliveRttUs));
+    results.insert(QStringLiteral("txBuildUsPerPacket"),
+                   total.txPackets > 0 ? total.txBuildNs / 1000.0 / total.txPackets : 0.0);
+    results.insert(QStringLiteral("rxUsPerAudioPacket"),
+                   total.rxPackets > 0 ? total.rxNs / 1000.0 / total.rxPackets : 0.0);
+
+    QJsonObject root = ToolReport::header(QStringLiteral("incomudon_loadgen"));
+    root.insert(QStringLiteral("channels"), channels);
+    root.insert(QStringLiteral("clientsPerChannel"), config.clientsPerChannel);
+    root.insert(QStringLiteral("threads"), threads);
+    root.insert(QStringLiteral("frameMs"), config.frameMs);
+    root.insert(QStringLiteral("frameBytes"), config.frameBytes);
+    root.insert(QStringLiteral("fec"), config.fec);
+    root.insert(QStringLiteral("durationSec"), seconds);
+    root.insert(QStringLiteral("results"), results);
+
+    return ToolReport::write(root, parser.value(outputOption));
+}
@@ -0,0 +1,172 @@
+// Headless playout mixer benchmark. Runs the per-talker RX render path
+// (resample, ring buffer, accumulate) and the final limited mix for a range of
+// talker counts and reports the cost per 20 ms tick as JSON.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QVector>
+#include <QtEndian>
+#include <QtMath>
+#include <algorithm>
+
+#include "audio/AudioMixer.h"
+#include "audio/AudioResampler.h"
+#include "audio/SampleRing.h"
+#include "tools/ToolReport.h"
+
+namespace {
+constexpr int kMixSampleRate = 16000;
+constexpr int kFrameMs = 20;
+
+struct BenchTalker
+{
+    AudioResampler resampler;
+    SampleRing pending;
+    QVector<qint16> decoded;
+    QVector<qint16> resampled;
+    QVector<qint16> frame;
+};
+
+static void fillTone(QVector<qint16>& samples, int sampleRate, double hz, int offset)
+{
+    for (int i = 0; i < samples.size(); ++i)
+    {
+        const double t = static_cast<double>(offset + i) / sampleRate;
+        samples[i] = static_cast<qint16>(qRound(8000.0 * qSin(2.0 * M_PI * hz * t)));
+    }
+}
+
+static QJsonObject summarize(QVector<qint64> nanos, int talkers)
+{
+    QJsonObject result;
+    if (nanos.isEmpty())
+        return result;
+
+    std::sort(nanos.begin(), nanos.end());
+    const auto percentile = [&](double p) {
+        const int idx = qBound(0, static_cast<int>(qCeil(p * nanos.size())) - 1, nanos.size() - 1);
+        return nanos.at(idx) / 1000.0;
+    };
+    qint64 total = 0;
+    for (qint64 value : std::as_const(nanos))
+        total += value;
+    const double meanUs = (static_cast<double>(total) / nanos.size()) / 1000.0;
+
+    result.insert(QStringLiteral("p50Us"), percentile(0.50));
+    result.insert(QStringLiteral("p99Us"), percentile(0.99));
+    result.insert(QStringLiteral("maxUs"), nanos.constLast() / 1000.0);
+    result.insert(QStringLiteral("meanUs"), meanUs);
+    result.insert(QStringLiteral("meanUsPerTalker"), meanUs / qMax(1, talkers));
+    result.insert(QStringLiteral("realTimeFactor"), meanUs / (kFrameMs * 1000.0));
+    return result;
+}
+
+static QJsonObject runCase(int talkers, int codecRate, int ticks, int warmupTicks)
+{
+    const int decodedSamples = codecRate * kFrameMs / 1000;
+    const int mixSamples = kMixSampleRate * kFrameMs / 1000;
+
+    QVector<BenchTalker> streams(talkers);
+    for (int i = 0; i < talkers; ++i)
+    {
+        BenchTalker& talker = streams[i];
+        talker.resampler.setRates(codecRate, kMixSampleRate);
+        talker.pending.reserve(mixSamples * 4);
+        talker.decoded.resize(decodedSamples);
+        talker.frame.resize(mixSamples);
+        fillTone(talker.decoded, codecRate, 180.0 + 40.0 * i, 0);
+    }
+
+    AudioMixer mixer;
+    mixer.configure(mixSamples, kMixSampleRate);
+    QVector<qint16> mixed(mixSamples);
+    QByteArray mixedPcm(mixSamples * static_cast<int>(sizeof(qint16)), 0);
+    QVector<qint64> tickNanos;
+    tickNanos.reserve(ticks);
+
+    QElapsedTimer timer;
+    for (int tick = 0; tick < ticks + warmupTicks; ++tick)
+    {
+        timer.start();
+        mixer.begin();
+        for (BenchTalker& talker : streams)
+        {
+            // The decoded frame stands in for codec output; the codec itself
+            // is measured by incomudon_codec_bench.
+            while (talker.pending.size() < mixSamples)
+            {
+                talker.resampled.clear();
+                talker.resampler.push(talker.decoded, talker.resampled);
+                talker.pending.write(talker.resampled);
+            }
+            talker.pending.read(talker.frame);
+            mixer.add(talker.frame);
+        }
+        mixer.mixTo(mixed);
+        qToLittleEndian<qint16>(mixed.constData(), mixSamples, mixedPcm.data());
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        if (tick >= warmupTicks)
+            tickNanos.append(elapsed);
+    }
+
+    QJsonObject result = summarize(tickNanos, talkers);
+    result.insert(QStringLiteral("talkers"), talkers);
+    result.insert(QStringLiteral("codecSampleRate"), codecRate);
+    result.insert(QStringLiteral("mixSampleRate"), kMixSampleRate);
+    return result;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("IncomUdonMixerBench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("IncomUdon playout mixer benchmark"));
+    parser.addHelpOption();
+    const QCommandLineOption ticksOption(QStringLiteral("ticks"),
+                                         QStringLiteral("Measured playout ticks per case (default 2000)."),
+                                         QStringLiteral("count"),
+                                         QStringLiteral("2000"));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+                                          QStringLiteral("Unmeasured warm-up ticks per case (default 100)."),
+                                          QStringLiteral("count"),
+                                          QStringLiteral("100"));
+    const QCommandLineOption maxTalkersOption(QStringLiteral("max-talkers"),
+                                              QStringLiteral("Largest talker count to measure (default 16)."),
+                                              QStringLiteral("count"),
+                                              QStringLiteral("16"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("Write JSON to file instead of stdout."),
+                                          QStringLiteral("file"));
+    parser.addOption(ticksOption);
+    parser.addOption(warmupOption);
+    parser.addOption(maxTalkersOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const int ticks = qMax(1, parser.value(ticksOption).toInt());
+    const int warmupTicks = qMax(0, parser.value(warmupOption).toInt());
+    const int maxTalkers = qMax(1, parser.value(maxTalkersOption).toInt());
+
+    QJsonArray results;
+    // 8 kHz is codec2; 16 kHz matches the mix rate, so no resampling.
+    for (int codecRate : {8000, 16000})
+    {
+        for (int talkers = 1; talkers <= maxTalkers; talkers *= 2)
+            results.append(runCase(talkers, codecRate, ticks, warmupTicks));
+    }
+
+    QJsonObject root = ToolReport::header(QStringLiteral("incomudon_mixer_bench"));
+    root.insert(QStringLiteral("frameMs"), kFrameMs);
+    root.insert(QStringLiteral("ticks"), ticks);
+    root.insert(QStringLiteral("warmupTicks"), warmupTicks);
+    root.insert(QStringLiteral("results"), results);
+
+    return ToolReport::write(root, parser.value(outputOption));
+}
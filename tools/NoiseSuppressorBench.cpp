@@ -0,0 +1,186 @@
+// Noise suppressor benchmark and offline harness. Without --input it reports
+// the cost per 20 ms capture frame for each sample rate and level as JSON.
+// With --input/--output it filters a WAV file so settings can be compared by
+// ear or with external quality metrics.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QVector>
+#include <QtMath>
+#include <algorithm>
+#include <cstdio>
+
+#include "audio/NoiseSuppressor.h"
+#include "tools/ToolReport.h"
+#include "tools/WavFile.h"
+
+namespace {
+constexpr int kFrameMs = 20;
+
+static QVector<qint16> makeNoisySpeech(int sampleRate, int totalSamples)
+{
+    // Voiced bursts over steady broadband noise, roughly 15 dB SNR.
+    QVector<qint16> out(totalSamples);
+    quint32 prng = 0x2545f491u;
+    double phase = 0.0;
+    for (int i = 0; i < totalSamples; ++i)
+    {
+        const double t = static_cast<double>(i) / sampleRate;
+        phase += 2.0 * M_PI * (130.0 + 25.0 * qSin(2.0 * M_PI * 0.5 * t)) / sampleRate;
+        double voiced = 0.0;
+        for (int h = 1; h <= 10; ++h)
+            voiced += qSin(phase * h) / h;
+        const double envelope = qMax(0.0, qSin(2.0 * M_PI * 0.8 * t));
+        prng = prng * 1664525u + 1013904223u;
+        const double noise = (static_cast<int>((prng >> 16) & 0xffff) - 32768) / 32768.0;
+        const double sample = envelope * 7000.0 * voiced + 900.0 * noise;
+        out[i] = static_cast<qint16>(qBound(-32768, qRound(sample), 32767));
+    }
+    return out;
+}
+
+static QJsonObject runCase(int sampleRate, int level, int frames, int warmupFrames)
+{
+    NoiseSuppressor suppressor;
+    suppressor.configure(sampleRate);
+    suppressor.setLevel(level);
+
+    const int frameSamples = sampleRate * kFrameMs / 1000;
+    const int totalFrames = frames + warmupFrames;
+    QVector<qint16> signal = makeNoisySpeech(sampleRate, frameSamples * totalFrames);
+    QVector<qint64> nanos;
+    nanos.reserve(frames);
+
+    QElapsedTimer timer;
+    for (int frame = 0; frame < totalFrames; ++frame)
+    {
+        timer.start();
+        suppressor.process(QSpan<qint16>(signal.data() + frame * frameSamples, frameSamples));
+        const qint64 elapsed = timer.nsecsElapsed();
+        if (frame >= warmupFrames)
+            nanos.append(elapsed);
+    }
+
+    std::sort(nanos.begin(), nanos.end());
+    const auto percentile = [&](double p) {
+        const int idx = qBound(0, static_cast<int>(qCeil(p * nanos.size())) - 1, nanos.size() - 1);
+        return nanos.at(idx) / 1000.0;
+    };
+    qint64 total = 0;
+    for (qint64 value : std::as_const(nanos))
+        total += value;
+    const double meanUs = (static_cast<double>(total) / qMax(1, nanos.size())) / 1000.0;
+
+    QJsonObject result;
+    result.insert(QStringLiteral("sampleRate"), sampleRate);
+    result.insert(QStringLiteral("level"), level);
+    result.insert(QStringLiteral("hopSamples"), suppressor.hopSamples());
+    result.insert(QStringLiteral("latencyMs"), suppressor.latencySamples() * 1000.0 / sampleRate);
+    result.insert(QStringLiteral("p50Us"), percentile(0.50));
+    result.insert(QStringLiteral("p99Us"), percentile(0.99));
+    result.insert(QStringLiteral("maxUs"), nanos.constLast() / 1000.0);
+    result.insert(QStringLiteral("meanUs"), meanUs);
+    result.insert(QStringLiteral("realTimeFactor"), meanUs / (kFrameMs * 1000.0));
+    return result;
+}
+
+static int processFile(const QString& inputPath, const QString& outputPath, int level)
+{
+    QVector<qint16> samples;
+    int sampleRate = 0;
+    QString error;
+    if (!WavFile::readMono(inputPath, &samples, &sampleRate, &error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
+    NoiseSuppressor suppressor;
+    suppressor.configure(sampleRate);
+    suppressor.setLevel(level);
+    // Feed in capture-sized frames, then flush the latency so the output
+    // lines up sample-for-sample with the input.
+    const int latency = suppressor.latencySamples();
+    samples.resize(samples.size() + latency);
+    const int frameSamples = sampleRate * kFrameMs / 1000;
+    for (int offset = 0; offset < samples.size(); offset += frameSamples)
+    {
+        const int count = qMin(frameSamples, static_cast<int>(samples.size()) - offset);
+        suppressor.process(QSpan<qint16>(samples.data() + offset, count));
+    }
+    samples.remove(0, latency);
+
+    if (!WavFile::writeMono(outputPath, samples, sampleRate, &error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    return 0;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("IncomUdonNoiseSuppressorBench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("IncomUdon noise suppressor benchmark"));
+    parser.addHelpOption();
+    const QCommandLineOption framesOption(QStringLiteral("frames"),
+                                          QStringLiteral("Measured 20 ms frames per case (default 2000)."),
+                                          QStringLiteral("count"),
+                                          QStringLiteral("2000"));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+                                          QStringLiteral("Unmeasured warm-up frames per case (default 100)."),
+                                          QStringLiteral("count"),
+                                          QStringLiteral("100"));
+    const QCommandLineOption levelOption(QStringLiteral("level"),
+                                         QStringLiteral("Suppression level 0-100 for file mode (default 45)."),
+                                         QStringLiteral("level"),
+                                         QStringLiteral("45"));
+    const QCommandLineOption inputOption(QStringLiteral("input"),
+                                         QStringLiteral("WAV file to filter instead of benchmarking."),
+                                         QStringLiteral("file"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("Filtered WAV in file mode, JSON otherwise (default stdout)."),
+                                          QStringLiteral("file"));
+    parser.addOption(framesOption);
+    parser.addOption(warmupOption);
+    parser.addOption(levelOption);
+    parser.addOption(inputOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const QString outputPath = parser.value(outputOption);
+    if (parser.isSet(inputOption))
+    {
+        if (outputPath.isEmpty())
+        {
+            std::fprintf(stderr, "--input requires --output\n");
+            return 1;
+        }
+        return processFile(parser.value(inputOption), outputPath, parser.value(levelOption).toInt());
+    }
+
+    const int frames = qMax(1, parser.value(framesOption).toInt());
+    const int warmupFrames = qMax(0, parser.value(warmupOption).toInt());
+
+    QJsonArray results;
+    for (int sampleRate : {8000, 16000, 48000})
+    {
+        for (int level : {25, 45, 80})
+            results.append(runCase(sampleRate, level, frames, warmupFrames));
+    }
+
+    QJsonObject root = ToolReport::header(QStringLiteral("incomudon_ns_bench"));
+    root.insert(QStringLiteral("frameMs"), kFrameMs);
+    root.insert(QStringLiteral("frames"), frames);
+    root.insert(QStringLiteral("warmupFrames"), warmupFrames);
+    root.insert(QStringLiteral("results"), results);
+
+    return ToolReport::write(root, outputPath);
+}
@@ -0,0 +1,27 @@
+// Wire-format checks for the TX packet path: PacketBuilder against
+// encrypt() + pack()/packLegacy(), and Proto::readHeader. Exits non-zero on
+// the first failing group so ctest reports it.
+
+#include <QCoreApplication>
+#include <cstdio>
+
+bool testPacketBuilder();
+bool testReadHeader();
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    bool ok = true;
+    if (!testPacketBuilder())
+    {
+        std::fprintf(stderr, "PacketBuilder output differs from pack()\n");
+        ok = false;
+    }
+    if (!testReadHeader())
+    {
+        std::fprintf(stderr, "readHeader checks failed\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
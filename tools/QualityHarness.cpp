@@ -0,0 +1,619 @@
+// End-to-end offline quality and latency harness. A reference WAV (or a
+// built-in speech-like signal) is framed at the codec rate as AudioInput
+// would, encoded with Codec2Wrapper, protected by FecEncoder, sealed by
+// PacketBuilder with AeadCipher/Packetizer, passed through a seeded
+// NetworkImpairment link and received by ChannelManager, which buffers,
+// repairs, decodes and mixes it. Everything runs on one virtual clock, so a
+// build always yields the same audio. Reports latency, jitter buffer
+// delay, concealment, SNR against the reference and CPU per stage as JSON.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QVector>
+#include <QtEndian>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <numeric>
+
+#include "audio/AudioResampler.h"
+#include "codec/Codec2Wrapper.h"
+#include "core/ChannelManager.h"
+#include "crypto/AeadCipher.h"
+#include "crypto/KeyExchange.h"
+#include "net/Fec.h"
+#include "net/JitterBuffer.h"
+#include "net/NetworkImpairment.h"
+#include "net/PacketBuilder.h"
+#include "net/packet.h"
+#include "net/Packetizer.h"
+#include "net/udptransport.h"
+#include "tools/ToolReport.h"
+#include "tools/WavFile.h"
+
+namespace {
+constexpr quint32 kChannelId = 1;
+constexpr quint32 kTalkerId = 0x1001;
+constexpr quint16 kRelayPort = 50000;
+constexpr int kKeyTimeoutMs = 2000;
+constexpr int kReferenceRate = 16000;
+constexpr int kMaxLatencyMs = 1000;
+constexpr int kSegmentMs = 20;
+// Segmental SNR skips segments this far below the loudest one and clamps
+// each remaining segment to the usual range.
+constexpr double kSegmentFloorDb = -40.0;
+constexpr double kMinSegmentSnrDb = -10.0;
+constexpr double kMaxSegmentSnrDb = 35.0;
+
+struct Fidelity
+{
+    double snrDb = 0.0;
+    double segSnrDb = 0.0;
+};
+
+static QVector<qint16> makeReference(int sampleRate, int totalSamples)
+{
+    // Harmonic "syllables" of random length separated by random pauses,
+    // so the envelope never repeats and delay estimation stays unambiguous.
+    QVector<qint16> out(totalSamples, 0);
+    quint32 prng = 0x6d2b79f5u;
+    const auto nextRandom = [&prng]() {
+        prng = prng * 1664525u + 1013904223u;
+        return (prng >> 8) / 16777216.0;
+    };
+
+    double phase = 0.0;
+    int pos = sampleRate / 10;
+    while (pos < totalSamples)
+    {
+        const int length = static_cast<int>((0.08 + 0.22 * nextRandom()) * sampleRate);
+        const double basePitch = 100.0 + 80.0 * nextRandom();
+        for (int i = 0; i < length && pos + i < totalSamples; ++i)
+        {
+            const double t = static_cast<double>(i) / sampleRate;
+            phase += 2.0 * M_PI * (basePitch + 20.0 * qSin(2.0 * M_PI * 2.0 * t)) / sampleRate;
+            double voiced = 0.0;
+            for (int h = 1; h <= 12; ++h)
+                voiced += qSin(phase * h) / h;
+            const double envelope = qSin(M_PI * i / length);
+            out[pos + i] = static_cast<qint16>(qBound(-32768, qRound(envelope * 0.45 * voiced * 12000.0), 32767));
+        }
+        pos += length + static_cast<int>((0.03 + 0.17 * nextRandom()) * sampleRate);
+    }
+    return out;
+}
+
+static QVector<qint16> resampled(const QVector<qint16>& in, int inRate, int outRate)
+{
+    if (inRate == outRate)
+        return in;
+    AudioResampler resampler;
+    resampler.setRates(inRate, outRate);
+    QVector<qint16> out;
+    out.reserve(static_cast<qsizetype>(static_cast<qint64>(in.size()) * outRate / inRate + 64));
+    resampler.push(in, out);
+    return out;
+}
+
+static QVector<double> blockEnvelope(const QVector<qint16>& samples, int block)
+{
+    QVector<double> out(samples.size() / block);
+    for (qsizetype b = 0; b < out.size(); ++b)
+    {
+        double sum = 0.0;
+        for (int i = 0; i < block; ++i)
+            sum += qAbs(static_cast<double>(samples.at(b * block + i)));
+        out[b] = sum / block;
+    }
+    const double mean = out.isEmpty() ? 0.0 : std::accumulate(out.cbegin(), out.cend(), 0.0) / out.size();
+    for (double& value : out)
+        value -= mean;
+    return out;
+}
+
+// Delay of output behind reference in samples, or -1. Vocoders do not
+// preserve the waveform, so the search runs on 1 ms envelopes first and
+// only the final refinement looks at samples.
+static int estimateLag(const QVector<qint16>& reference, const QVector<qint16>& output, int sampleRate)
+{
+    const int block = qMax(1, sampleRate / 1000);
+    const QVector<double> refEnvelope = blockEnvelope(reference, block);
+    const QVector<double> outEnvelope = blockEnvelope(output, block);
+
+    int bestBlocks = -1;
+    double best = 0.0;
+    for (int lag = 0; lag <= kMaxLatencyMs && lag < outEnvelope.size(); ++lag)
+    {
+        const qsizetype count = qMin(refEnvelope.size(), outEnvelope.size() - lag);
+        double sum = 0.0;
+        for (qsizetype i = 0; i < count; ++i)
+            sum += refEnvelope.at(i) * outEnvelope.at(i + lag);
+        if (sum > best)
+        {
+            best = sum;
+            bestBlocks = lag;
+        }
+    }
+    if (bestBlocks < 0)
+        return -1;
+
+    int bestLag = bestBlocks * block;
+    double bestWave = -1.0;
+    for (int lag = qMax(0, (bestBlocks - 1) * block); lag <= (bestBlocks + 1) * block; ++lag)
+    {
+        const qsizetype count = qMin(reference.size(), output.size() - lag);
+        double sum = 0.0;
+        for (qsizetype i = 0; i < count; ++i)
+            sum += static_cast<double>(reference.at(i)) * output.at(i + lag);
+        if (sum > bestWave)
+        {
+            bestWave = sum;
+            bestLag = lag;
+        }
+    }
+    return bestLag;
+}
+
+static Fidelity compare(const QVector<qint16>& reference, const QVector<qint16>& output, int lag, int sampleRate)
+{
+    Fidelity result;
+    const qsizetype count = qMin(reference.size(), output.size() - qMax(0, lag));
+    if (lag < 0 || count <= 0)
+        return result;
+
+    const int segment = sampleRate * kSegmentMs / 1000;
+    QVector<double> signalEnergy;
+    QVector<double> errorEnergy;
+    double signalTotal = 0.0;
+    double errorTotal = 0.0;
+    for (qsizetype start = 0; start + segment <= count; start += segment)
+    {
+        double signal = 0.0;
+        double error = 0.0;
+        for (int i = 0; i < segment; ++i)
+        {
+            const double ref = reference.at(start + i);
+            const double diff = output.at(start + i + lag) - ref;
+            signal += ref * ref;
+            error += diff * diff;
+        }
+        signalEnergy.append(signal);
+        errorEnergy.append(error);
+        signalTotal += signal;
+        errorTotal += error;
+    }
+    if (signalEnergy.isEmpty())
+        return result;
+
+    result.snrDb = 10.0 * std::log10(qMax(signalTotal, 1.0) / qMax(errorTotal, 1.0));
+    const double floor = *std::max_element(signalEnergy.cbegin(), signalEnergy.cend()) * qPow(10.0, kSegmentFloorDb / 10.0);
+    double segmentSum = 0.0;
+    int segments = 0;
+    for (qsizetype i = 0; i < signalEnergy.size(); ++i)
+    {
+        if (signalEnergy.at(i) < floor)
+            continue;
+        const double snr = 10.0 * std::log10(signalEnergy.at(i) / qMax(errorEnergy.at(i), 1.0));
+        segmentSum += qBound(kMinSegmentSnrDb, snr, kMaxSegmentSnrDb);
+        ++segments;
+    }
+    result.segSnrDb = segments > 0 ? segmentSum / segments : 0.0;
+    return result;
+}
+
+static QJsonObject fidelityJson(const Fidelity& fidelity)
+{
+    QJsonObject out;
+    out.insert(QStringLiteral("snrDb"), fidelity.snrDb);
+    out.insert(QStringLiteral("segSnrDb"), fidelity.segSnrDb);
+    return out;
+}
+
+static void startKeyExchange(KeyExchange& keys, AeadCipher& cipher)
+{
+    QObject::connect(&keys, &KeyExchange::sessionKeyReady,
+                     &cipher, [&cipher](const QByteArray& key,
+                                        const QByteArray& nonceBase,
+                                        KeyExchange::CryptoMode mode) {
+        cipher.setKey(key, nonceBase);
+        const bool legacy = (mode == KeyExchange::CryptoMode::LegacyXor);
+        cipher.setMode(legacy ? AeadCipher::Mode::LegacyXor
+                              : AeadCipher::Mode::AesGcm);
+    });
+    keys.setChannelId(kChannelId);
+    keys.setPassword(QStringLiteral("quality-harness"));
+    keys.startHandshake();
+}
+
+static void configureCodec(Codec2Wrapper& codec,
+                           const QString& codec2Path,
+                           const QString& opusPath,
+                           bool opus,
+                           int mode)
+{
+    codec.setCodec2LibraryPath(codec2Path);
+    codec.setOpusLibraryPath(opusPath);
+    codec.setCodecType(opus ? Codec2Wrapper::CodecTypeOpus : Codec2Wrapper::CodecTypeCodec2);
+    if (mode > 0)
+        codec.setMode(mode);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName(QStringLiteral("FriedOudon"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("friedoudon.com"));
+    QCoreApplication::setApplicationName(QStringLiteral("IncomUdonQualityHarness"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("IncomUdon end-to-end quality and latency harness"));
+    parser.addHelpOption();
+    const QCommandLineOption inputOption(QStringLiteral("input"),
+                                         QStringLiteral("Reference WAV (default: built-in speech-like signal)."),
+                                         QStringLiteral("file"));
+    const QCommandLineOption secondsOption(QStringLiteral("seconds"),
+                                           QStringLiteral("Length of the built-in reference (default 10)."),
+                                           QStringLiteral("seconds"),
+                                           QStringLiteral("10"));
+    const QCommandLineOption codecOption(QStringLiteral("codec"),
+                                         QStringLiteral("codec2 or opus (default codec2)."),
+                                         QStringLiteral("name"),
+                                         QStringLiteral("codec2"));
+    const QCommandLineOption modeOption(QStringLiteral("mode"),
+                                        QStringLiteral("Codec mode or bitrate (default: the codec's default)."),
+                                        QStringLiteral("mode"));
+    const QCommandLineOption noFecOption(QStringLiteral("no-fec"),
+                                         QStringLiteral("Send no FEC parity."));
+    const QCommandLineOption netemOption(QStringLiteral("netem"),
+                                         QStringLiteral("Link impairment (INCOMUDON_NETEM format, tx side)."),
+                                         QStringLiteral("spec"));
+    const QCommandLineOption tailOption(QStringLiteral("tail-ms"),
+                                        QStringLiteral("Playout after the talk release (default 500)."),
+                                        QStringLiteral("ms"),
+                                        QStringLiteral("500"));
+    const QCommandLineOption codec2Option(QStringLiteral("codec2-lib"),
+                                          QStringLiteral("Path to the codec2 runtime library."),
+                                          QStringLiteral("path"));
+    const QCommandLineOption opusOption(QStringLiteral("opus-lib"),
+                                        QStringLiteral("Path to the opus runtime library."),
+                                        QStringLiteral("path"));
+    const QCommandLineOption wavOption(QStringLiteral("wav"),
+                                       QStringLiteral("Write the received mix to this WAV."),
+                                       QStringLiteral("file"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("JSON report file (default stdout)."),
+                                          QStringLiteral("file"));
+    parser.addOption(inputOption);
+    parser.addOption(secondsOption);
+    parser.addOption(codecOption);
+    parser.addOption(modeOption);
+    parser.addOption(noFecOption);
+    parser.addOption(netemOption);
+    parser.addOption(tailOption);
+    parser.addOption(codec2Option);
+    parser.addOption(opusOption);
+    parser.addOption(wavOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    QString error;
+    QVector<qint16> reference;
+    int referenceRate = kReferenceRate;
+    if (parser.isSet(inputOption))
+    {
+        if (!WavFile::readMono(parser.value(inputOption), &reference, &referenceRate, &error))
+        {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 1;
+        }
+    }
+    else
+    {
+        reference = makeReference(referenceRate, qMax(1, parser.value(secondsOption).toInt()) * referenceRate);
+    }
+
+    NetworkImpairmentConfig linkConfig;
+    if (parser.isSet(netemOption) &&
+        !NetworkImpairmentConfig::parse(parser.value(netemOption), &linkConfig, nullptr, &error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
+    const bool opus = parser.value(codecOption).compare(QStringLiteral("opus"), Qt::CaseInsensitive) == 0;
+    const int mode = parser.value(modeOption).toInt();
+    const QString codec2Path = parser.value(codec2Option);
+    const QString opusPath = parser.value(opusOption);
+    Codec2Wrapper txCodec;
+    Codec2Wrapper rxCodec;
+    configureCodec(txCodec, codec2Path, opusPath, opus, mode);
+    configureCodec(rxCodec, codec2Path, opusPath, opus, mode);
+
+    const int codecRate = txCodec.sampleRate();
+    const int frameMs = qMax(1, txCodec.frameMs());
+    const int codecFrameSamples = txCodec.pcmFrameBytes() / static_cast<int>(sizeof(qint16));
+    const qint64 frameUs = static_cast<qint64>(frameMs) * 1000;
+
+    // Sender and receiver derive the same room key from the password, as
+    // two clients in one channel do.
+    AeadCipher txCipher;
+    AeadCipher rxCipher;
+    KeyExchange txKeys;
+    KeyExchange rxKeys;
+    startKeyExchange(txKeys, txCipher);
+    startKeyExchange(rxKeys, rxCipher);
+    QElapsedTimer keyTimer;
+    keyTimer.start();
+    while ((!txCipher.isReady() || !rxCipher.isReady()) && keyTimer.elapsed() < kKeyTimeoutMs)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    if (!txCipher.isReady() || !rxCipher.isReady())
+    {
+        std::fprintf(stderr, "No session key\n");
+        return 1;
+    }
+
+    Packetizer txPacketizer;
+    txPacketizer.setChannelId(kChannelId);
+    txPacketizer.setSenderId(kTalkerId);
+    txPacketizer.setKeyId(txCipher.keyId());
+    Packetizer relayPacketizer;
+    relayPacketizer.setChannelId(kChannelId);
+    relayPacketizer.setSenderId(0);
+    Packetizer rxPacketizer;
+
+    // The transport is never bound; ChannelManager only sees datagrams
+    // injected from the simulated link, and its own sends go nowhere.
+    UdpTransport transport;
+    JitterBuffer jitter;
+    ChannelManager manager;
+    manager.setTransport(&transport);
+    manager.setPacketizer(&rxPacketizer);
+    manager.setCipher(&rxCipher);
+    manager.setJitterBuffer(&jitter);
+    manager.setCodec(&rxCodec);
+    manager.setFecEnabled(true);
+    ChannelConfig channel;
+    channel.channelId = kChannelId;
+    manager.joinChannel(channel);
+
+    const int mixFrameSamples = manager.playoutFrameSamples();
+    const int mixRate = mixFrameSamples * 1000 / frameMs;
+    const QHostAddress relayAddress(QHostAddress::LocalHost);
+
+    QVector<qint64> framingNanos;
+    QVector<qint64> encodeNanos;
+    QVector<qint64> fecNanos;
+    QVector<qint64> sealNanos;
+    QVector<qint64> networkNanos;
+    QVector<qint64> receiveNanos;
+    QVector<qint64> playoutNanos;
+    QElapsedTimer stage;
+
+    // AudioInput-equivalent framing: the capture is converted to the codec
+    // rate and cut into codec frames.
+    stage.start();
+    const QVector<qint16> txInput = resampled(reference, referenceRate, codecRate);
+    framingNanos.append(stage.nsecsElapsed());
+    const QVector<qint16> referenceMix = resampled(reference, referenceRate, mixRate);
+    const int frames = static_cast<int>(txInput.size() / qMax(1, codecFrameSamples));
+
+    // Codec only, frame i placed at i * frameMs: the codec's own delay.
+    QVector<quint8> encoded(qMax(1, txCodec.maxEncodedFrameBytes()));
+    QVector<qint16> decoded(codecFrameSamples);
+    QVector<qint16> codecOnly;
+    {
+        Codec2Wrapper referenceEncoder;
+        Codec2Wrapper referenceDecoder;
+        configureCodec(referenceEncoder, codec2Path, opusPath, opus, mode);
+        configureCodec(referenceDecoder, codec2Path, opusPath, opus, mode);
+        AudioResampler toMix;
+        toMix.setRates(codecRate, mixRate);
+        for (int i = 0; i < frames; ++i)
+        {
+            const QSpan<const qint16> pcm(txInput.constData() + static_cast<qsizetype>(i) * codecFrameSamples, codecFrameSamples);
+            const int bytes = referenceEncoder.encode(pcm, QSpan<quint8>(encoded));
+            const int samples = referenceDecoder.decode(QSpan<const quint8>(encoded.constData(), qMax(0, bytes)),
+                                                        QSpan<qint16>(decoded));
+            std::fill(decoded.begin() + qMax(0, samples), decoded.end(), qint16(0));
+            toMix.push(decoded, codecOnly);
+        }
+    }
+
+    const auto inject = [&transport, &relayAddress](const QByteArray& datagram) {
+        transport.injectDatagram(datagram, relayAddress, kRelayPort);
+    };
+    // What the relay and the talker send before audio: the talker's codec
+    // config and the grant.
+    {
+        QByteArray payload(4, 0);
+        const int codecId = txCodec.activeCodecTransportId();
+        payload[0] = static_cast<char>(codecId == Proto::CODEC_TRANSPORT_PCM ? 1 : 0);
+        payload[1] = static_cast<char>(codecId);
+        qToBigEndian(static_cast<quint16>(txCodec.mode()), reinterpret_cast<uchar*>(payload.data() + 2));
+        inject(txPacketizer.packPlain(Proto::PKT_CODEC_CONFIG, payload));
+        QByteArray talker(4, 0);
+        qToBigEndian<quint32>(kTalkerId, reinterpret_cast<uchar*>(talker.data()));
+        inject(relayPacketizer.packPlain(Proto::PKT_TALK_GRANT, talker));
+    }
+
+    FecEncoder fec;
+    fec.setEnabled(!parser.isSet(noFecOption));
+    PacketBuilder builder;
+    NetworkImpairment link(linkConfig);
+    std::multimap<qint64, QByteArray> inFlight;
+    quint64 datagramsSent = 0;
+    quint64 audioDelivered = 0;
+    qint64 audioDelayUsTotal = 0;
+    quint16 audioSeq = 0;
+
+    const auto sendFrame = [&](int index, qint64 nowUs) {
+        const QSpan<const qint16> pcm(txInput.constData() + static_cast<qsizetype>(index) * codecFrameSamples, codecFrameSamples);
+        stage.start();
+        const int bytes = txCodec.encode(pcm, QSpan<quint8>(encoded));
+        encodeNanos.append(stage.nsecsElapsed());
+        if (bytes <= 0)
+            return;
+        const QSpan<const quint8> codecFrame(encoded.constData(), bytes);
+
+        stage.start();
+        builder.buildAudio(txPacketizer, txCipher, audioSeq, codecFrame);
+        sealNanos.append(stage.nsecsElapsed());
+        stage.start();
+        const bool parityReady = fec.addFrame(audioSeq, codecFrame);
+        fecNanos.append(stage.nsecsElapsed());
+        if (parityReady)
+        {
+            stage.start();
+            for (int i = 0; i < FecEncoder::kParityPackets; ++i)
+            {
+                builder.buildFec(txPacketizer,
+                                 txCipher,
+                                 fec.completedBlockStart(),
+                                 static_cast<quint8>(fec.blockSize()),
+                                 static_cast<quint8>(i),
+                                 fec.parity(i));
+            }
+            sealNanos.append(stage.nsecsElapsed());
+        }
+        audioSeq++;
+
+        const QSpan<const QByteArrayView> packets = builder.packets();
+        for (qsizetype p = 0; p < packets.size(); ++p)
+        {
+            qint64 releaseUs[NetworkImpairment::kMaxCopies];
+            stage.start();
+            const int copies = link.offer(nowUs, static_cast<int>(packets[p].size()), releaseUs);
+            networkNanos.append(stage.nsecsElapsed());
+            for (int c = 0; c < copies; ++c)
+            {
+                inFlight.emplace(releaseUs[c], packets[p].toByteArray());
+                if (p == 0 && c == 0)
+                {
+                    ++audioDelivered;
+                    audioDelayUsTotal += releaseUs[c] - nowUs;
+                }
+            }
+            ++datagramsSent;
+        }
+        builder.clear();
+    };
+
+    // Frame i is complete, and sent, at (i + 1) * frameMs; output sample n
+    // plays at n / mixRate, so the lag found below is mouth-to-ear.
+    const qint64 tailUs = static_cast<qint64>(qMax(0, parser.value(tailOption).toInt())) * 1000;
+    qint64 releaseUs = -1;
+    QVector<qint16> output;
+    output.reserve(static_cast<qsizetype>(frames + 64) * mixFrameSamples);
+    QVector<qint16> mixFrame(mixFrameSamples);
+    for (qint64 tick = 0;; ++tick)
+    {
+        const qint64 nowUs = tick * frameUs;
+        if (tick >= 1 && tick <= frames)
+            sendFrame(static_cast<int>(tick - 1), nowUs);
+        if (tick == frames)
+        {
+            // The talker's PTT_OFF reaches listeners as a release once all
+            // of its audio is through.
+            releaseUs = qMax(nowUs, inFlight.empty() ? nowUs : inFlight.rbegin()->first) + 1;
+            QByteArray talker(4, 0);
+            qToBigEndian<quint32>(kTalkerId, reinterpret_cast<uchar*>(talker.data()));
+            inFlight.emplace(releaseUs, relayPacketizer.packPlain(Proto::PKT_TALK_RELEASE, talker));
+        }
+
+        while (!inFlight.empty() && inFlight.begin()->first <= nowUs)
+        {
+            stage.start();
+            inject(inFlight.begin()->second);
+            receiveNanos.append(stage.nsecsElapsed());
+            inFlight.erase(inFlight.begin());
+        }
+
+        stage.start();
+        manager.renderPlayout(mixFrame);
+        playoutNanos.append(stage.nsecsElapsed());
+        output.append(mixFrame);
+
+        if (releaseUs >= 0 && inFlight.empty() && nowUs >= releaseUs + tailUs)
+            break;
+    }
+
+    if (parser.isSet(wavOption) && !WavFile::writeMono(parser.value(wavOption), output, mixRate, &error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
+    const int totalLag = estimateLag(referenceMix, output, mixRate);
+    const int codecLag = estimateLag(referenceMix, codecOnly, mixRate);
+    const PlayoutStats playout = manager.playoutStats();
+    const double toMs = 1000.0 / mixRate;
+
+    QJsonObject latency;
+    latency.insert(QStringLiteral("framingMs"), frameMs);
+    latency.insert(QStringLiteral("codecMs"), codecLag >= 0 ? codecLag * toMs : -1.0);
+    latency.insert(QStringLiteral("algorithmicMs"), codecLag >= 0 ? frameMs + codecLag * toMs : -1.0);
+    latency.insert(QStringLiteral("networkMs"), audioDelivered > 0 ? audioDelayUsTotal / 1000.0 / audioDelivered : 0.0);
+    latency.insert(QStringLiteral("jitterBufferMs"),
+                   playout.playedFrames > 0 ? playout.bufferedUsTotal / 1000.0 / playout.playedFrames : 0.0);
+    latency.insert(QStringLiteral("totalMs"), totalLag >= 0 ? totalLag * toMs : -1.0);
+
+    QJsonObject playoutJson;
+    playoutJson.insert(QStringLiteral("framesSent"), frames);
+    playoutJson.insert(QStringLiteral("decodedFrames"), static_cast<qint64>(playout.decodedFrames));
+    playoutJson.insert(QStringLiteral("playedFrames"), static_cast<qint64>(playout.playedFrames));
+    playoutJson.insert(QStringLiteral("concealedFrames"), static_cast<qint64>(playout.concealedFrames));
+    playoutJson.insert(QStringLiteral("fecRecoveredFrames"), static_cast<qint64>(playout.fecRecoveredFrames));
+    const quint64 playoutTicks = playout.playedFrames + playout.concealedFrames;
+    const double concealedRatio = playoutTicks > 0 ? static_cast<double>(playout.concealedFrames) / playoutTicks : 0.0;
+    playoutJson.insert(QStringLiteral("concealedRatio"), concealedRatio);
+
+    const NetworkImpairmentStats linkStats = link.stats();
+    QJsonObject network;
+    network.insert(QStringLiteral("spec"), parser.value(netemOption));
+    network.insert(QStringLiteral("datagramsSent"), static_cast<qint64>(datagramsSent));
+    network.insert(QStringLiteral("lost"), static_cast<qint64>(linkStats.lost));
+    network.insert(QStringLiteral("queueDrops"), static_cast<qint64>(linkStats.queueDrops));
+    network.insert(QStringLiteral("duplicated"), static_cast<qint64>(linkStats.duplicated));
+    network.insert(QStringLiteral("reordered"), static_cast<qint64>(linkStats.reordered));
+
+    const Fidelity endToEnd = compare(referenceMix, output, totalLag, mixRate);
+    QJsonObject fidelity = fidelityJson(endToEnd);
+    fidelity.insert(QStringLiteral("codecOnly"), fidelityJson(compare(referenceMix, codecOnly, codecLag, mixRate)));
+
+    QJsonObject cpu;
+    cpu.insert(QStringLiteral("framing"), ToolReport::timingSummary(framingNanos));
+    cpu.insert(QStringLiteral("encode"), ToolReport::timingSummary(encodeNanos));
+    cpu.insert(QStringLiteral("fec"), ToolReport::timingSummary(fecNanos));
+    cpu.insert(QStringLiteral("encryptPack"), ToolReport::timingSummary(sealNanos));
+    cpu.insert(QStringLiteral("network"), ToolReport::timingSummary(networkNanos));
+    cpu.insert(QStringLiteral("receive"), ToolReport::timingSummary(receiveNanos));
+    cpu.insert(QStringLiteral("decodeMix"), ToolReport::timingSummary(playoutNanos));
+
+    QJsonObject root = ToolReport::header(QStringLiteral("incomudon_quality"));
+    root.insert(QStringLiteral("codec"), opus ? QStringLiteral("opus") : QStringLiteral("codec2"));
+    root.insert(QStringLiteral("codecTransportId"), txCodec.activeCodecTransportId());
+    root.insert(QStringLiteral("mode"), txCodec.mode());
+    root.insert(QStringLiteral("codecSampleRate"), codecRate);
+    root.insert(QStringLiteral("mixSampleRate"), mixRate);
+    root.insert(QStringLiteral("frameMs"), frameMs);
+    root.insert(QStringLiteral("fec"), fec.enabled());
+    root.insert(QStringLiteral("referenceSec"), static_cast<double>(reference.size()) / referenceRate);
+    // The per-build numbers to track.
+    root.insert(QStringLiteral("totalLatencyMs"), latency.value(QStringLiteral("totalMs")));
+    root.insert(QStringLiteral("concealedRatio"), concealedRatio);
+    root.insert(QStringLiteral("segSnrDb"), endToEnd.segSnrDb);
+    root.insert(QStringLiteral("latency"), latency);
+    root.insert(QStringLiteral("playout"), playoutJson);
+    root.insert(QStringLiteral("network"), network);
+    root.insert(QStringLiteral("fidelity"), fidelity);
+    root.insert(QStringLiteral("cpu"), cpu);
+
+    return ToolReport::write(root, parser.value(outputOption));
+}
@@ -0,0 +1,62 @@
+#include "ToolReport.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <algorithm>
+#include <cstdio>
+
+namespace ToolReport
+{
+QJsonObject header(const QString& tool)
+{
+    QJsonObject root;
+    root.insert(QStringLiteral("tool"), tool);
+    root.insert(QStringLiteral("schema"), 1);
+    root.insert(QStringLiteral("product"), QSysInfo::prettyProductName());
+    root.insert(QStringLiteral("cpuArch"), QSysInfo::currentCpuArchitecture());
+    return root;
+}
+
+QJsonObject timingSummary(QVector<qint64> nanos)
+{
+    QJsonObject result;
+    result.insert(QStringLiteral("count"), static_cast<int>(nanos.size()));
+    if (nanos.isEmpty())
+        return result;
+
+    std::sort(nanos.begin(), nanos.end());
+    qint64 total = 0;
+    for (qint64 value : std::as_const(nanos))
+        total += value;
+    const auto percentile = [&nanos](double p) {
+        const int idx = qBound(0, static_cast<int>(p * (nanos.size() - 1) + 0.5), static_cast<int>(nanos.size()) - 1);
+        return nanos.at(idx) / 1000.0;
+    };
+    result.insert(QStringLiteral("p50Us"), percentile(0.50));
+    result.insert(QStringLiteral("p99Us"), percentile(0.99));
+    result.insert(QStringLiteral("maxUs"), nanos.constLast() / 1000.0);
+    result.insert(QStringLiteral("meanUs"), (static_cast<double>(total) / nanos.size()) / 1000.0);
+    result.insert(QStringLiteral("totalMs"), total / 1e6);
+    return result;
+}
+
+int write(const QJsonObject& root, const QString& outputPath)
+{
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (outputPath.isEmpty())
+    {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+        return 0;
+    }
+
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", qPrintable(outputPath));
+        return 1;
+    }
+    file.write(json);
+    return 0;
+}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// JSON report helpers shared by the offline tools and the relay load test.
+namespace ToolReport
+{
+// Report root with the fields every tool emits: tool, schema, product and
+// cpuArch.
+QJsonObject header(const QString& tool);
+// count, p50/p99/max/mean in microseconds and the total in milliseconds.
+QJsonObject timingSummary(QVector<qint64> nanos);
+// Writes the indented report to outputPath, or to stdout when it is empty.
+// Returns the process exit code.
+int write(const QJsonObject& root, const QString& outputPath);
+}
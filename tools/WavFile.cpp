@@ -0,0 +1,108 @@
+#include "WavFile.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+bool fail(QString* error, const QString& message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+}
+
+namespace WavFile
+{
+bool readMono(const QString& path, QVector<qint16>* samples, int* sampleRate, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(error, QStringLiteral("cannot open %1").arg(path));
+
+    const QByteArray data = file.readAll();
+    const uchar* bytes = reinterpret_cast<const uchar*>(data.constData());
+    if (data.size() < 12 || std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0)
+        return fail(error, QStringLiteral("%1 is not a RIFF/WAVE file").arg(path));
+
+    int format = 0;
+    int channels = 0;
+    int rate = 0;
+    int bits = 0;
+    qsizetype pos = 12;
+    while (pos + 8 <= data.size())
+    {
+        const qsizetype chunkSize = qFromLittleEndian<quint32>(bytes + pos + 4);
+        const uchar* body = bytes + pos + 8;
+        const qsizetype available = qMin<qsizetype>(chunkSize, data.size() - pos - 8);
+        if (std::memcmp(bytes + pos, "fmt ", 4) == 0 && available >= 16)
+        {
+            format = qFromLittleEndian<quint16>(body);
+            channels = qFromLittleEndian<quint16>(body + 2);
+            rate = static_cast<int>(qFromLittleEndian<quint32>(body + 4));
+            bits = qFromLittleEndian<quint16>(body + 14);
+        }
+        else if (std::memcmp(bytes + pos, "data", 4) == 0)
+        {
+            const bool pcm16 = format == 1 && bits == 16;
+            const bool float32 = format == 3 && bits == 32;
+            if (channels <= 0 || rate <= 0 || (!pcm16 && !float32))
+                return fail(error, QStringLiteral("%1: only 16-bit PCM or 32-bit float WAV is supported").arg(path));
+
+            const int frameBytes = channels * bits / 8;
+            const int frames = static_cast<int>(available / frameBytes);
+            samples->resize(frames);
+            for (int i = 0; i < frames; ++i)
+            {
+                double sum = 0.0;
+                for (int ch = 0; ch < channels; ++ch)
+                {
+                    const uchar* sample = body + i * frameBytes + ch * (bits / 8);
+                    if (pcm16)
+                        sum += qFromLittleEndian<qint16>(sample);
+                    else
+                        sum += static_cast<double>(qFromLittleEndian<float>(sample)) * 32767.0;
+                }
+                (*samples)[i] = static_cast<qint16>(qBound(-32768.0, std::round(sum / channels), 32767.0));
+            }
+            *sampleRate = rate;
+            return true;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    return fail(error, QStringLiteral("%1 has no data chunk").arg(path));
+}
+
+bool writeMono(const QString& path, const QVector<qint16>& samples, int sampleRate, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return fail(error, QStringLiteral("cannot open %1 for writing").arg(path));
+
+    const quint32 dataBytes = static_cast<quint32>(samples.size()) * 2;
+    QByteArray header(44, 0);
+    uchar* h = reinterpret_cast<uchar*>(header.data());
+    std::memcpy(h, "RIFF", 4);
+    qToLittleEndian<quint32>(36 + dataBytes, h + 4);
+    std::memcpy(h + 8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(16, h + 16);
+    qToLittleEndian<quint16>(1, h + 20);
+    qToLittleEndian<quint16>(1, h + 22);
+    qToLittleEndian<quint32>(static_cast<quint32>(sampleRate), h + 24);
+    qToLittleEndian<quint32>(static_cast<quint32>(sampleRate) * 2, h + 28);
+    qToLittleEndian<quint16>(2, h + 32);
+    qToLittleEndian<quint16>(16, h + 34);
+    std::memcpy(h + 36, "data", 4);
+    qToLittleEndian<quint32>(dataBytes, h + 40);
+
+    QByteArray pcm(static_cast<qsizetype>(dataBytes), Qt::Uninitialized);
+    qToLittleEndian<qint16>(samples.constData(), samples.size(), pcm.data());
+    if (file.write(header) != header.size() || file.write(pcm) != pcm.size())
+        return fail(error, QStringLiteral("failed writing %1").arg(path));
+    return true;
+}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// Minimal WAV support for the offline tools: 16-bit PCM or 32-bit float in,
+// downmixed to mono int16; mono 16-bit PCM out.
+namespace WavFile
+{
+bool readMono(const QString& path, QVector<qint16>* samples, int* sampleRate, QString* error);
+bool writeMono(const QString& path, const QVector<qint16>& samples, int sampleRate, QString* error);
+}
@@ -523,6 +523,7 @@ Window {
             property int micVolumePercent: 200
             property bool noiseSuppressionEnabled: false
             property int noiseSuppressionLevel: 45
+            property bool voiceActivityDetectionEnabled: false
             property int speakerVolumePercent: 100
             property bool keepMicSessionAlwaysOn: false
             property int cueVolumePercent: 50
@@ -580,6 +581,7 @@ Window {
             appState.micVolumePercent = root.clampInt(persisted.micVolumePercent, 0, 300, 200)
             appState.noiseSuppressionEnabled = persisted.noiseSuppressionEnabled
             appState.noiseSuppressionLevel = root.clampInt(persisted.noiseSuppressionLevel, 0, 100, 45)
+            appState.voiceActivityDetectionEnabled = persisted.voiceActivityDetectionEnabled
             appState.speakerVolumePercent = root.clampInt(persisted.speakerVolumePercent, 0, 400, 100)
             appState.keepMicSessionAlwaysOn = persisted.keepMicSessionAlwaysOn
             root.cueVolumePercent = root.clampInt(persisted.cueVolumePercent, 0, 100, 50)
@@ -654,6 +656,7 @@ Window {
             function onMicVolumePercentChanged() { persisted.micVolumePercent = appState.micVolumePercent }
             function onNoiseSuppressionEnabledChanged() { persisted.noiseSuppressionEnabled = appState.noiseSuppressionEnabled }
             function onNoiseSuppressionLevelChanged() { persisted.noiseSuppressionLevel = appState.noiseSuppressionLevel }
+            function onVoiceActivityDetectionEnabledChanged() { persisted.voiceActivityDetectionEnabled = appState.voiceActivityDetectionEnabled }
             function onSpeakerVolumePercentChanged() { persisted.speakerVolumePercent = appState.speakerVolumePercent }
             function onKeepMicSessionAlwaysOnChanged() { persisted.keepMicSessionAlwaysOn = appState.keepMicSessionAlwaysOn }
             function onCodec2LibraryPathChanged() {
@@ -1957,6 +1960,60 @@ Window {
                                 font.pixelSize: 12
                             }
 
+                            Text {
+                                text: qsTr("Voice Activity Detection")
+                                color: "#90a4ae"
+                                font.pixelSize: 13
+                            }
+
+                            Row {
+                                spacing: 8
+
+                                Rectangle {
+                                    width: 100
+                                    height: 28
+                                    radius: 6
+                                    color: !appState.voiceActivityDetectionEnabled ? "#4db6ac" : "#1a222b"
+                                    border.color: "#263238"
+                                    border.width: 1
+
+                                    Text {
+                                        anchors.centerIn: parent
+                                        text: qsTr("Off")
+                                        color: !appState.voiceActivityDetectionEnabled ? "#0b0f13" : "#cfd8dc"
+                                        font.pixelSize: 14
+                                    }
+
+                                    TapHandler { onTapped: appState.voiceActivityDetectionEnabled = false }
+                                }
+
+                                Rectangle {
+                                    width: 100
+                                    height: 28
+                                    radius: 6
+                                    color: appState.voiceActivityDetectionEnabled ? "#4db6ac" : "#1a222b"
+                                    border.color: "#263238"
+                                    border.width: 1
+
+                                    Text {
+                                        anchors.centerIn: parent
+                                        text: qsTr("On")
+                                        color: appState.voiceActivityDetectionEnabled ? "#0b0f13" : "#cfd8dc"
+                                        font.pixelSize: 14
+                                    }
+
+                                    TapHandler { onTapped: appState.voiceActivityDetectionEnabled = true }
+                                }
+                            }
+
+                            Text {
+                                text: appState.voiceActivityDetectionEnabled ?
+                                          qsTr("Pauses are not sent while PTT is held; listeners hear comfort noise instead.") :
+                                          qsTr("Every frame is sent while PTT is held.")
+                                color: "#607d8b"
+                                font.pixelSize: 12
+                            }
+
                         Text {
                             text: qsTr("TX FEC (RS 2-loss)")
                             color: "#90a4ae"